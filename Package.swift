@@ -44,6 +44,13 @@ let package = Package(
                     "HaishinKit"
                 ],
                 path: "SRTHaishinKit"
-        )
+        ),
+        .testTarget(name: "HaishinKitTests",
+                    dependencies: ["HaishinKit"],
+                    path: "Tests",
+                    sources: [
+                        "Media/ChoreographerTests.swift",
+                        "Media/JitterBufferTests.swift"
+                    ])
     ]
 )
@@ -0,0 +1,135 @@
+import Foundation
+import HaishinKit
+import libsrt
+
+/// The SRTAcceptor class accepts incoming connections of a listener on its own thread, so that a burst of new callers never waits behind status polling or data of existing connections.
+final class SRTAcceptor {
+    private static let timeout: Int64 = 100
+    /// The nanoseconds after which a handshake that was never accepted is forgotten.
+    private static let handshakeTimeout: UInt64 = 10_000_000_000
+
+    /// The histogram of milliseconds from the conclusion handshake to handing an accepted socket to the handler.
+    var handshakeLatency: Histogram {
+        lockQueue.sync { histogram }
+    }
+
+    private let socket: SRTSOCKET
+    private let handler: (SRTSOCKET) -> Void
+    private let errorHandler: (SRTError) -> Void
+    private var eid: Int32 = SRT_ERROR
+    private var isRunning: Atomic<Bool> = .init(false)
+    private var histogram = Histogram()
+    private var handshakedAt = SRTSocketTable<UInt64>()
+    private var expiredAt: UInt64 = 0
+    /// The retained context of the listen callback, which libsrt may still call while the acceptor stops.
+    private var context: Unmanaged<SRTAcceptor>?
+    private let lockQueue = DispatchQueue(label: "com.haishinkit.SRTHaishinKit.SRTAcceptor.lock")
+
+    /// Creates a new acceptor. The error handler is called when the listener fails, after which the acceptor has stopped.
+    init(socket: SRTSOCKET, handler: @escaping (SRTSOCKET) -> Void, errorHandler: @escaping (SRTError) -> Void) {
+        self.socket = socket
+        self.handler = handler
+        self.errorHandler = errorHandler
+    }
+
+    /// Starts waiting for connections. The listener must be non-blocking.
+    func start() -> Bool {
+        guard !isRunning.value else {
+            return true
+        }
+        eid = srt_epoll_create()
+        guard 0 <= eid else {
+            return false
+        }
+        var events = Int32(SRT_EPOLL_IN.rawValue | SRT_EPOLL_ERR.rawValue)
+        guard srt_epoll_add_usock(eid, socket, &events) != SRT_ERROR else {
+            srt_epoll_release(eid)
+            return false
+        }
+        let context = self.context ?? Unmanaged.passRetained(self)
+        self.context = context
+        _ = srt_listen_callback(socket, { opaque, socket, _, _, _ in
+            guard let opaque else {
+                return 0
+            }
+            Unmanaged<SRTAcceptor>.fromOpaque(opaque).takeUnretainedValue().handshake(socket)
+            return 0
+        }, context.toOpaque())
+        isRunning.mutate { $0 = true }
+        let eid = self.eid
+        let thread = Thread {
+            self.run(eid)
+        }
+        thread.name = "com.haishinkit.SRTHaishinKit.SRTAcceptor"
+        thread.qualityOfService = .userInitiated
+        thread.start()
+        return true
+    }
+
+    /// Stops waiting for connections. It must be called before closing the listener.
+    func stop() {
+        guard isRunning.value else {
+            return
+        }
+        _ = srt_listen_callback(socket, nil, nil)
+        isRunning.mutate { $0 = false }
+        lockQueue.sync {
+            handshakedAt.removeAll()
+        }
+    }
+
+    /// Releases the context of the listen callback. It must be called after stopping and closing the listener, when no callback can be in flight.
+    func release() {
+        context?.release()
+        context = nil
+    }
+
+    private func handshake(_ socket: SRTSOCKET) {
+        let now = DispatchTime.now().uptimeNanoseconds
+        lockQueue.sync {
+            // Callers may give up or be rejected after the handshake, so their entries would never be removed on accepting.
+            if Self.handshakeTimeout < now - min(now, expiredAt) {
+                handshakedAt.removeAll { _, time in Self.handshakeTimeout < now - min(now, time) }
+                expiredAt = now
+            }
+            handshakedAt[socket] = now
+        }
+    }
+
+    private func run(_ eid: Int32) {
+        var events = [SRT_EPOLL_EVENT](repeating: SRT_EPOLL_EVENT(), count: 1)
+        while isRunning.value {
+            guard 0 < srt_epoll_uwait(eid, &events, Int32(events.count), SRTAcceptor.timeout) else {
+                continue
+            }
+            if events[0].events & Int32(SRT_EPOLL_ERR.rawValue) != 0 {
+                let error = SRTError.illegalState(message: String(cString: srt_getlasterror_str()))
+                logger.error("the listener failed:", error)
+                _ = srt_listen_callback(socket, nil, nil)
+                isRunning.mutate { $0 = false }
+                lockQueue.sync {
+                    handshakedAt.removeAll()
+                }
+                errorHandler(error)
+                break
+            }
+            // Drains every pending connection. A non-blocking srt_accept returns SRT_INVALID_SOCK when empty.
+            repeat {
+                let client = srt_accept(socket, nil, nil)
+                guard client != SRT_INVALID_SOCK else {
+                    break
+                }
+                // Records before the handler, which may take a while to set up the connection.
+                let now = DispatchTime.now().uptimeNanoseconds
+                lockQueue.sync {
+                    if let time = handshakedAt[client] {
+                        histogram.record(Double(now - min(now, time)) / 1_000_000)
+                        handshakedAt[client] = nil
+                    }
+                }
+                handler(client)
+            } while isRunning.value
+        }
+        srt_epoll_release(eid)
+    }
+}
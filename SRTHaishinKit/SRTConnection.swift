@@ -1,36 +1,108 @@
 import Foundation
+import HaishinKit
 import libsrt
 
 /// The SRTConnection class create a two-way SRT connection.
 public final class SRTConnection: NSObject {
     /// SRT Library version
     public static let version: String = SRT_VERSION_STRING
+    /// The default latency of libsrt in milliseconds.
+    static let defaultLatency = 120
     /// The URI passed to the SRTConnection.connect() method.
     public private(set) var uri: URL?
     /// This instance connect to server(true) or not(false)
-    @objc public private(set) dynamic var connected = false
+    @objc public private(set) dynamic var connected = false {
+        didSet {
+            connectedGauge.mutate { $0 = connected }
+        }
+    }
+    /// Specifies whether playback sockets receive on the shared SRTPoller threads instead of a dedicated blocking thread each.
+    /// Along with the status timers, which park no thread, it keeps the thread count fixed when a process plays many SRT streams.
+    public var usesSharedPoller = false
+    /// Specifies the bit rate in bits per second to pace outgoing packets at, to spread keyframe bursts. 0 disables pacing.
+    public var pacingBitRate: Int = 0 {
+        didSet {
+            socket?.pacingBitRate = pacingBitRate
+        }
+    }
+    /// The histogram of outgoing inter-packet gaps in microseconds while pacing.
+    public var pacingGaps: Histogram? {
+        socket?.pacingGaps
+    }
+    /// The total nanoseconds spent spinning for the final microseconds before paced packets, which costs CPU.
+    public var pacingSpinTime: UInt64? {
+        socket?.pacingSpinTime
+    }
+    /// Specifies the maximum number of pending connections of a listener.
+    public var backlog = 1
+    /// The histogram of milliseconds from the conclusion handshake to accepting a connection, while listening.
+    public var handshakeLatency: Histogram? {
+        socket?.handshakeLatency
+    }
+    /// Specifies the expected bit rate in bits per second of a connection. If set, the receive buffers are sized for it instead of the libsrt defaults.
+    /// Accepted connections inherit the sizes of a listener.
+    public var expectedBitRate: Int = 0
+    /// The buffer memory held by the socket and the accepted connections.
+    public var memoryUsage: SRTMemoryUsage {
+        let clients = lockQueue.sync { self.clients }
+        return clients.reduce(socket?.memoryUsage() ?? .zero) { $0 + $1.memoryUsage() }
+    }
+
+    /// Specifies whether the streams drop encoded video frames that no other frame depends on.
+    public var dropsNonReferenceFrames = false {
+        didSet {
+            for stream in streams {
+                stream.dropsNonReferenceFrames = dropsNonReferenceFrames
+            }
+        }
+    }
+
+    /// Specifies the capture that records the SRT messages of the socket and the accepted connections.
+    public var capture: NetCapture? {
+        didSet {
+            socket?.capture = capture
+        }
+    }
+
+    /// Specifies the labels that identify the metrics of the connection, e.g. ["connection": "ingest1"].
+    public var metricsLabels: [String: String] {
+        get {
+            _metricsLabels.value
+        }
+        set {
+            _metricsLabels.mutate { $0 = newValue }
+        }
+    }
 
     var socket: SRTSocket<SRTConnection>? {
         didSet {
             socket?.delegate = self
+            let socket = self.socket
+            socketSnapshot.mutate { $0 = socket }
         }
     }
     var streams: [SRTStream] = []
     var clients: [SRTSocket<SRTConnection>] = []
+    private let lockQueue = DispatchQueue(label: "com.haishinkit.SRTHaishinKit.SRTConnection.lock")
+    /// The snapshots that collect(_:) reads, as a registry collects on its own thread.
+    private var connectedGauge: Atomic<Bool> = .init(false)
+    private var socketSnapshot: Atomic<SRTSocket<SRTConnection>?> = .init(nil)
+    private var _metricsLabels: Atomic<[String: String]> = .init([:])
 
     /// The SRT's performance data.
     public var performanceData: SRTPerformanceData {
-        guard let socket else {
+        guard let mon = socket?.bstats() else {
             return .zero
         }
-        _ = socket.bstats()
-        return SRTPerformanceData(mon: socket.perf)
+        return SRTPerformanceData(mon: mon)
     }
 
     /// Creates a new SRTConnection.
     override public init() {
         super.init()
         srt_startup()
+        MemoryAccountant.shared.register(self, owner: self)
+        MetricsRegistry.shared.register(self)
     }
 
     deinit {
@@ -44,14 +116,28 @@ public final class SRTConnection: NSObject {
             return
         }
         self.uri = uri
-        let options = SRTSocketOption.from(uri: uri)
+        var options = SRTSocketOption.from(uri: uri)
+        if 0 < expectedBitRate {
+            let latency = options[.latency].flatMap { Int(String(describing: $0)) } ?? SRTConnection.defaultLatency
+            options.merge(SRTSocketOption.makeBufferOptions(bitRate: expectedBitRate, latency: latency)) { current, _ in current }
+        }
         let addr = sockaddr_in(mode.host(host), port: UInt16(port))
         socket = .init()
+        socket?.usesSharedPoller = usesSharedPoller
+        socket?.backlog = Int32(backlog)
+        socket?.pacingBitRate = pacingBitRate
+        socket?.capture = capture
         ((try? socket?.open(addr, mode: mode, options: options)) as ()??)
     }
 
     /// Closes the connection from the server.
     public func close() {
+        let clients = lockQueue.sync {
+            defer {
+                self.clients.removeAll()
+            }
+            return self.clients
+        }
         for client in clients {
             client.close()
         }
@@ -59,7 +145,6 @@ public final class SRTConnection: NSObject {
             stream.close()
         }
         socket?.close()
-        clients.removeAll()
     }
 
     private func sockaddr_in(_ host: String, port: UInt16) -> sockaddr_in {
@@ -77,17 +162,80 @@ public final class SRTConnection: NSObject {
     }
 }
 
+extension SRTConnection: MemoryAccountable {
+    // MARK: MemoryAccountable
+    public var bufferedBytes: Int {
+        let memoryUsage = self.memoryUsage
+        return memoryUsage.sendBufferBytes + memoryUsage.pendingBytes
+    }
+
+    public func disconnect() {
+        close()
+    }
+}
+
+extension SRTConnection: MetricsCollectable {
+    // MARK: MetricsCollectable
+    public func collect(_ collector: MetricsCollector) {
+        let labels = metricsLabels
+        let socket = socketSnapshot.value
+        // The interval counters are left for the performanceData.
+        let data = socket?.bstats(clear: false).map { SRTPerformanceData(mon: $0) } ?? .zero
+        collector.gauge("haishinkit_srt_connection_connected", help: "Whether the connection is connected.", value: connectedGauge.value ? 1 : 0, labels: labels)
+        collector.gauge("haishinkit_srt_connection_clients", help: "The number of accepted connections while listening.", value: Double(lockQueue.sync { clients.count }), labels: labels)
+        collector.gauge("haishinkit_srt_rtt_seconds", help: "The smoothed round trip time.", value: data.msRTT / 1000, labels: labels)
+        collector.gauge("haishinkit_srt_bandwidth_bits_per_second", help: "The estimated bandwidth of the link.", value: data.mbpsBandwidth * 1_000_000, labels: labels)
+        collector.counter("haishinkit_srt_sent_bytes_total", help: "The bytes sent.", value: Double(data.byteSentTotal), labels: labels)
+        collector.counter("haishinkit_srt_received_bytes_total", help: "The bytes received.", value: Double(data.byteRecvTotal), labels: labels)
+        collector.counter("haishinkit_srt_retransmitted_packets_total", help: "The packets retransmitted.", value: Double(data.pktRetransTotal), labels: labels)
+        collector.counter("haishinkit_srt_sent_lost_packets_total", help: "The sent packets reported lost by the peer.", value: Double(data.pktSndLossTotal), labels: labels)
+        collector.counter("haishinkit_srt_received_lost_packets_total", help: "The received packets detected lost.", value: Double(data.pktRcvLossTotal), labels: labels)
+        collector.counter("haishinkit_srt_sent_dropped_packets_total", help: "The packets dropped before sending as too late.", value: Double(data.pktSndDropTotal), labels: labels)
+        collector.counter("haishinkit_srt_received_dropped_packets_total", help: "The packets dropped before playing as too late.", value: Double(data.pktRcvDropTotal), labels: labels)
+        collector.gauge("haishinkit_srt_send_buffer_packets", help: "The packets in the send buffer.", value: Double(data.pktSndBuf), labels: labels)
+        collector.gauge("haishinkit_srt_receive_buffer_packets", help: "The packets in the receive buffer.", value: Double(data.pktRcvBuf), labels: labels)
+        if let pacingGaps = socket?.pacingGaps {
+            collector.histogram("haishinkit_srt_pacing_gap_seconds", help: "The gaps between outgoing packets while pacing.", histogram: pacingGaps, scale: 0.000001, labels: labels)
+        }
+        if let pacingSpinTime = socket?.pacingSpinTime {
+            collector.counter("haishinkit_srt_pacing_spin_seconds_total", help: "The time spent spinning before paced packets.", value: Double(pacingSpinTime) / 1_000_000_000, labels: labels)
+        }
+        if let handshakeLatency = socket?.handshakeLatency {
+            collector.histogram("haishinkit_srt_handshake_latency_seconds", help: "The time from the conclusion handshake to accepting a connection.", histogram: handshakeLatency, scale: 0.001, labels: labels)
+        }
+    }
+}
+
 extension SRTConnection: SRTSocketDelegate {
     // MARK: SRTSocketDelegate
     func socket(_ socket: SRTSocket<SRTConnection>, status: SRT_SOCKSTATUS) {
         connected = socket.status == SRTS_CONNECTED
+        switch status {
+        case SRTS_BROKEN, SRTS_CLOSED, SRTS_NONEXIST:
+            guard socket !== self.socket else {
+                break
+            }
+            lockQueue.async {
+                self.clients.removeAll { $0 === socket }
+            }
+        default:
+            break
+        }
     }
 
     func socket(_ socket: SRTSocket<SRTConnection>, incomingDataAvailabled data: Data, bytes: Int32) {
-        streams.first?.doInput(data.subdata(in: 0..<Data.Index(bytes)))
+        guard let stream = streams.first else {
+            return
+        }
+        stream.doInput(BufferPool.shared.makeData(count: Int(bytes)) { pointer in
+            data.copyBytes(to: pointer.bindMemory(to: UInt8.self), from: 0..<Int(bytes))
+        })
     }
 
     func socket(_ socket: SRTSocket<SRTConnection>, didAcceptSocket client: SRTSocket<SRTConnection>) {
-        clients.append(client)
+        client.capture = capture
+        lockQueue.async {
+            self.clients.append(client)
+        }
     }
 }
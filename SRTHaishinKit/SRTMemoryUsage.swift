@@ -0,0 +1,32 @@
+import Foundation
+
+/// The SRTMemoryUsage struct represents the buffer memory held by SRT sockets.
+public struct SRTMemoryUsage {
+    static let zero = SRTMemoryUsage(socketCount: 0, receiveBufferCapacity: 0, receiveBufferBytes: 0, sendBufferBytes: 0, pendingBytes: 0)
+
+    /// The number of sockets.
+    public let socketCount: Int
+    /// The reserved receive buffer capacity in bytes (SRTO_RCVBUF).
+    public let receiveBufferCapacity: Int
+    /// The bytes waiting in receive buffers.
+    public let receiveBufferBytes: Int
+    /// The bytes waiting in send buffers.
+    public let sendBufferBytes: Int
+    /// The bytes queued before srt_sendmsg2.
+    public let pendingBytes: Int
+
+    /// The average bytes held per connection.
+    public var bytesPerConnection: Int {
+        socketCount == 0 ? 0 : (receiveBufferCapacity + sendBufferBytes + pendingBytes) / socketCount
+    }
+
+    static func + (lhs: SRTMemoryUsage, rhs: SRTMemoryUsage) -> SRTMemoryUsage {
+        return SRTMemoryUsage(
+            socketCount: lhs.socketCount + rhs.socketCount,
+            receiveBufferCapacity: lhs.receiveBufferCapacity + rhs.receiveBufferCapacity,
+            receiveBufferBytes: lhs.receiveBufferBytes + rhs.receiveBufferBytes,
+            sendBufferBytes: lhs.sendBufferBytes + rhs.sendBufferBytes,
+            pendingBytes: lhs.pendingBytes + rhs.pendingBytes
+        )
+    }
+}
@@ -0,0 +1,72 @@
+import Foundation
+import HaishinKit
+
+/// The SRTPacer struct spaces outgoing packets at a target bit rate so that bursts such as keyframes don't flood the send buffer.
+///
+/// It sleeps on the monotonic clock until shortly before each deadline and spins only for the final microseconds.
+struct SRTPacer {
+    /// The statistics of a pacer.
+    struct Statistics {
+        /// The histogram of inter-packet gaps in microseconds.
+        var gaps = Histogram(bounds: SRTPacer.gapBounds)
+        /// The total nanoseconds spent spinning.
+        var spinTime: UInt64 = 0
+    }
+
+    /// The remaining time in nanoseconds to spin instead of sleeping.
+    static let spinThreshold: UInt64 = 50_000
+    /// The maximum credit in nanoseconds that an idle sender may spend as a burst.
+    static let maximumBurst: UInt64 = 5_000_000
+    /// The bucket bounds of the inter-packet gap histogram in microseconds.
+    static let gapBounds: [Double] = [10, 50, 100, 200, 500, 1000, 2000, 5000, 10000, 50000]
+
+    /// The target bit rate in bits per second.
+    let bitRate: Int
+    /// The total nanoseconds spent spinning.
+    private(set) var spinTime: UInt64 = 0
+    private var deadline: UInt64 = 0
+    private var lastSentAt: UInt64 = 0
+
+    init(bitRate: Int) {
+        self.bitRate = max(1, bitRate)
+    }
+
+    /// Waits until the next packet may be sent, and schedules the one after it. Returns the gap from the previous packet in microseconds.
+    @discardableResult
+    mutating func wait(_ byteCount: Int) -> Double? {
+        var now = Self.now()
+        if deadline + Self.maximumBurst < now {
+            deadline = now - min(now, Self.maximumBurst)
+        }
+        if now < deadline {
+            spinTime += Self.sleep(until: deadline)
+            now = Self.now()
+        }
+        let gap = 0 < lastSentAt ? Double(now - lastSentAt) / 1000 : nil
+        lastSentAt = now
+        deadline += UInt64(byteCount) * 8 * 1_000_000_000 / UInt64(bitRate)
+        return gap
+    }
+
+    /// Sleeps until the deadline in uptime nanoseconds. Returns the nanoseconds spent spinning.
+    @discardableResult
+    static func sleep(until deadline: UInt64) -> UInt64 {
+        let now = Self.now()
+        if now + spinThreshold < deadline {
+            var time = timespec(tv_sec: 0, tv_nsec: 0)
+            let duration = deadline - spinThreshold - now
+            time.tv_sec = Int(duration / 1_000_000_000)
+            time.tv_nsec = Int(duration % 1_000_000_000)
+            nanosleep(&time, nil)
+        }
+        let spunAt = Self.now()
+        while Self.now() < deadline {
+        }
+        return Self.now() - spunAt
+    }
+
+    @inline(__always)
+    static func now() -> UInt64 {
+        DispatchTime.now().uptimeNanoseconds
+    }
+}
@@ -230,6 +230,15 @@ public struct SRTPerformanceData {
     /// The packet reorder tolerance value
     public let pktReorderTolerance: Int32
 
+    /// The number of sent ACK packets per received data packet in the interval. It shows the receiver-side ACK overhead.
+    public var sentACKPerPacket: Double {
+        pktRecv == 0 ? 0 : Double(pktSentACK) / Double(pktRecv)
+    }
+    /// The number of received ACK packets per sent data packet in the interval. It shows the sender-side ACK overhead.
+    public var recvACKPerPacket: Double {
+        pktSent == 0 ? 0 : Double(pktRecvACK) / Double(pktSent)
+    }
+
     init(mon: CBytePerfMon) {
         self.msTimeStamp = mon.msTimeStamp
         self.pktSentTotal = mon.pktSentTotal
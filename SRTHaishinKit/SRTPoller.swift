@@ -0,0 +1,135 @@
+import Foundation
+import HaishinKit
+import libsrt
+
+protocol SRTPollable: AnyObject {
+    var socket: SRTSOCKET { get }
+
+    func poll(_ events: Int32)
+}
+
+/// The SRTPoller class receives data for many SRT sockets on a small fixed pool of threads with srt_epoll, instead of a blocking thread per socket.
+final class SRTPoller {
+    static let defaultThreadCount = 2
+    static let shared = SRTPoller(threadCount: SRTPoller.defaultThreadCount)
+
+    private static let timeout: Int64 = 100
+    private static let eventCapacity = 64
+
+    private final class Lane {
+        let eid: Int32
+        var targets = SRTSocketTable<WeakReference>()
+        var isRunning: Atomic<Bool> = .init(true)
+        /// Held while a batch of events is dispatched, so that removing a socket can wait for it.
+        let dispatching = DispatchSemaphore(value: 1)
+        weak var thread: Thread?
+
+        init(eid: Int32) {
+            self.eid = eid
+        }
+    }
+
+    private final class WeakReference {
+        weak var value: (any SRTPollable)?
+
+        init(_ value: any SRTPollable) {
+            self.value = value
+        }
+    }
+
+    /// The number of registered sockets.
+    var count: Int {
+        lockQueue.sync { lanes.reduce(0) { $0 + $1.targets.count } }
+    }
+
+    private var lanes: [Lane] = []
+    private let lockQueue = DispatchQueue(label: "com.haishinkit.SRTHaishinKit.SRTPoller.lock")
+
+    init(threadCount: Int) {
+        for i in 0..<max(1, threadCount) {
+            let eid = srt_epoll_create()
+            guard 0 <= eid else {
+                logger.error("srt_epoll_create failed:", String(cString: srt_getlasterror_str()))
+                continue
+            }
+            // Lanes without sockets keep waiting instead of failing.
+            _ = srt_epoll_set(eid, Int32(SRT_EPOLL_ENABLE_EMPTY.rawValue))
+            let lane = Lane(eid: eid)
+            lanes.append(lane)
+            let thread = Thread { [weak self] in
+                var events = [SRT_EPOLL_EVENT](repeating: SRT_EPOLL_EVENT(), count: SRTPoller.eventCapacity)
+                while lane.isRunning.value {
+                    // Holds the poller only for one wait, so that a released poller tears its threads down.
+                    guard let self = self else {
+                        break
+                    }
+                    self.poll(lane, events: &events)
+                }
+                srt_epoll_release(lane.eid)
+            }
+            thread.name = "com.haishinkit.SRTHaishinKit.SRTPoller.\(i)"
+            thread.qualityOfService = .userInitiated
+            lane.thread = thread
+            thread.start()
+        }
+    }
+
+    deinit {
+        for lane in lanes {
+            lane.isRunning.mutate { $0 = false }
+        }
+    }
+
+    /// Adds a socket to the lane that has the fewest sockets.
+    @discardableResult
+    func add(_ target: any SRTPollable) -> Bool {
+        lockQueue.sync {
+            guard let lane = lanes.min(by: { $0.targets.count < $1.targets.count }) else {
+                return false
+            }
+            var events = Int32(SRT_EPOLL_IN.rawValue | SRT_EPOLL_ERR.rawValue)
+            guard srt_epoll_add_usock(lane.eid, target.socket, &events) != SRT_ERROR else {
+                return false
+            }
+            lane.targets[target.socket] = WeakReference(target)
+            return true
+        }
+    }
+
+    /// Removes a socket. It returns after any dispatch in flight to the socket has finished, so that the caller may close it.
+    func remove(_ socket: SRTSOCKET) {
+        let lanes = lockQueue.sync {
+            self.lanes.filter { lane in
+                guard lane.targets[socket] != nil else {
+                    return false
+                }
+                _ = srt_epoll_remove_usock(lane.eid, socket)
+                lane.targets[socket] = nil
+                return true
+            }
+        }
+        // A socket removed from its own poll callback is already done with the batch.
+        for lane in lanes where lane.thread !== Thread.current {
+            lane.dispatching.wait()
+            lane.dispatching.signal()
+        }
+    }
+
+    private func poll(_ lane: Lane, events: inout [SRT_EPOLL_EVENT]) {
+        let count = srt_epoll_uwait(lane.eid, &events, Int32(events.count), SRTPoller.timeout)
+        guard 0 < count else {
+            return
+        }
+        lane.dispatching.wait()
+        defer {
+            lane.dispatching.signal()
+        }
+        // Resolves the whole batch with a single lock hop instead of one per event.
+        let targets = lockQueue.sync {
+            (0..<Int(count)).map { lane.targets[events[$0].fd]?.value }
+        }
+        for i in 0..<Int(count) {
+            targets[i]?.poll(events[i].events)
+        }
+    }
+}
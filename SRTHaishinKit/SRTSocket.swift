@@ -15,9 +15,35 @@ protocol SRTSocketDelegate: AnyObject {
 final class SRTSocket<T: SRTSocketDelegate> {
     var timeout: Int = 0
     var options: [SRTSocketOption: Any] = [:]
+    /// Specifies whether to receive on the shared SRTPoller threads instead of a dedicated blocking thread.
+    var usesSharedPoller = false
+    /// The maximum number of pending connections of a listener.
+    var backlog: Int32 = 1
+    /// Specifies the bit rate to pace outgoing packets at. 0 disables pacing.
+    var pacingBitRate: Int = 0 {
+        didSet {
+            outgoingQueue.async {
+                self.pacer = 0 < self.pacingBitRate ? SRTPacer(bitRate: self.pacingBitRate) : nil
+                self.statistics.mutate { $0 = self.pacer == nil ? nil : SRTPacer.Statistics() }
+            }
+        }
+    }
+    /// The histogram of outgoing inter-packet gaps in microseconds while pacing.
+    var pacingGaps: Histogram? {
+        statistics.value?.gaps
+    }
+    /// The total nanoseconds the pacer spent spinning.
+    var pacingSpinTime: UInt64? {
+        statistics.value?.spinTime
+    }
+    /// The histogram of milliseconds from the conclusion handshake to accepting a connection on a listener.
+    var handshakeLatency: Histogram? {
+        acceptor?.handshakeLatency
+    }
+    /// Specifies the capture that records the sent and received messages.
+    var capture: NetCapture?
     weak var delegate: T?
     private(set) var mode: SRTMode = .caller
-    private(set) var perf: CBytePerfMon = .init()
     private(set) var isRunning: Atomic<Bool> = .init(false)
     private(set) var socket: SRTSOCKET = SRT_INVALID_SOCK
     private(set) var status: SRT_SOCKSTATUS = SRTS_INIT {
@@ -46,6 +72,7 @@ final class SRTSocket<T: SRTSocketDelegate> {
                 stopRunning()
             case SRTS_NONEXIST:
                 logger.warn("SRT Socket Not Exist")
+                stopRunning()
             default:
                 break
             }
@@ -53,16 +80,26 @@ final class SRTSocket<T: SRTSocketDelegate> {
         }
     }
     private var windowSizeC: Int32 = 1024 * 4
-    private var outgoingBuffer: [Data] = .init()
+    /// The bytes queued for sending. Monitoring reads it without waiting for the outgoing queue.
+    private var pendingBytes: Atomic<Int> = .init(0)
+    private var pacer: SRTPacer?
+    /// The statistics of the pacer. Monitoring reads them without waiting behind a paced burst on the outgoing queue.
+    private var statistics: Atomic<SRTPacer.Statistics?> = .init(nil)
+    private var acceptor: SRTAcceptor?
+    private var statusTimer: DispatchSourceTimer?
     private lazy var incomingBuffer: Data = .init(count: Int(windowSizeC))
     private let outgoingQueue: DispatchQueue = .init(label: "com.haishinkit.SRTHaishinKit.SRTSocket.outgoing", qos: .userInitiated)
     private let incomingQueue: DispatchQueue = .init(label: "com.haishinkit.SRTHaishinKit.SRTSocket.incoming", qos: .userInitiated)
+    /// The queue that every status update runs on, so that the status timer and the poller never close a socket twice.
+    private let statusQueue: DispatchQueue = .init(label: "com.haishinkit.SRTHaishinKit.SRTSocket.status")
 
     init() {
     }
 
     init(socket: SRTSOCKET) throws {
         self.socket = socket
+        // Accepted sockets inherit the non-blocking mode of a listener.
+        _ = SRTSocketOption.rcvsyn.setOption(socket, value: true)
         guard configure(.post) else {
             throw makeSocketError()
         }
@@ -104,30 +141,66 @@ final class SRTSocket<T: SRTSocketDelegate> {
                 incomingBuffer = .init(count: Int(windowSizeC))
             }
         case .listener:
-            // only supporting a single connection
-            stat = srt_listen(socket, 1)
+            // Accepts without blocking so that every pending connection is drained on each wake-up.
+            guard SRTSocketOption.rcvsyn.setOption(socket, value: false) else {
+                srt_close(socket)
+                throw makeSocketError()
+            }
+            stat = srt_listen(socket, backlog)
             if stat == SRT_ERROR {
                 srt_close(socket)
                 throw makeSocketError()
             }
+            let acceptor = SRTAcceptor(socket: socket, handler: { [weak self] client in
+                self?.accept(client)
+            }, errorHandler: { [weak self] _ in
+                self?.updateStatus()
+            })
+            guard acceptor.start() else {
+                srt_close(socket)
+                throw makeSocketError()
+            }
+            self.acceptor = acceptor
         }
         startRunning()
     }
 
     func doOutput(data: Data) {
+        pendingBytes.mutate { $0 += data.count }
         outgoingQueue.async {
-            self.outgoingBuffer.append(contentsOf: data.chunk(kSRTSOcket_payloadSize))
-            repeat {
-                guard var data = self.outgoingBuffer.first else {
+            defer {
+                self.pendingBytes.mutate { $0 -= data.count }
+            }
+            // Sends payload-sized slices in place instead of copying every packet into its own Data.
+            data.withUnsafeBytes { pointer in
+                guard let buffer = pointer.baseAddress?.assumingMemoryBound(to: CChar.self) else {
                     return
                 }
-                _ = self.sendmsg2(&data)
-                self.outgoingBuffer.remove(at: 0)
-            } while !self.outgoingBuffer.isEmpty
+                var offset = 0
+                while offset < pointer.count {
+                    let length = min(kSRTSOcket_payloadSize, pointer.count - offset)
+                    if let gap = self.pacer?.wait(length) {
+                        let spinTime = self.pacer?.spinTime ?? 0
+                        self.statistics.mutate {
+                            $0?.gaps.record(gap)
+                            $0?.spinTime = spinTime
+                        }
+                    }
+                    _ = self.sendmsg2(buffer + offset, length: length)
+                    offset += length
+                }
+            }
         }
     }
 
     func doInput() {
+        if usesSharedPoller {
+            guard SRTSocketOption.rcvsyn.setOption(socket, value: false), SRTPoller.shared.add(self) else {
+                logger.error("failed to add a socket to the shared poller")
+                return
+            }
+            return
+        }
         incomingQueue.async {
             repeat {
                 let result = self.recvmsg()
@@ -142,8 +215,16 @@ final class SRTSocket<T: SRTSocketDelegate> {
         guard socket != SRT_INVALID_SOCK else {
             return
         }
+        if usesSharedPoller {
+            SRTPoller.shared.remove(socket)
+        }
+        let acceptor = self.acceptor
+        acceptor?.stop()
+        self.acceptor = nil
         srt_close(socket)
         socket = SRT_INVALID_SOCK
+        // The listener is closed, so no handshake callback still holds the acceptor.
+        acceptor?.release()
     }
 
     func configure(_ binding: SRTSocketOption.Binding) -> Bool {
@@ -155,15 +236,40 @@ final class SRTSocket<T: SRTSocketDelegate> {
         return true
     }
 
-    func bstats() -> Int32 {
+    /// Reads the statistics into a snapshot owned by the caller, so that concurrent readers never share a buffer.
+    func bstats(clear: Bool = true) -> CBytePerfMon? {
         guard socket != SRT_INVALID_SOCK else {
-            return SRT_ERROR
+            return nil
+        }
+        var mon = CBytePerfMon()
+        guard srt_bistats(socket, &mon, clear ? 1 : 0, 0) != SRT_ERROR else {
+            return nil
         }
-        return srt_bstats(socket, &perf, 1)
+        return mon
     }
 
-    private func accept() {
-        let socket = srt_accept(socket, nil, nil)
+    func memoryUsage() -> SRTMemoryUsage {
+        guard socket != SRT_INVALID_SOCK else {
+            return .zero
+        }
+        var capacity: Int32 = 0
+        var length = Int32(MemoryLayout<Int32>.size)
+        _ = srt_getsockflag(socket, SRTO_RCVBUF, &capacity, &length)
+        var blocks = 0
+        var bytes = 0
+        _ = srt_getsndbuffer(socket, &blocks, &bytes)
+        var stats = CBytePerfMon()
+        _ = srt_bistats(socket, &stats, 0, 1)
+        return SRTMemoryUsage(
+            socketCount: 1,
+            receiveBufferCapacity: Int(capacity),
+            receiveBufferBytes: Int(stats.byteRcvBuf),
+            sendBufferBytes: bytes,
+            pendingBytes: pendingBytes.value
+        )
+    }
+
+    private func accept(_ socket: SRTSOCKET) {
         do {
             delegate?.socket(self, didAcceptSocket: try SRTSocket(socket: socket))
         } catch {
@@ -171,6 +277,12 @@ final class SRTSocket<T: SRTSocketDelegate> {
         }
     }
 
+    private func updateStatus() {
+        statusQueue.async {
+            self.status = srt_getsockstate(self.socket)
+        }
+    }
+
     private func makeSocketError() -> SRTError {
         let error_message = String(cString: srt_getlasterror_str())
         logger.error(error_message)
@@ -178,23 +290,44 @@ final class SRTSocket<T: SRTSocketDelegate> {
     }
 
     @inline(__always)
-    private func sendmsg2(_ data: inout Data) -> Int32 {
-        return data.withUnsafeBytes { pointer in
-            guard let buffer = pointer.baseAddress?.assumingMemoryBound(to: CChar.self) else {
-                return SRT_ERROR
-            }
-            return srt_sendmsg2(socket, buffer, Int32(data.count), nil)
+    private func sendmsg2(_ buffer: UnsafePointer<CChar>, length: Int) -> Int32 {
+        let result = srt_sendmsg2(socket, buffer, Int32(length), nil)
+        if 0 < result, let capture {
+            capture.append(Data(bytes: buffer, count: Int(result)), direction: .output)
         }
+        return result
     }
 
     @inline(__always)
     private func recvmsg() -> Int32 {
-        return incomingBuffer.withUnsafeMutableBytes { pointer in
+        let result = incomingBuffer.withUnsafeMutableBytes { pointer in
             guard let buffer = pointer.baseAddress?.assumingMemoryBound(to: CChar.self) else {
                 return SRT_ERROR
             }
             return srt_recvmsg(socket, buffer, windowSizeC)
         }
+        if 0 < result, let capture {
+            capture.append(incomingBuffer.subdata(in: 0..<Int(result)), direction: .input)
+        }
+        return result
+    }
+}
+
+extension SRTSocket: SRTPollable {
+    // MARK: SRTPollable
+    func poll(_ events: Int32) {
+        if events & Int32(SRT_EPOLL_ERR.rawValue) != 0 {
+            updateStatus()
+            return
+        }
+        // Drains every queued message. A non-blocking srt_recvmsg returns SRT_ERROR with SRT_EASYNCRCV when empty.
+        repeat {
+            let result = recvmsg()
+            guard 0 < result else {
+                return
+            }
+            delegate?.socket(self, incomingDataAvailabled: incomingBuffer, bytes: result)
+        } while isRunning.value
     }
 }
 
@@ -205,17 +338,19 @@ extension SRTSocket: Running {
             return
         }
         isRunning.mutate { $0 = true }
-        DispatchQueue(label: "com.haishkinkit.SRTHaishinKit.SRTSocket.runloop").async {
-            repeat {
-                self.status = srt_getsockstate(self.socket)
-                switch self.mode {
-                case .listener:
-                    self.accept()
-                default:
-                    break
+        // Polls the status with a timer instead of a sleeping loop, so that no thread is parked per socket.
+        statusQueue.async {
+            let timer = DispatchSource.makeTimerSource(queue: self.statusQueue)
+            timer.schedule(deadline: .now(), repeating: .milliseconds(30))
+            timer.setEventHandler { [weak self] in
+                guard let self = self else {
+                    return
                 }
-                usleep(3 * 10000)
-            } while self.isRunning.value
+                self.status = srt_getsockstate(self.socket)
+            }
+            self.statusTimer?.cancel()
+            self.statusTimer = timer
+            timer.resume()
         }
     }
 
@@ -224,5 +359,9 @@ extension SRTSocket: Running {
             return
         }
         isRunning.mutate { $0 = false }
+        statusQueue.async {
+            self.statusTimer?.cancel()
+            self.statusTimer = nil
+        }
     }
 }
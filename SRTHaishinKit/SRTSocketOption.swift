@@ -424,6 +424,19 @@ public enum SRTSocketOption: String {
         return failures
     }
 
+    /// Makes the fc and rcvbuf options sized for the expected bit rate and latency, instead of the libsrt defaults that reserve about 8 MB per socket.
+    /// - seealso: https://github.com/Haivision/srt/blob/master/docs/API/configuration-guidelines.md
+    static func makeBufferOptions(bitRate: Int, latency: Int, rtt: Int = 100, payloadSize: Int = 1316, mss: Int = 1500) -> [SRTSocketOption: Any] {
+        let fullLatency = Double(latency + rtt / 2) / 1000
+        let packets = Int((fullLatency * Double(bitRate) / 8 / Double(payloadSize)).rounded(.up))
+        // A quarter margin for retransmissions and bursts.
+        let fc = max(32, packets + packets / 4)
+        return [
+            .fc: fc,
+            .rcvbuf: fc * (mss - 28)
+        ]
+    }
+
     static func getQueryItems(uri: URL) -> [String: String] {
         let url = uri.absoluteString
         if !url.contains("?") {
@@ -0,0 +1,148 @@
+import Foundation
+import libsrt
+
+/// The SRTSocketTable struct maps SRT socket ids to values with a resizable open-addressing table.
+///
+/// It uses Robin Hood hashing with backward-shift deletion, so that probe sequences stay short and contiguous even when thousands of sockets are registered.
+struct SRTSocketTable<Value> {
+    static var minimumCapacity: Int {
+        16
+    }
+
+    private struct Slot {
+        let key: SRTSOCKET
+        var value: Value
+        /// The distance from the ideal slot.
+        var distance: Int
+    }
+
+    /// The number of entries.
+    private(set) var count = 0
+
+    /// The number of slots.
+    var capacity: Int {
+        slots.count
+    }
+
+    private var slots: [Slot?]
+    private var mask: Int
+
+    init(capacity: Int = 16) {
+        var size = Self.minimumCapacity
+        while size < capacity {
+            size <<= 1
+        }
+        slots = .init(repeating: nil, count: size)
+        mask = size - 1
+    }
+
+    subscript(key: SRTSOCKET) -> Value? {
+        get {
+            guard let index = index(of: key) else {
+                return nil
+            }
+            return slots[index]?.value
+        }
+        set {
+            if let newValue {
+                insert(newValue, for: key)
+            } else {
+                remove(key)
+            }
+        }
+    }
+
+    /// Removes all entries and shrinks the table.
+    mutating func removeAll() {
+        slots = .init(repeating: nil, count: Self.minimumCapacity)
+        mask = Self.minimumCapacity - 1
+        count = 0
+    }
+
+    /// Removes the entries that satisfy the predicate.
+    mutating func removeAll(where shouldBeRemoved: (SRTSOCKET, Value) -> Bool) {
+        let oldSlots = slots
+        slots = .init(repeating: nil, count: oldSlots.count)
+        count = 0
+        for case let slot? in oldSlots where !shouldBeRemoved(slot.key, slot.value) {
+            place(slot)
+            count += 1
+        }
+    }
+
+    private func index(of key: SRTSOCKET) -> Int? {
+        var index = Self.hash(key) & mask
+        var distance = 0
+        while let slot = slots[index] {
+            if slot.key == key {
+                return index
+            }
+            // Robin Hood invariant: the key would have been placed before any richer entry.
+            if slot.distance < distance {
+                return nil
+            }
+            index = (index + 1) & mask
+            distance += 1
+        }
+        return nil
+    }
+
+    private mutating func insert(_ value: Value, for key: SRTSOCKET) {
+        if let index = index(of: key) {
+            slots[index]?.value = value
+            return
+        }
+        // Keeps the load factor under 3/4.
+        if slots.count * 3 <= (count + 1) * 4 {
+            resize(slots.count << 1)
+        }
+        place(Slot(key: key, value: value, distance: 0))
+        count += 1
+    }
+
+    private mutating func remove(_ key: SRTSOCKET) {
+        guard var index = index(of: key) else {
+            return
+        }
+        slots[index] = nil
+        count -= 1
+        var next = (index + 1) & mask
+        while var slot = slots[next], 0 < slot.distance {
+            slot.distance -= 1
+            slots[index] = slot
+            slots[next] = nil
+            index = next
+            next = (next + 1) & mask
+        }
+    }
+
+    private mutating func place(_ slot: Slot) {
+        var slot = slot
+        var index = Self.hash(slot.key) & mask
+        slot.distance = 0
+        while let current = slots[index] {
+            if current.distance < slot.distance {
+                slots[index] = slot
+                slot = current
+            }
+            index = (index + 1) & mask
+            slot.distance += 1
+        }
+        slots[index] = slot
+    }
+
+    private mutating func resize(_ capacity: Int) {
+        let oldSlots = slots
+        slots = .init(repeating: nil, count: capacity)
+        mask = capacity - 1
+        for case let slot? in oldSlots {
+            place(slot)
+        }
+    }
+
+    /// Fibonacci hashing spreads sequential socket ids over the table.
+    @inline(__always)
+    private static func hash(_ key: SRTSOCKET) -> Int {
+        Int(truncatingIfNeeded: (UInt64(UInt32(bitPattern: key)) &* 0x9E37_79B9_7F4A_7C15) >> 32)
+    }
+}
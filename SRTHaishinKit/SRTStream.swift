@@ -5,6 +5,22 @@ import libsrt
 
 /// An object that provides the interface to control a one-way channel over a SRTConnection.
 public final class SRTStream: NetStream {
+    /// Specifies the latency probe that embeds capture times into outgoing video and measures them on incoming video.
+    public var latencyProbe: LatencyProbe? {
+        didSet {
+            writer.latencyProbe = latencyProbe
+            reader.latencyProbe = latencyProbe
+        }
+    }
+
+    /// Specifies the gateway that republishes incoming transport stream to RTMP without decoding.
+    /// While it is set, playback doesn't decode or render incoming media.
+    public var gateway: TSRTMPGateway?
+
+    /// Specifies the analyzer that monitors incoming transport stream with the checks of TR 101 290.
+    /// It runs on the queue that receives the stream, before the gateway or the playback.
+    public var analyzer: TSAnalyzer?
+
     private var name: String?
     private var action: (() -> Void)?
     private var keyValueObservations: [NSKeyValueObservation] = []
@@ -96,6 +112,12 @@ public final class SRTStream: NetStream {
         }
     }
 
+    @discardableResult
+    override public func disconnect() -> Bool {
+        close()
+        return true
+    }
+
     override public func readyStateDidChange(to readyState: NetStream.ReadyState) {
         switch readyState {
         case .play:
@@ -115,6 +137,12 @@ public final class SRTStream: NetStream {
     }
 
     func doInput(_ data: Data) {
+        // Live input is timed by arrival, since its PCRs may come at a variable bit rate.
+        analyzer?.analyze(data, arrivalTime: Double(DispatchTime.now().uptimeNanoseconds) / 1_000_000_000)
+        if let gateway {
+            gateway.read(data)
+            return
+        }
         _ = reader.read(data)
     }
 }
@@ -129,6 +157,13 @@ extension SRTStream: TSWriterDelegate {
     }
 }
 
+extension SRTStream: RTMPTSGatewayDelegate {
+    // MARK: RTMPTSGatewayDelegate
+    public func gateway(_ gateway: RTMPTSGateway, didOutput data: Data) {
+        connection?.socket?.doOutput(data: data)
+    }
+}
+
 extension SRTStream: TSReaderDelegate {
     // MARK: TSReaderDelegate
     public func reader(_ reader: TSReader, id: UInt16, didRead formatDescription: CMFormatDescription) {
@@ -137,4 +172,8 @@ extension SRTStream: TSReaderDelegate {
     public func reader(_ reader: TSReader, id: UInt16, didRead sampleBuffer: CMSampleBuffer) {
         append(sampleBuffer)
     }
+
+    public func reader(_ reader: TSReader, id: UInt16, didRead metadata: TimedMetadata) {
+        delegate?.stream(self, didOutput: metadata)
+    }
 }
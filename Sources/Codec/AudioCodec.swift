@@ -39,6 +39,7 @@ final class AudioCodec<T: AudioCodecDelegate> {
             cursor = 0
             inputBuffers.removeAll()
             outputBuffers.removeAll()
+            outputBufferIDs.removeAll()
             audioConverter = makeAudioConverter()
             for _ in 0..<settings.format.inputBufferCounts {
                 if let inputBuffer = makeInputBuffer() {
@@ -53,6 +54,9 @@ final class AudioCodec<T: AudioCodecDelegate> {
     private var cursor: Int = 0
     private var inputBuffers: [AVAudioBuffer] = []
     private var outputBuffers: [AVAudioBuffer] = []
+    /// The buffers made for the current output format. Buffers of an earlier format may still be released after a format change.
+    private var outputBufferIDs: Set<ObjectIdentifier> = []
+    private var packetBuffer: AVAudioCompressedBuffer?
     private var audioConverter: AVAudioConverter?
 
     init(lockQueue: DispatchQueue) {
@@ -65,24 +69,24 @@ final class AudioCodec<T: AudioCodecDelegate> {
         }
         switch settings.format {
         case .pcm:
+            guard let blockBuffer = sampleBuffer.dataBuffer, let buffer = makePacketBuffer(sampleBuffer) else {
+                return
+            }
+            // Gathers all ADTS frames into one multi-packet buffer instead of allocating a buffer per frame.
             var offset = 0
-            var presentationTimeStamp = sampleBuffer.presentationTimeStamp
             for i in 0..<sampleBuffer.numSamples {
-                guard let buffer = makeInputBuffer() as? AVAudioCompressedBuffer else {
-                    continue
-                }
                 let sampleSize = CMSampleBufferGetSampleSize(sampleBuffer, at: i)
                 let byteCount = sampleSize - ADTSHeader.size
-                buffer.packetDescriptions?.pointee = AudioStreamPacketDescription(mStartOffset: 0, mVariableFramesInPacket: 0, mDataByteSize: UInt32(byteCount))
-                buffer.packetCount = 1
-                buffer.byteLength = UInt32(byteCount)
-                if let blockBuffer = sampleBuffer.dataBuffer {
-                    CMBlockBufferCopyDataBytes(blockBuffer, atOffset: offset + ADTSHeader.size, dataLength: byteCount, destination: buffer.data)
-                    append(buffer, when: presentationTimeStamp.makeAudioTime())
-                    presentationTimeStamp = CMTimeAdd(presentationTimeStamp, CMTime(value: CMTimeValue(1024), timescale: sampleBuffer.presentationTimeStamp.timescale))
-                    offset += sampleSize
+                guard 0 < byteCount, Int(buffer.byteLength) + byteCount <= Int(buffer.byteCapacity) else {
+                    break
                 }
+                CMBlockBufferCopyDataBytes(blockBuffer, atOffset: offset + ADTSHeader.size, dataLength: byteCount, destination: buffer.data.advanced(by: Int(buffer.byteLength)))
+                buffer.packetDescriptions?[Int(buffer.packetCount)] = AudioStreamPacketDescription(mStartOffset: Int64(buffer.byteLength), mVariableFramesInPacket: 0, mDataByteSize: UInt32(byteCount))
+                buffer.packetCount += 1
+                buffer.byteLength += UInt32(byteCount)
+                offset += sampleSize
             }
+            append(buffer, when: sampleBuffer.presentationTimeStamp.makeAudioTime())
         default:
             break
         }
@@ -90,13 +94,20 @@ final class AudioCodec<T: AudioCodecDelegate> {
 
     func append(_ audioBuffer: AVAudioBuffer, when: AVAudioTime) {
         inputFormat = audioBuffer.format
-        guard let audioConverter, isRunning.value else {
+        guard audioConverter != nil, isRunning.value else {
             return
         }
-        var error: NSError?
-        let outputBuffer = self.outputBuffer
-        let outputStatus = audioConverter.convert(to: outputBuffer, error: &error) { _, inputStatus in
-            switch self.inputBuffer {
+        if let audioBuffer = audioBuffer as? AVAudioCompressedBuffer, 1 < audioBuffer.packetCount {
+            let framesPerPacket = AVAudioFramePosition(audioBuffer.format.streamDescription.pointee.mFramesPerPacket)
+            for i in 0..<Int(audioBuffer.packetCount) {
+                convert(when.advanced(by: AVAudioFramePosition(i) * framesPerPacket, sampleRate: audioBuffer.format.sampleRate)) { inputBuffer in
+                    (inputBuffer as? AVAudioCompressedBuffer)?.copy(audioBuffer, at: i)
+                }
+            }
+            return
+        }
+        convert(when) { inputBuffer in
+            switch inputBuffer {
             case let inputBuffer as AVAudioCompressedBuffer:
                 inputBuffer.copy(audioBuffer)
             case let inputBuffer as AVAudioPCMBuffer:
@@ -106,6 +117,17 @@ final class AudioCodec<T: AudioCodecDelegate> {
             default:
                 break
             }
+        }
+    }
+
+    private func convert(_ when: AVAudioTime, input: (AVAudioBuffer) -> Void) {
+        guard let audioConverter else {
+            return
+        }
+        var error: NSError?
+        let outputBuffer = self.outputBuffer
+        let outputStatus = audioConverter.convert(to: outputBuffer, error: &error) { _, inputStatus in
+            input(self.inputBuffer)
             inputStatus.pointee = .haveData
             return self.inputBuffer
         }
@@ -125,6 +147,19 @@ final class AudioCodec<T: AudioCodecDelegate> {
         }
     }
 
+    private func makePacketBuffer(_ sampleBuffer: CMSampleBuffer) -> AVAudioCompressedBuffer? {
+        guard let inputFormat = inputFormat ?? sampleBuffer.formatDescription.map({ AVAudioFormat(cmAudioFormatDescription: $0) }) else {
+            return nil
+        }
+        let packetCount = AVAudioPacketCount(max(sampleBuffer.numSamples, 1))
+        if let packetBuffer, packetBuffer.format == inputFormat, packetCount <= packetBuffer.packetCapacity {
+            packetBuffer.removeAll()
+            return packetBuffer
+        }
+        packetBuffer = AVAudioCompressedBuffer(format: inputFormat, packetCapacity: packetCount, maximumPacketSize: 1024 * Int(inputFormat.channelCount))
+        return packetBuffer
+    }
+
     private func makeInputBuffer() -> AVAudioBuffer? {
         guard let inputFormat else {
             return nil
@@ -169,13 +204,18 @@ extension AudioCodec: Codec {
         }
         if outputBuffers.isEmpty {
             for _ in 0..<settings.format.outputBufferCounts {
-                outputBuffers.append(settings.format.makeAudioBuffer(outputFormat) ?? .init())
+                let buffer = settings.format.makeAudioBuffer(outputFormat) ?? .init()
+                outputBuffers.append(buffer)
+                outputBufferIDs.insert(ObjectIdentifier(buffer))
             }
         }
         return outputBuffers.removeFirst()
     }
 
     func releaseOutputBuffer(_ buffer: AVAudioBuffer) {
+        guard outputBufferIDs.contains(ObjectIdentifier(buffer)) else {
+            return
+        }
         outputBuffers.append(buffer)
     }
 
@@ -15,6 +15,8 @@ protocol VideoCodecDelegate: AnyObject {
     func videoCodec(_ codec: VideoCodec<Self>, didOutput sampleBuffer: CMSampleBuffer)
     /// Tells the receiver to occured an error.
     func videoCodec(_ codec: VideoCodec<Self>, errorOccurred error: IOVideoUnitError)
+    /// Tells the receiver the milliseconds from submitting a frame to receiving it encoded.
+    func videoCodec(_ codec: VideoCodec<Self>, didEncodeIn latency: Double)
 }
 
 private let kVideoCodec_defaultFrameInterval: Double = 0.0
@@ -92,24 +94,36 @@ final class VideoCodec<T: VideoCodecDelegate> {
     }
 
     func append(_ imageBuffer: CVImageBuffer, presentationTimeStamp: CMTime, duration: CMTime) {
-        guard isRunning.value, !willDropFrame(presentationTimeStamp) else {
+        encode(imageBuffer, presentationTimeStamp: presentationTimeStamp, duration: duration, forcesKeyFrame: false) { [unowned self] sampleBuffer in
+            delegate?.videoCodec(self, didOutput: sampleBuffer)
+        }
+    }
+
+    /// Encodes a frame, and calls the handler with the encoded frame instead of the delegate.
+    /// A frame that forces a keyframe is never dropped, as other encoders cut their keyframes at the same timestamp.
+    func encode(_ imageBuffer: CVImageBuffer, presentationTimeStamp: CMTime, duration: CMTime, forcesKeyFrame: Bool, handler: @escaping (CMSampleBuffer) -> Void) {
+        guard isRunning.value, forcesKeyFrame || !willDropFrame(presentationTimeStamp) else {
             return
         }
         if invalidateSession {
             session = VTSessionMode.compression.makeSession(self)
         }
+        let submittedAt = DispatchTime.now().uptimeNanoseconds
         _ = session?.encodeFrame(
             imageBuffer,
             presentationTimeStamp: presentationTimeStamp,
-            duration: duration
+            duration: duration,
+            frameProperties: forcesKeyFrame ? [kVTEncodeFrameOptionKey_ForceKeyFrame: true] as CFDictionary : nil
         ) { [unowned self] status, _, sampleBuffer in
             guard let sampleBuffer, status == noErr else {
                 delegate?.videoCodec(self, errorOccurred: .failedToFlame(status: status))
                 return
             }
+            let latency = Double(DispatchTime.now().uptimeNanoseconds - submittedAt) / 1_000_000
+            delegate?.videoCodec(self, didEncodeIn: latency)
             self.presentationTimeStamp = sampleBuffer.presentationTimeStamp
             outputFormat = sampleBuffer.formatDescription
-            delegate?.videoCodec(self, didOutput: sampleBuffer)
+            handler(sampleBuffer)
         }
     }
 
@@ -0,0 +1,251 @@
+import AVFoundation
+import CoreImage
+
+/// The interface a VideoLadder uses to inform its delegate.
+public protocol VideoLadderDelegate: AnyObject {
+    /// Tells the receiver to output an encoded frame of a rendition.
+    func ladder(_ ladder: VideoLadder, rendition: Int, didOutput sampleBuffer: CMSampleBuffer)
+}
+
+/// The interface an encoder of a rendition implements, so that a VideoLadder drives any encoder.
+protocol VideoLadderEncoder: AnyObject {
+    /// Encodes a frame, and calls the handler with the encoded frame.
+    func encode(_ imageBuffer: CVImageBuffer, presentationTimeStamp: CMTime, duration: CMTime, forcesKeyFrame: Bool, handler: @escaping (CMSampleBuffer) -> Void)
+}
+
+/// The interface a VideoLadder scales frames with.
+protocol VideoLadderScaler: AnyObject {
+    /// Scales a frame to the size.
+    func scale(_ imageBuffer: CVImageBuffer, to size: CGSize) -> CVImageBuffer?
+}
+
+// MARK: -
+/// The VideoLadder class encodes each mixed frame into several renditions, e.g. 1080p, 720p and 480p of an HLS or CMAF ladder.
+///
+/// A frame is scaled once per rendition down a shared pyramid, where each rendition is scaled from the next larger one instead of the source.
+/// Each rendition scales and encodes on its own queue, and hands its scaled frame to the next smaller one before encoding, so the capture thread only
+/// decides keyframes. Keyframes are forced at the same presentation timestamps in all renditions, so that segmenters cut every rendition at the same points.
+public final class VideoLadder {
+    /// The metrics of a rendition.
+    public struct Metrics {
+        /// The bucket bounds of the latency histogram in milliseconds.
+        public static let latencyBounds: [Double] = [1, 2, 5, 10, 20, 33, 50, 100, 200, 500, 1000]
+
+        /// The number of encoded frames.
+        public internal(set) var frameCount = 0
+        /// The number of encoded keyframes.
+        public internal(set) var keyFrameCount = 0
+        /// The number of frames whose keyframe flag differs from the ladder's decision.
+        public internal(set) var misalignedFrameCount = 0
+        /// The number of frames that the encoder dropped or failed to encode.
+        public internal(set) var droppedFrameCount = 0
+        /// The histogram of milliseconds from a mixed frame to its encoded frame.
+        public internal(set) var latency = Histogram(bounds: Metrics.latencyBounds)
+    }
+
+    /// The 1080p, 720p and 480p ladder.
+    public static let defaultRenditions: [VideoCodecSettings] = [
+        .init(videoSize: .init(width: 1920, height: 1080), bitRate: 6000 * 1000, profileLevel: kVTProfileLevel_H264_High_AutoLevel as String),
+        .init(videoSize: .init(width: 1280, height: 720), bitRate: 3000 * 1000, profileLevel: kVTProfileLevel_H264_High_AutoLevel as String),
+        .init(videoSize: .init(width: 854, height: 480), bitRate: 1200 * 1000, profileLevel: kVTProfileLevel_H264_Main_AutoLevel as String)
+    ]
+
+    /// Specifies the delegate.
+    public weak var delegate: (any VideoLadderDelegate)?
+    /// The settings of renditions.
+    public let renditions: [VideoCodecSettings]
+    /// The interval of keyframes in seconds, shared by all renditions.
+    public let keyFrameInterval: Double
+    /// The metrics of renditions.
+    public var metrics: [Metrics] {
+        lockQueue.sync { _metrics }
+    }
+    /// The running indicies whether encoding or not.
+    public private(set) var isRunning: Atomic<Bool> = .init(false)
+
+    private let encoders: [any VideoLadderEncoder]
+    private let scaler: any VideoLadderScaler
+    private let queues: [DispatchQueue]
+    /// The indicies of renditions from the largest to the smallest.
+    private let pyramid: [Int]
+    private var nextKeyFrameTimestamp: CMTime = .invalid
+    private var keyFrameTimestamps: [CMTime] = []
+    private var enqueuedAt: [[CMTime: UInt64]]
+    private var _metrics: [Metrics]
+    private let lockQueue = DispatchQueue(label: "com.haishinkit.HaishinKit.VideoLadder.lock")
+
+    /// Creates a new ladder encoded with VideoToolbox.
+    public convenience init(renditions: [VideoCodecSettings] = VideoLadder.defaultRenditions, keyFrameInterval: Double = 2) {
+        let queues = renditions.indices.map { DispatchQueue(label: "com.haishinkit.HaishinKit.VideoLadder.rendition\($0)", qos: .userInitiated) }
+        let encoders = zip(renditions, queues).map { settings, queue in
+            let codec = VideoCodec<IOMixer>(lockQueue: queue)
+            codec.settings = settings
+            // The ladder forces keyframes. The encoder's own interval only guards against a stalled source.
+            codec.settings.maxKeyFrameIntervalDuration = Int32((keyFrameInterval * 2).rounded(.up))
+            return codec
+        }
+        self.init(renditions: renditions, keyFrameInterval: keyFrameInterval, encoders: encoders, scaler: VideoLadderImageScaler(), queues: queues)
+    }
+
+    init(renditions: [VideoCodecSettings], keyFrameInterval: Double, encoders: [any VideoLadderEncoder], scaler: any VideoLadderScaler, queues: [DispatchQueue]? = nil) {
+        self.renditions = renditions
+        self.keyFrameInterval = keyFrameInterval
+        self.encoders = encoders
+        self.scaler = scaler
+        self.queues = queues ?? renditions.indices.map { DispatchQueue(label: "com.haishinkit.HaishinKit.VideoLadder.rendition\($0)", qos: .userInitiated) }
+        pyramid = renditions.indices.sorted {
+            renditions[$1].videoSize.width * renditions[$1].videoSize.height < renditions[$0].videoSize.width * renditions[$0].videoSize.height
+        }
+        enqueuedAt = .init(repeating: [:], count: renditions.count)
+        _metrics = .init(repeating: .init(), count: renditions.count)
+    }
+
+    /// Appends a mixed frame.
+    public func append(_ imageBuffer: CVImageBuffer, presentationTimeStamp: CMTime, duration: CMTime) {
+        guard isRunning.value else {
+            return
+        }
+        let now = DispatchTime.now().uptimeNanoseconds
+        let forcesKeyFrame = lockQueue.sync { () -> Bool in
+            guard !nextKeyFrameTimestamp.isValid || nextKeyFrameTimestamp <= presentationTimeStamp else {
+                return false
+            }
+            nextKeyFrameTimestamp = presentationTimeStamp + CMTime(seconds: keyFrameInterval, preferredTimescale: presentationTimeStamp.timescale)
+            keyFrameTimestamps.append(presentationTimeStamp)
+            // Keeps the decisions of frames still in flight.
+            if 8 < keyFrameTimestamps.count {
+                keyFrameTimestamps.removeFirst()
+            }
+            return true
+        }
+        encode(imageBuffer, level: 0, presentationTimeStamp: presentationTimeStamp, duration: duration, forcesKeyFrame: forcesKeyFrame, appendedAt: now)
+    }
+
+    /// Scales and encodes a frame for the rendition at the level of the pyramid on its queue, and passes the frame down to the next level.
+    private func encode(_ source: CVImageBuffer, level: Int, presentationTimeStamp: CMTime, duration: CMTime, forcesKeyFrame: Bool, appendedAt: UInt64) {
+        guard level < pyramid.count else {
+            return
+        }
+        let index = pyramid[level]
+        queues[index].async {
+            let size = self.renditions[index].videoSize
+            let sourceSize = CGSize(width: CVPixelBufferGetWidth(source), height: CVPixelBufferGetHeight(source))
+            let frame = size == sourceSize ? source : self.scaler.scale(source, to: size)
+            // The smaller renditions scale while this one encodes. A failed scale passes the larger frame down instead.
+            self.encode(frame ?? source, level: level + 1, presentationTimeStamp: presentationTimeStamp, duration: duration, forcesKeyFrame: forcesKeyFrame, appendedAt: appendedAt)
+            guard let frame else {
+                return
+            }
+            self.lockQueue.sync {
+                // A frame without output after a whole keyframe interval was dropped by the encoder, so its entry would never be removed.
+                let window = presentationTimeStamp - CMTime(seconds: self.keyFrameInterval, preferredTimescale: presentationTimeStamp.timescale)
+                let count = self.enqueuedAt[index].count
+                self.enqueuedAt[index] = self.enqueuedAt[index].filter { window <= $0.key }
+                self._metrics[index].droppedFrameCount += count - self.enqueuedAt[index].count
+                self.enqueuedAt[index][presentationTimeStamp] = appendedAt
+            }
+            self.encoders[index].encode(frame, presentationTimeStamp: presentationTimeStamp, duration: duration, forcesKeyFrame: forcesKeyFrame) { sampleBuffer in
+                self.output(sampleBuffer, rendition: index)
+            }
+        }
+    }
+
+    private func output(_ sampleBuffer: CMSampleBuffer, rendition index: Int) {
+        let now = DispatchTime.now().uptimeNanoseconds
+        let presentationTimeStamp = sampleBuffer.presentationTimeStamp
+        let isKeyFrame = !sampleBuffer.isNotSync
+        lockQueue.sync {
+            let isForced = keyFrameTimestamps.contains(presentationTimeStamp)
+            _metrics[index].frameCount += 1
+            if isKeyFrame {
+                _metrics[index].keyFrameCount += 1
+            }
+            if isKeyFrame != isForced {
+                _metrics[index].misalignedFrameCount += 1
+            }
+            if let enqueuedAt = enqueuedAt[index].removeValue(forKey: presentationTimeStamp) {
+                _metrics[index].latency.record(Double(now - min(now, enqueuedAt)) / 1_000_000)
+            }
+        }
+        delegate?.ladder(self, rendition: index, didOutput: sampleBuffer)
+    }
+}
+
+extension VideoLadder: Running {
+    // MARK: Running
+    public func startRunning() {
+        guard !isRunning.value else {
+            return
+        }
+        for case let encoder as any Running in encoders {
+            encoder.startRunning()
+        }
+        lockQueue.sync {
+            nextKeyFrameTimestamp = .invalid
+            keyFrameTimestamps.removeAll()
+            enqueuedAt = .init(repeating: [:], count: renditions.count)
+            _metrics = .init(repeating: .init(), count: renditions.count)
+        }
+        isRunning.mutate { $0 = true }
+    }
+
+    public func stopRunning() {
+        guard isRunning.value else {
+            return
+        }
+        isRunning.mutate { $0 = false }
+        for case let encoder as any Running in encoders {
+            encoder.stopRunning()
+        }
+    }
+}
+
+extension VideoCodec: VideoLadderEncoder {
+}
+
+// MARK: -
+/// The VideoLadderImageScaler class scales frames with Core Image into pooled pixel buffers. Renditions scale with it concurrently from their own queues.
+final class VideoLadderImageScaler: VideoLadderScaler {
+    private let context = CIContext()
+    private var pools: [String: CVPixelBufferPool] = [:]
+    private let lockQueue = DispatchQueue(label: "com.haishinkit.HaishinKit.VideoLadderImageScaler.lock")
+
+    func scale(_ imageBuffer: CVImageBuffer, to size: CGSize) -> CVImageBuffer? {
+        let pixelFormat = CVPixelBufferGetPixelFormatType(imageBuffer)
+        guard let pool = makePool(size, pixelFormat: pixelFormat) else {
+            return nil
+        }
+        var pixelBuffer: CVPixelBuffer?
+        guard pool.createPixelBuffer(&pixelBuffer) == kCVReturnSuccess, let pixelBuffer else {
+            return nil
+        }
+        let image = CIImage(cvPixelBuffer: imageBuffer)
+        let scaled = image.transformed(by: .init(scaleX: size.width / image.extent.width, y: size.height / image.extent.height))
+        context.render(scaled, to: pixelBuffer)
+        return pixelBuffer
+    }
+
+    private func makePool(_ size: CGSize, pixelFormat: OSType) -> CVPixelBufferPool? {
+        let key = "\(Int(size.width))x\(Int(size.height)):\(pixelFormat)"
+        return lockQueue.sync {
+            if let pool = pools[key] {
+                return pool
+            }
+            let pool = Self.createPool(size, pixelFormat: pixelFormat)
+            pools[key] = pool
+            return pool
+        }
+    }
+
+    private static func createPool(_ size: CGSize, pixelFormat: OSType) -> CVPixelBufferPool? {
+        let attributes: [NSString: AnyObject] = [
+            kCVPixelBufferPixelFormatTypeKey: NSNumber(value: pixelFormat),
+            kCVPixelBufferWidthKey: NSNumber(value: Int(size.width)),
+            kCVPixelBufferHeightKey: NSNumber(value: Int(size.height)),
+            kCVPixelBufferIOSurfacePropertiesKey: NSDictionary()
+        ]
+        var pool: CVPixelBufferPool?
+        CVPixelBufferPoolCreate(kCFAllocatorDefault, nil, attributes as CFDictionary, &pool)
+        return pool
+    }
+}
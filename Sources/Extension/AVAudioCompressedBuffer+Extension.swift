@@ -16,4 +16,39 @@ extension AVAudioCompressedBuffer {
         data.copyMemory(from: buffer.data, byteCount: Int(buffer.byteLength))
         return true
     }
+
+    /// Copies a packet at the specified index of a multi-packet buffer as a single packet.
+    @discardableResult
+    @inline(__always)
+    final func copy(_ buffer: AVAudioCompressedBuffer, at index: Int) -> Bool {
+        guard index < buffer.packetCount, let packetDescription = buffer.packetDescriptions?[index], packetDescription.mDataByteSize <= byteCapacity else {
+            return false
+        }
+        packetDescriptions?.pointee = AudioStreamPacketDescription(mStartOffset: 0, mVariableFramesInPacket: packetDescription.mVariableFramesInPacket, mDataByteSize: packetDescription.mDataByteSize)
+        packetCount = 1
+        byteLength = packetDescription.mDataByteSize
+        data.copyMemory(from: buffer.data.advanced(by: Int(packetDescription.mStartOffset)), byteCount: Int(packetDescription.mDataByteSize))
+        return true
+    }
+
+    /// Appends a packet to the end of the buffer. Returns false if the buffer is full.
+    @discardableResult
+    @inline(__always)
+    final func append(_ bytes: UnsafeRawPointer, count: Int) -> Bool {
+        guard packetCount < packetCapacity, Int(byteLength) + count <= Int(byteCapacity) else {
+            return false
+        }
+        packetDescriptions?[Int(packetCount)] = AudioStreamPacketDescription(mStartOffset: Int64(byteLength), mVariableFramesInPacket: 0, mDataByteSize: UInt32(count))
+        data.advanced(by: Int(byteLength)).copyMemory(from: bytes, byteCount: count)
+        packetCount += 1
+        byteLength += UInt32(count)
+        return true
+    }
+
+    /// Removes all packets.
+    @inline(__always)
+    final func removeAll() {
+        packetCount = 0
+        byteLength = 0
+    }
 }
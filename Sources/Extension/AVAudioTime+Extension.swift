@@ -8,4 +8,15 @@ extension AVAudioTime {
     func makeTime() -> CMTime {
         return .init(seconds: AVAudioTime.seconds(forHostTime: hostTime), preferredTimescale: 1000000000)
     }
+
+    /// Returns a time advanced by the number of frames at the specified sample rate.
+    func advanced(by frames: AVAudioFramePosition, sampleRate: Double) -> AVAudioTime {
+        guard frames != 0, 0 < sampleRate else {
+            return self
+        }
+        if isSampleTimeValid {
+            return .init(sampleTime: sampleTime + AVAudioFramePosition(Double(frames) * self.sampleRate / sampleRate), atRate: self.sampleRate)
+        }
+        return .init(hostTime: hostTime + AVAudioTime.hostTime(forSeconds: Double(frames) / sampleRate))
+    }
 }
@@ -14,6 +14,19 @@ extension CMSampleBuffer {
         }
     }
 
+    /// Whether other frames depend on the frame. An unknown frame is assumed to be a reference.
+    var isDependedOnByOthers: Bool {
+        getAttachmentValue(for: kCMSampleAttachmentKey_DependedOnByOthers) ?? true
+    }
+
+    /// The bytes held by the pixels of an image buffer, or by the samples otherwise.
+    var byteCount: Int {
+        if let imageBuffer {
+            return CVPixelBufferGetDataSize(imageBuffer)
+        }
+        return CMSampleBufferGetTotalSampleSize(self)
+    }
+
     @available(iOS, obsoleted: 13.0)
     @available(tvOS, obsoleted: 13.0)
     @available(macOS, obsoleted: 10.15)
@@ -11,14 +11,14 @@ extension VTCompressionSession: VTSessionConvertible {
     // MARK: VTSessionConvertible
     @discardableResult
     @inline(__always)
-    func encodeFrame(_ imageBuffer: CVImageBuffer, presentationTimeStamp: CMTime, duration: CMTime, outputHandler: @escaping VTCompressionOutputHandler) -> OSStatus {
+    func encodeFrame(_ imageBuffer: CVImageBuffer, presentationTimeStamp: CMTime, duration: CMTime, frameProperties: CFDictionary?, outputHandler: @escaping VTCompressionOutputHandler) -> OSStatus {
         var flags: VTEncodeInfoFlags = []
         return VTCompressionSessionEncodeFrame(
             self,
             imageBuffer: imageBuffer,
             presentationTimeStamp: presentationTimeStamp,
             duration: duration,
-            frameProperties: nil,
+            frameProperties: frameProperties,
             infoFlagsOut: &flags,
             outputHandler: outputHandler
         )
@@ -9,7 +9,7 @@ extension VTDecompressionSession: VTSessionConvertible {
 
     @discardableResult
     @inline(__always)
-    func encodeFrame(_ imageBuffer: CVImageBuffer, presentationTimeStamp: CMTime, duration: CMTime, outputHandler: @escaping VTCompressionOutputHandler) -> OSStatus {
+    func encodeFrame(_ imageBuffer: CVImageBuffer, presentationTimeStamp: CMTime, duration: CMTime, frameProperties: CFDictionary?, outputHandler: @escaping VTCompressionOutputHandler) -> OSStatus {
         return noErr
     }
 
@@ -116,6 +116,9 @@ struct ADTSReaderIterator: IteratorProtocol {
             return nil
         }
         header.data = data.advanced(by: cursor)
+        guard ADTSHeader.size <= header.aacFrameLength else {
+            return nil
+        }
         defer {
             cursor += Int(header.aacFrameLength)
         }
@@ -13,6 +13,8 @@ enum ESStreamType: UInt8 {
     case adtsAac = 0x0F
     case h263 = 0x10
 
+    case metadata = 0x15
+
     case h264 = 0x1B
     case h265 = 0x24
 
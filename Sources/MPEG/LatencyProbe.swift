@@ -0,0 +1,125 @@
+import CoreMedia
+import Foundation
+
+/// The LatencyProbe class embeds the capture wall-clock time into H.264/HEVC bitstreams as a user_data_unregistered SEI, and measures the glass-to-glass latency on a receiver.
+/// - Note: The latency is meaningful only if the clocks of the sender and the receiver are synchronized, e.g. by NTP.
+public final class LatencyProbe {
+    /// The default UUID that identifies a probe SEI.
+    public static let defaultUUID = UUID(uuidString: "4C9D8F3A-7B2E-4A61-9E5C-D1B3F7A2C6E8")!
+
+    static let payloadType: UInt8 = 5
+    static let payloadSize: UInt8 = 16 + 8
+    static let searchLength = 1024
+
+    /// The UUID that identifies a probe SEI.
+    public let uuid: UUID
+
+    /// The histogram of measured latency in milliseconds.
+    public var histogram: Histogram {
+        _histogram.value
+    }
+
+    /// The latest measured latency in milliseconds.
+    public var latency: Double {
+        _latency.value
+    }
+
+    private var _histogram: Atomic<Histogram> = .init(.init())
+    private var _latency: Atomic<Double> = .init(0)
+    private let marker: Data
+
+    /// Creates a new LatencyProbe.
+    public init(uuid: UUID = LatencyProbe.defaultUUID) {
+        self.uuid = uuid
+        var marker = Data([LatencyProbe.payloadType, LatencyProbe.payloadSize])
+        marker.append(withUnsafeBytes(of: uuid.uuid) { Data($0) })
+        self.marker = LatencyProbe.escape(marker)
+    }
+
+    /// Removes all measured values.
+    public func reset() {
+        _histogram.mutate { $0.reset() }
+        _latency.mutate { $0 = 0 }
+    }
+
+    /// Makes a SEI NAL unit without a start code or a length prefix.
+    func makeNALUnit(_ presentationTimeStamp: CMTime, isHEVC: Bool) -> Data {
+        var rbsp = Data([LatencyProbe.payloadType, LatencyProbe.payloadSize])
+        rbsp.append(withUnsafeBytes(of: uuid.uuid) { Data($0) })
+        rbsp.append(LatencyProbe.makeCaptureTime(presentationTimeStamp).bigEndian.data)
+        rbsp.append(0x80)
+        // nal_unit_type 6 for H.264, 39 (PREFIX_SEI_NUT) for HEVC.
+        var data = isHEVC ? Data([39 << 1, 0x01]) : Data([0x06])
+        data.append(LatencyProbe.escape(rbsp))
+        return data
+    }
+
+    /// Makes a SEI NAL unit with a 4-byte length prefix for an AVCC/HVCC sample.
+    func makeLengthPrefixedNALUnit(_ presentationTimeStamp: CMTime, isHEVC: Bool) -> Data {
+        let unit = makeNALUnit(presentationTimeStamp, isHEVC: isHEVC)
+        var data = UInt32(unit.count).bigEndian.data
+        data.append(unit)
+        return data
+    }
+
+    /// Scans the head of a frame for a probe SEI, and records the latency if found.
+    @discardableResult
+    func probe(_ data: Data) -> Double? {
+        guard let captureTime = read(data) else {
+            return nil
+        }
+        let latency = (Date().timeIntervalSince1970 - Double(captureTime) / 1_000_000_000) * 1000
+        _histogram.mutate { $0.record(latency) }
+        _latency.mutate { $0 = latency }
+        return latency
+    }
+
+    /// Reads a capture time in nanoseconds since 1970 without parsing NAL units.
+    func read(_ data: Data) -> UInt64? {
+        let end = data.startIndex + min(data.count, LatencyProbe.searchLength)
+        guard let range = data.range(of: marker, in: data.startIndex..<end) else {
+            return nil
+        }
+        var value: UInt64 = 0
+        var count = 0
+        var zeros = 0
+        var index = range.upperBound
+        while count < 8 && index < data.endIndex {
+            let byte = data[index]
+            index += 1
+            if 2 <= zeros && byte == 0x03 {
+                zeros = 0
+                continue
+            }
+            zeros = byte == 0 ? zeros + 1 : 0
+            value = value << 8 | UInt64(byte)
+            count += 1
+        }
+        return count == 8 ? value : nil
+    }
+
+    static func makeCaptureTime(_ presentationTimeStamp: CMTime) -> UInt64 {
+        let now = Date().timeIntervalSince1970
+        // Captured samples are stamped with the host time clock.
+        var elapsed = presentationTimeStamp.isValid ? CMClockGetTime(CMClockGetHostTimeClock()).seconds - presentationTimeStamp.seconds : 0
+        if elapsed < 0 || 60 < elapsed {
+            elapsed = 0
+        }
+        return UInt64((now - elapsed) * 1_000_000_000)
+    }
+
+    /// Inserts emulation prevention bytes.
+    static func escape(_ rbsp: Data) -> Data {
+        var data = Data(capacity: rbsp.count + 4)
+        var zeros = 0
+        for byte in rbsp {
+            if 2 <= zeros && byte <= 0x03 {
+                data.append(0x03)
+                zeros = 0
+            }
+            data.append(byte)
+            zeros = byte == 0 ? zeros + 1 : 0
+        }
+        return data
+    }
+}
@@ -68,6 +68,16 @@ struct PESOptionalHeader {
         pesHeaderLength = UInt8(optionalFields.count)
     }
 
+    /// Sets timestamps in 90kHz ticks as they are, without converting them through CMTime.
+    mutating func setTimestamp(presentationTimeStamp: UInt64, decodeTimeStamp: UInt64?) {
+        ptsDtsIndicator = decodeTimeStamp == nil ? PESPTSDTSIndicator.onlyPTS.rawValue : PESPTSDTSIndicator.bothPresent.rawValue
+        optionalFields = TSTimestamp.encode(Int64(presentationTimeStamp & TSTimestamp.mask), ptsDtsIndicator << 4)
+        if let decodeTimeStamp {
+            optionalFields += TSTimestamp.encode(Int64(decodeTimeStamp & TSTimestamp.mask), 0x01 << 4)
+        }
+        pesHeaderLength = UInt8(optionalFields.count)
+    }
+
     func makeSampleTimingInfo(_ previousPresentationTimeStamp: CMTime) -> CMSampleTimingInfo? {
         var presentationTimeStamp: CMTime = .invalid
         var decodeTimeStamp: CMTime = .invalid
@@ -151,12 +161,12 @@ struct PacketizedElementaryStream: PESPacketHeader {
     static let startCode = Data([0x00, 0x00, 0x01])
 
     // swiftlint:disable:next function_parameter_count
-    static func create(_ bytes: UnsafePointer<UInt8>?, count: UInt32, presentationTimeStamp: CMTime, decodeTimeStamp: CMTime, timestamp: CMTime, config: Any?, randomAccessIndicator: Bool) -> PacketizedElementaryStream? {
+    static func create(_ bytes: UnsafePointer<UInt8>?, count: UInt32, presentationTimeStamp: CMTime, decodeTimeStamp: CMTime, timestamp: CMTime, config: Any?, randomAccessIndicator: Bool, nalUnit: Data? = nil) -> PacketizedElementaryStream? {
         if let config: AudioSpecificConfig = config as? AudioSpecificConfig {
             return PacketizedElementaryStream(bytes: bytes, count: count, presentationTimeStamp: presentationTimeStamp, decodeTimeStamp: decodeTimeStamp, timestamp: timestamp, config: config)
         }
         if let config: AVCDecoderConfigurationRecord = config as? AVCDecoderConfigurationRecord {
-            return PacketizedElementaryStream(bytes: bytes, count: count, presentationTimeStamp: presentationTimeStamp, decodeTimeStamp: decodeTimeStamp, timestamp: timestamp, config: randomAccessIndicator ? config : nil)
+            return PacketizedElementaryStream(bytes: bytes, count: count, presentationTimeStamp: presentationTimeStamp, decodeTimeStamp: decodeTimeStamp, timestamp: timestamp, config: randomAccessIndicator ? config : nil, nalUnit: nalUnit)
         }
         return nil
     }
@@ -231,7 +241,8 @@ struct PacketizedElementaryStream: PESPacketHeader {
         }
     }
 
-    init?(bytes: UnsafePointer<UInt8>?, count: UInt32, presentationTimeStamp: CMTime, decodeTimeStamp: CMTime, timestamp: CMTime, config: AVCDecoderConfigurationRecord?) {
+    /// Creates a video PES. The NAL unit without a start code, e.g. a SEI, is put before the NAL units of the frame.
+    init?(bytes: UnsafePointer<UInt8>?, count: UInt32, presentationTimeStamp: CMTime, decodeTimeStamp: CMTime, timestamp: CMTime, config: AVCDecoderConfigurationRecord?, nalUnit: Data? = nil) {
         guard let bytes = bytes else {
             return nil
         }
@@ -244,6 +255,10 @@ struct PacketizedElementaryStream: PESPacketHeader {
         } else {
             data.append(contentsOf: [0x00, 0x00, 0x00, 0x01, 0x09, 0x30])
         }
+        if let nalUnit {
+            data.append(contentsOf: [0x00, 0x00, 0x00, 0x01])
+            data.append(nalUnit)
+        }
         if let stream = AVCFormatStream(bytes: bytes, count: count) {
             data.append(stream.toByteStream())
         }
@@ -260,6 +275,38 @@ struct PacketizedElementaryStream: PESPacketHeader {
         }
     }
 
+    init(data: Data, streamID: UInt8, presentationTimeStamp: UInt64, decodeTimeStamp: UInt64?) {
+        self.data = data
+        self.streamID = streamID
+        var optionalPESHeader = PESOptionalHeader()
+        optionalPESHeader.dataAlignmentIndicator = true
+        optionalPESHeader.setTimestamp(presentationTimeStamp: presentationTimeStamp, decodeTimeStamp: decodeTimeStamp)
+        self.optionalPESHeader = optionalPESHeader
+        // A packet length of 0 is allowed for video elementary streams that don't fit.
+        let length = data.count + optionalPESHeader.data.count
+        packetLength = length < Int(UInt16.max) ? UInt16(length) : 0
+    }
+
+    init?(metadata: TimedMetadata, timestamp: CMTime) {
+        guard !metadata.payload.isEmpty else {
+            return nil
+        }
+        data = metadata.payload
+        optionalPESHeader = PESOptionalHeader()
+        optionalPESHeader?.dataAlignmentIndicator = true
+        optionalPESHeader?.setTimestamp(
+            timestamp,
+            presentationTimeStamp: metadata.timestamp,
+            decodeTimeStamp: CMTime.invalid
+        )
+        let length = data.count + optionalPESHeader!.data.count
+        if length < Int(UInt16.max) {
+            packetLength = UInt16(length)
+        } else {
+            return nil
+        }
+    }
+
     func arrayOfPackets(_ PID: UInt16, PCR: UInt64?) -> [TSPacket] {
         let payload: Data = self.payload
         var packets: [TSPacket] = []
@@ -329,11 +376,14 @@ struct PacketizedElementaryStream: PESPacketHeader {
     mutating func makeSampleBuffer(_ streamType: ESStreamType, previousPresentationTimeStamp: CMTime, formatDescription: CMFormatDescription?) -> CMSampleBuffer? {
         var blockBuffer: CMBlockBuffer?
         var sampleSizes: [Int] = []
+        let timing = optionalPESHeader?.makeSampleTimingInfo(previousPresentationTimeStamp) ?? .invalid
+        var timings: [CMSampleTimingInfo] = []
         switch streamType {
         case .h264:
             _ = AVCFormatStream.toNALFileFormat(&data)
             blockBuffer = data.makeBlockBuffer(advancedBy: 0)
             sampleSizes.append(blockBuffer?.dataLength ?? 0)
+            timings.append(timing)
         case .adtsAac:
             blockBuffer = data.makeBlockBuffer(advancedBy: 0)
             let reader = ADTSReader()
@@ -342,11 +392,26 @@ struct PacketizedElementaryStream: PESPacketHeader {
             while let next = iterator.next() {
                 sampleSizes.append(next)
             }
+            // A PES usually carries several ADTS frames. Each frame gets its own timing so that one CMSampleBuffer covers the whole PES.
+            if let streamBasicDescription = formatDescription?.audioStreamBasicDescription, 0 < streamBasicDescription.mSampleRate {
+                let duration = CMTime(value: CMTimeValue(streamBasicDescription.mFramesPerPacket == 0 ? 1024 : streamBasicDescription.mFramesPerPacket), timescale: CMTimeScale(streamBasicDescription.mSampleRate))
+                for i in 0..<sampleSizes.count {
+                    timings.append(CMSampleTimingInfo(
+                        duration: duration,
+                        presentationTimeStamp: timing.presentationTimeStamp + CMTimeMultiply(duration, multiplier: Int32(i)),
+                        decodeTimeStamp: .invalid
+                    ))
+                }
+            } else {
+                timings.append(timing)
+            }
         default:
             break
         }
+        if timings.isEmpty {
+            timings.append(timing)
+        }
         var sampleBuffer: CMSampleBuffer?
-        var timing = optionalPESHeader?.makeSampleTimingInfo(previousPresentationTimeStamp) ?? .invalid
         guard let blockBuffer, CMSampleBufferCreate(
                 allocator: kCFAllocatorDefault,
                 dataBuffer: blockBuffer,
@@ -355,8 +420,8 @@ struct PacketizedElementaryStream: PESPacketHeader {
                 refcon: nil,
                 formatDescription: formatDescription,
                 sampleCount: sampleSizes.count,
-                sampleTimingEntryCount: 1,
-                sampleTimingArray: &timing,
+                sampleTimingEntryCount: timings.count,
+                sampleTimingArray: &timings,
                 sampleSizeEntryCount: sampleSizes.count,
                 sampleSizeArray: &sampleSizes,
                 sampleBufferOut: &sampleBuffer) == noErr else {
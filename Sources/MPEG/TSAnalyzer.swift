@@ -0,0 +1,504 @@
+import Foundation
+
+/// The interface a TSAnalyzer uses to inform its delegate.
+public protocol TSAnalyzerDelegate: AnyObject {
+    /// Tells the receiver to raise an alarm.
+    func analyzer(_ analyzer: TSAnalyzer, didRaise alarm: TSAnalyzer.Alarm)
+}
+
+// MARK: -
+/// The TSAnalyzer class monitors the health of an MPEG-2 transport stream with the priority 1 and 2 checks of ETSI TR 101 290.
+///
+/// It inspects packet headers, adaptation fields, PSI sections and PES headers in place without reassembling payloads, and keeps counters per PID.
+/// Intervals are measured by the arrival times of live input. Files have no arrival times, so they are measured by the PCRs of the stream, or in bytes at the estimated bit rate of a constant bit rate stream.
+/// An analyzer isn't thread safe. Call it from one queue, as the TSReader of the same input.
+public final class TSAnalyzer {
+    /// An alarm raised by a check.
+    public struct Alarm: Equatable {
+        /// The kinds of alarms.
+        public enum Kind: String, CaseIterable {
+            /// 1.1 The sync was lost after consecutive corrupted sync bytes.
+            case syncLoss
+            /// 1.2 A sync byte isn't 0x47.
+            case syncByteError
+            /// 1.3 The PAT didn't occur every 0.5 seconds, or its table_id or scrambling control is wrong.
+            case patError
+            /// 1.4 A packet is lost, out of order, or repeated more than twice.
+            case continuityCountError
+            /// 1.5 A PMT didn't occur every 0.5 seconds, or its table_id or scrambling control is wrong.
+            case pmtError
+            /// 1.6 A PID referenced by a PMT didn't occur for the PID timeout.
+            case pidError
+            /// 2.1 The transport_error_indicator is set.
+            case transportError
+            /// 2.2 The CRC of a PSI section is wrong.
+            case crcError
+            /// 2.3a The PCR jumped by more than 100 milliseconds without the discontinuity indicator.
+            case pcrDiscontinuityIndicatorError
+            /// 2.3b The interval between PCRs is more than 100 milliseconds.
+            case pcrRepetitionError
+            /// 2.4 The PCR is off by more than 500 nanoseconds from the constant bit rate. It is checked only for a constant bit rate stream.
+            case pcrAccuracyError
+            /// 2.5 The PTS advanced by more than 700 milliseconds between PES headers.
+            case ptsError
+
+            /// The priority of TR 101 290.
+            public var priority: Int {
+                switch self {
+                case .syncLoss, .syncByteError, .patError, .continuityCountError, .pmtError, .pidError:
+                    return 1
+                default:
+                    return 2
+                }
+            }
+        }
+
+        /// The kind.
+        public let kind: Kind
+        /// The PID, or nil for the stream.
+        public let pid: UInt16?
+        /// The byte offset in the stream.
+        public let position: Int64
+    }
+
+    /// The counters of a PID.
+    public struct PIDStatistics {
+        /// The number of packets.
+        public internal(set) var packetCount = 0
+        /// The number of continuity count errors.
+        public internal(set) var continuityCountErrorCount = 0
+        /// The number of packets with the transport error indicator.
+        public internal(set) var transportErrorCount = 0
+        /// The number of packets with a PCR.
+        public internal(set) var pcrCount = 0
+        /// The number of PES headers with a PTS.
+        public internal(set) var ptsCount = 0
+
+        var continuityCounter: UInt8 = 0
+        var hasContinuityCounter = false
+        var isDuplicated = false
+        var presentationTimeStamp: UInt64 = 0
+        var hasPresentationTimeStamp = false
+    }
+
+    /// The PID of null packets.
+    static let nullPID = TSPacket.nullPID
+    /// The number of consecutive sync bytes to acquire the sync.
+    static let syncAcquisitionCount = 5
+    /// The number of consecutive corrupted sync bytes to lose the sync.
+    static let syncLossCount = 2
+    /// The packets between checks of repetition intervals.
+    static let checkInterval = 256
+    static let pcrFrequency: Double = 27_000_000
+    static let pcrModulus: UInt64 = (1 << 33) * 300
+
+    /// Specifies the delegate.
+    public weak var delegate: (any TSAnalyzerDelegate)?
+    /// Specifies the maximum interval of PAT and PMT in seconds.
+    public var sectionInterval: Double = 0.5
+    /// Specifies the seconds a PID referenced by a PMT may be absent.
+    public var pidTimeout: Double = 5
+    /// Specifies the maximum interval of PCR in seconds.
+    public var pcrInterval: Double = 0.1
+    /// Specifies the PCR accuracy in nanoseconds.
+    public var pcrAccuracy: Double = 500
+    /// Specifies the maximum PTS gap in seconds.
+    public var ptsInterval: Double = 0.7
+    /// Specifies whether the stream has a constant bit rate, which enables the PCR accuracy and the intervals in bytes.
+    public var isConstantBitRate = false
+    /// The number of analyzed packets.
+    public private(set) var packetCount = 0
+    /// The number of raised alarms per kind.
+    public private(set) var alarmCounts: [Alarm.Kind: Int] = [:]
+    /// The bit rate estimated from the PCRs in bits per second, or 0 until known.
+    public private(set) var bitRate: Double = 0
+    /// The PIDs seen.
+    public var pids: [UInt16] {
+        slots.indices.filter { slots[$0] != 0 }.map { UInt16($0) }
+    }
+
+    private var slots = [UInt16](repeating: 0, count: 8192)
+    private var states: [PIDStatistics] = [.init()]
+    private var remain = Data()
+    private var processedBytes: Int64 = 0
+    private var isSynchronized = false
+    private var syncErrorCount = 0
+    private var programMapPIDs: Set<UInt16> = []
+    private var referencedPIDs: Set<UInt16> = []
+    private var lastSeenTimes: [UInt16: Double] = [:]
+    private var patTime: Double = 0
+    private var pmtTimes: [UInt16: Double] = [:]
+    private var time: Double = 0
+    private var streamTime: Double = 0
+    private var arrivalTime: Double?
+    private var firstArrivalTime: Double?
+    private var pcrPID: UInt16?
+    private var lastPCR: UInt64 = 0
+    private var lastPCRTime: Double = 0
+    private var lastPCRPosition: Int64 = -1
+    private var firstPCR: UInt64 = 0
+    private var firstPCRPosition: Int64 = -1
+
+    /// Creates a new analyzer.
+    public init() {
+    }
+
+    /// Analyzes the bytes of a stream, which may split packets anywhere.
+    /// - Parameter arrivalTime: The seconds of a monotonic clock when the bytes arrived, or nil for a file.
+    public func analyze(_ data: Data, arrivalTime: TimeInterval? = nil) {
+        if let arrivalTime, firstArrivalTime == nil {
+            firstArrivalTime = arrivalTime
+        }
+        self.arrivalTime = arrivalTime.map { $0 - (firstArrivalTime ?? $0) }
+        if remain.isEmpty {
+            let consumed = process(data)
+            if consumed < data.count {
+                remain = data.subdata(in: data.startIndex + consumed..<data.endIndex)
+            }
+        } else {
+            remain.append(data)
+            let consumed = process(remain)
+            remain = remain.subdata(in: remain.startIndex + consumed..<remain.endIndex)
+        }
+    }
+
+    /// The counters of a PID.
+    public func statistics(of pid: UInt16) -> PIDStatistics? {
+        let slot = Int(slots[Int(pid & 0x1fff)])
+        return slot == 0 ? nil : states[slot]
+    }
+
+    /// Clears the analyzer for a new stream.
+    public func clear() {
+        packetCount = 0
+        alarmCounts.removeAll()
+        bitRate = 0
+        slots = .init(repeating: 0, count: 8192)
+        states = [.init()]
+        remain.removeAll()
+        processedBytes = 0
+        isSynchronized = false
+        syncErrorCount = 0
+        programMapPIDs.removeAll()
+        referencedPIDs.removeAll()
+        lastSeenTimes.removeAll()
+        patTime = 0
+        pmtTimes.removeAll()
+        time = 0
+        streamTime = 0
+        arrivalTime = nil
+        firstArrivalTime = nil
+        pcrPID = nil
+        lastPCRTime = 0
+        lastPCRPosition = -1
+        firstPCRPosition = -1
+    }
+
+    private func process(_ data: Data) -> Int {
+        let consumed = data.withUnsafeBytes { (buffer: UnsafeRawBufferPointer) -> Int in
+            guard let bytes = buffer.baseAddress?.assumingMemoryBound(to: UInt8.self) else {
+                return 0
+            }
+            return process(bytes, count: buffer.count)
+        }
+        processedBytes += Int64(consumed)
+        return consumed
+    }
+
+    private func process(_ bytes: UnsafePointer<UInt8>, count: Int) -> Int {
+        var offset = 0
+        while true {
+            if !isSynchronized {
+                let span = TSPacket.size * (Self.syncAcquisitionCount - 1)
+                while offset + span < count && !isSyncByte(bytes, offset: offset, count: Self.syncAcquisitionCount) {
+                    offset += 1
+                }
+                guard offset + span < count else {
+                    return offset
+                }
+                isSynchronized = true
+                syncErrorCount = 0
+            }
+            guard offset + TSPacket.size <= count else {
+                return offset
+            }
+            let position = processedBytes + Int64(offset)
+            guard bytes[offset] == TSPacket.defaultSyncByte else {
+                raise(.syncByteError, pid: nil, position: position)
+                syncErrorCount += 1
+                if Self.syncLossCount <= syncErrorCount {
+                    raise(.syncLoss, pid: nil, position: position)
+                    isSynchronized = false
+                    offset += 1
+                } else {
+                    offset += TSPacket.size
+                }
+                continue
+            }
+            syncErrorCount = 0
+            analyzePacket(bytes + offset, position: position)
+            offset += TSPacket.size
+        }
+    }
+
+    private func isSyncByte(_ bytes: UnsafePointer<UInt8>, offset: Int, count: Int) -> Bool {
+        for i in 0..<count where bytes[offset + i * TSPacket.size] != TSPacket.defaultSyncByte {
+            return false
+        }
+        return true
+    }
+
+    private func analyzePacket(_ packet: UnsafePointer<UInt8>, position: Int64) {
+        packetCount += 1
+        time = makeTime(position)
+        if packetCount % Self.checkInterval == 0 {
+            checkIntervals(position)
+        }
+        let pid = UInt16(packet[1] & 0x1f) << 8 | UInt16(packet[2])
+        guard pid != Self.nullPID else {
+            return
+        }
+        let transportErrorIndicator = packet[1] & 0x80 != 0
+        let payloadUnitStartIndicator = packet[1] & 0x40 != 0
+        let scramblingControl = packet[3] >> 6
+        let adaptationFieldFlag = packet[3] & 0x20 != 0
+        let payloadFlag = packet[3] & 0x10 != 0
+        let continuityCounter = packet[3] & 0x0f
+
+        var slot = Int(slots[Int(pid)])
+        if slot == 0 {
+            slot = states.count
+            slots[Int(pid)] = UInt16(slot)
+            states.append(.init())
+        }
+        states[slot].packetCount += 1
+        if referencedPIDs.contains(pid) {
+            lastSeenTimes[pid] = time
+        }
+        if transportErrorIndicator {
+            states[slot].transportErrorCount += 1
+            raise(.transportError, pid: pid, position: position)
+        }
+
+        var payloadOffset = TSPacket.headerSize
+        var discontinuityIndicator = false
+        var pcr: UInt64?
+        if adaptationFieldFlag {
+            let length = Int(packet[4])
+            payloadOffset += 1 + length
+            if 0 < length {
+                let flags = packet[5]
+                discontinuityIndicator = flags & 0x80 != 0
+                if flags & 0x10 != 0 && TSAdaptationField.PCRSize < length {
+                    let base = UInt64(packet[6]) << 25 | UInt64(packet[7]) << 17 | UInt64(packet[8]) << 9 | UInt64(packet[9]) << 1 | UInt64(packet[10]) >> 7
+                    pcr = base * 300 + (UInt64(packet[10] & 0x01) << 8 | UInt64(packet[11]))
+                }
+            }
+        }
+
+        if payloadFlag {
+            checkContinuityCounter(slot, continuityCounter, discontinuityIndicator: discontinuityIndicator, pid: pid, position: position)
+        }
+        if let pcr {
+            states[slot].pcrCount += 1
+            if pcrPID == nil {
+                pcrPID = pid
+            }
+            if pcrPID == pid {
+                analyzePCR(pcr, discontinuityIndicator: discontinuityIndicator, position: position)
+            }
+        }
+        guard payloadFlag && payloadUnitStartIndicator && payloadOffset < TSPacket.size else {
+            return
+        }
+        if pid == TSWriter.defaultPATPID {
+            analyzeSection(packet, offset: payloadOffset, kind: .patError, tableID: TSProgramAssociation.tableID, scramblingControl: scramblingControl, pid: pid, position: position)
+        } else if programMapPIDs.contains(pid) {
+            analyzeSection(packet, offset: payloadOffset, kind: .pmtError, tableID: TSProgramMap.tableID, scramblingControl: scramblingControl, pid: pid, position: position)
+        } else if scramblingControl == 0 {
+            analyzePESHeader(packet, offset: payloadOffset, slot: slot, pid: pid, position: position)
+        }
+    }
+
+    private func checkContinuityCounter(_ slot: Int, _ continuityCounter: UInt8, discontinuityIndicator: Bool, pid: UInt16, position: Int64) {
+        defer {
+            states[slot].continuityCounter = continuityCounter
+            states[slot].hasContinuityCounter = true
+        }
+        guard states[slot].hasContinuityCounter && !discontinuityIndicator else {
+            states[slot].isDuplicated = false
+            return
+        }
+        let previous = states[slot].continuityCounter
+        if continuityCounter == previous {
+            // A packet may be sent twice.
+            if states[slot].isDuplicated {
+                states[slot].continuityCountErrorCount += 1
+                raise(.continuityCountError, pid: pid, position: position)
+            }
+            states[slot].isDuplicated = true
+            return
+        }
+        states[slot].isDuplicated = false
+        if continuityCounter != (previous + 1) & 0x0f {
+            states[slot].continuityCountErrorCount += 1
+            raise(.continuityCountError, pid: pid, position: position)
+        }
+    }
+
+    private func analyzePCR(_ pcr: UInt64, discontinuityIndicator: Bool, position: Int64) {
+        defer {
+            lastPCR = pcr
+            lastPCRTime = time
+            lastPCRPosition = position
+        }
+        guard 0 <= lastPCRPosition else {
+            firstPCR = pcr
+            firstPCRPosition = position
+            return
+        }
+        if let elapsed = elapsedSinceLastPCR(), pcrInterval < elapsed {
+            raise(.pcrRepetitionError, pid: pcrPID, position: position)
+        }
+        // A variable bit rate stream has no expected PCR in bytes.
+        if isConstantBitRate && 0 < bitRate {
+            let bytes = Double(position - lastPCRPosition)
+            let expected = (lastPCR + UInt64(bytes * 8 / bitRate * Self.pcrFrequency)) % Self.pcrModulus
+            let error = Self.distance(pcr, expected)
+            if pcrAccuracy < Double(error) / Self.pcrFrequency * 1_000_000_000 && !discontinuityIndicator {
+                raise(.pcrAccuracyError, pid: pcrPID, position: position)
+            }
+        }
+        let delta = (pcr + Self.pcrModulus - lastPCR) % Self.pcrModulus
+        let isDiscontinuous = Self.pcrModulus / 2 < delta || pcrInterval * Self.pcrFrequency < Double(delta)
+        if !isDiscontinuous {
+            streamTime += Double(delta) / Self.pcrFrequency
+        }
+        if isDiscontinuous || discontinuityIndicator {
+            if isDiscontinuous && !discontinuityIndicator {
+                raise(.pcrDiscontinuityIndicatorError, pid: pcrPID, position: position)
+            }
+            // The bit rate is estimated again from the new time base.
+            firstPCR = pcr
+            firstPCRPosition = position
+            return
+        }
+        let duration = Double((pcr + Self.pcrModulus - firstPCR) % Self.pcrModulus) / Self.pcrFrequency
+        if 0 < duration {
+            bitRate = Double(position - firstPCRPosition) * 8 / duration
+        }
+    }
+
+    // swiftlint:disable:next function_parameter_count
+    private func analyzeSection(_ packet: UnsafePointer<UInt8>, offset: Int, kind: Alarm.Kind, tableID: UInt8, scramblingControl: UInt8, pid: UInt16, position: Int64) {
+        let start = offset + 1 + Int(packet[offset])
+        guard scramblingControl == 0, start + 3 <= TSPacket.size, packet[start] == tableID else {
+            raise(kind, pid: pid, position: position)
+            return
+        }
+        let sectionLength = Int(packet[start + 1] & 0x0f) << 8 | Int(packet[start + 2])
+        // A section that continues in the next packets isn't checked.
+        guard start + 3 + sectionLength <= TSPacket.size else {
+            return
+        }
+        let section = Data(bytes: packet + start, count: 3 + sectionLength)
+        guard 9 <= sectionLength, CRC32.mpeg2.calculate(section) == 0 else {
+            raise(.crcError, pid: pid, position: position)
+            return
+        }
+        let payload = Data(bytes: packet + offset, count: TSPacket.size - offset)
+        switch kind {
+        case .patError:
+            patTime = time
+            if let pat = TSProgramAssociation(payload) {
+                // The program number 0 points to the network information table.
+                programMapPIDs = Set(pat.programs.filter { $0.key != 0 }.values)
+            }
+        default:
+            pmtTimes[pid] = time
+            if let pmt = TSProgramMap(payload) {
+                if pmt.PCRPID != TSProgramMap.unusedPCRID {
+                    pcrPID = pmt.PCRPID
+                }
+                for data in pmt.elementaryStreamSpecificData where !referencedPIDs.contains(data.elementaryPID) {
+                    referencedPIDs.insert(data.elementaryPID)
+                    lastSeenTimes[data.elementaryPID] = time
+                }
+            }
+        }
+    }
+
+    private func analyzePESHeader(_ packet: UnsafePointer<UInt8>, offset: Int, slot: Int, pid: UInt16, position: Int64) {
+        guard
+            offset + 14 <= TSPacket.size,
+            packet[offset] == 0, packet[offset + 1] == 0, packet[offset + 2] == 1,
+            packet[offset + 7] & 0x80 != 0 else {
+            return
+        }
+        let pts = packet + offset + 9
+        var value = UInt64(pts[0] & 0x0e) << 29
+        value |= UInt64(pts[1]) << 22 | UInt64(pts[2] & 0xfe) << 14
+        value |= UInt64(pts[3]) << 7 | UInt64(pts[4] >> 1)
+        states[slot].ptsCount += 1
+        defer {
+            states[slot].presentationTimeStamp = value
+            states[slot].hasPresentationTimeStamp = true
+        }
+        guard states[slot].hasPresentationTimeStamp else {
+            return
+        }
+        let delta = (value &- states[slot].presentationTimeStamp) & TSTimestamp.mask
+        // A PTS behind the previous one is reordered, e.g. B-frames.
+        if delta < TSTimestamp.mask / 2 && ptsInterval * TSTimestamp.resolution < Double(delta) {
+            raise(.ptsError, pid: pid, position: position)
+        }
+    }
+
+    private func checkIntervals(_ position: Int64) {
+        if sectionInterval < time - patTime {
+            raise(.patError, pid: TSWriter.defaultPATPID, position: position)
+            patTime = time
+        }
+        for pid in programMapPIDs where sectionInterval < time - (pmtTimes[pid] ?? 0) {
+            raise(.pmtError, pid: pid, position: position)
+            pmtTimes[pid] = time
+        }
+        for (pid, lastSeenTime) in lastSeenTimes where pidTimeout < time - lastSeenTime {
+            raise(.pidError, pid: pid, position: position)
+            lastSeenTimes[pid] = time
+        }
+        if let elapsed = elapsedSinceLastPCR(), pcrInterval < elapsed {
+            raise(.pcrRepetitionError, pid: pcrPID, position: position)
+        }
+    }
+
+    /// Makes the seconds from the start of the stream at a byte offset.
+    private func makeTime(_ position: Int64) -> Double {
+        if let arrivalTime {
+            return arrivalTime
+        }
+        if isConstantBitRate && 0 < bitRate {
+            return Double(position) * 8 / bitRate
+        }
+        // The PCRs of a variable bit rate stream are its only clock, which stops while the PCR PID is missing.
+        return streamTime
+    }
+
+    /// The seconds since the last PCR, or nil when measured by the PCRs themselves, which the discontinuity check covers.
+    private func elapsedSinceLastPCR() -> Double? {
+        guard 0 <= lastPCRPosition, arrivalTime != nil || isConstantBitRate else {
+            return nil
+        }
+        return time - lastPCRTime
+    }
+
+    private func raise(_ kind: Alarm.Kind, pid: UInt16?, position: Int64) {
+        alarmCounts[kind, default: 0] += 1
+        delegate?.analyzer(self, didRaise: .init(kind: kind, pid: pid, position: position))
+    }
+
+    private static func distance(_ lhs: UInt64, _ rhs: UInt64) -> UInt64 {
+        let delta = (lhs + pcrModulus - rhs) % pcrModulus
+        return min(delta, pcrModulus - delta)
+    }
+}
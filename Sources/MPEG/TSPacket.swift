@@ -6,6 +6,8 @@ struct TSPacket {
     static let size: Int = 188
     static let headerSize: Int = 4
     static let defaultSyncByte: UInt8 = 0x47
+    /// The PID of null packets, which only pad the bit rate.
+    static let nullPID: UInt16 = 0x1fff
 
     var syncByte: UInt8 = TSPacket.defaultSyncByte
     var transportErrorIndicator = false
@@ -127,12 +129,14 @@ enum TSTimestamp {
     static let dataSize: Int = 5
     static let ptsMask: UInt8 = 0x10
     static let ptsDtsMask: UInt8 = 0x30
+    /// The mask of a 33-bit timestamp.
+    static let mask: UInt64 = 0x1_FFFF_FFFF
 
     static func decode(_ data: Data, offset: Int = 0) -> Int64 {
         var result: Int64 = 0
         result |= Int64(data[offset + 0] & 0x0e) << 29
         result |= Int64(data[offset + 1]) << 22 | Int64(data[offset + 2] & 0xfe) << 14
-        result |= Int64(data[offset + 3]) << 7 | Int64(data[offset + 3] & 0xfe) << 1
+        result |= Int64(data[offset + 3]) << 7 | Int64(data[offset + 4] >> 1)
         return result
     }
 
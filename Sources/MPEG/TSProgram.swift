@@ -161,6 +161,11 @@ final class TSProgramMap: TSProgram {
 
     var PCRPID: UInt16 = 0
     var programInfoLength: UInt16 = 0
+    var programDescriptors = Data() {
+        didSet {
+            programInfoLength = UInt16(programDescriptors.count)
+        }
+    }
     var elementaryStreamSpecificData: [ESSpecificData] = []
 
     override init() {
@@ -185,6 +190,7 @@ final class TSProgramMap: TSProgram {
             return ByteArray()
                 .writeUInt16(PCRPID | 0xe000)
                 .writeUInt16(programInfoLength | 0xf000)
+                .writeBytes(programDescriptors)
                 .writeBytes(bytes)
                 .data
         }
@@ -193,7 +199,7 @@ final class TSProgramMap: TSProgram {
             do {
                 PCRPID = try buffer.readUInt16() & 0x1fff
                 programInfoLength = try buffer.readUInt16() & 0x03ff
-                buffer.position += Int(programInfoLength)
+                programDescriptors = try buffer.readBytes(Int(programInfoLength))
                 var position = 0
                 while 0 < buffer.bytesAvailable {
                     position = buffer.position
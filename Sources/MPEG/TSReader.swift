@@ -6,12 +6,26 @@ import Logboard
 public protocol TSReaderDelegate: AnyObject {
     func reader(_ reader: TSReader, id: UInt16, didRead formatDescription: CMFormatDescription)
     func reader(_ reader: TSReader, id: UInt16, didRead sampleBuffer: CMSampleBuffer)
+    func reader(_ reader: TSReader, id: UInt16, didRead metadata: TimedMetadata)
 }
 
+extension TSReaderDelegate {
+    /// Tells the receiver to a timed metadata incoming. Its default implementation does nothing.
+    public func reader(_ reader: TSReader, id: UInt16, didRead metadata: TimedMetadata) {
+    }
+}
+
+// MARK: -
 /// The TSReader class represents read MPEG-2 transport stream data.
 public class TSReader {
     /// Specifies the delegate object.
     public weak var delegate: (any TSReaderDelegate)?
+    /// Specifies the latency probe that measures capture times embedded in video frames.
+    public var latencyProbe: LatencyProbe?
+    /// The number of read packets.
+    public private(set) var packetCount = 0
+    /// The number of discarded duplicate packets.
+    public private(set) var duplicatePacketCount = 0
 
     private var pat: TSProgramAssociation? {
         didSet {
@@ -44,6 +58,7 @@ public class TSReader {
     private var formatDescriptions: [UInt16: CMFormatDescription] = [:]
     private var packetizedElementaryStreams: [UInt16: PacketizedElementaryStream] = [:]
     private var previousPresentationTimeStamps: [UInt16: CMTime] = [:]
+    private var previousPackets: [UInt16: Data] = [:]
 
     /// Create a  new TSReader instance.
     public init() {
@@ -53,7 +68,13 @@ public class TSReader {
     public func read(_ data: Data) -> Int {
         let count = data.count / TSPacket.size
         for i in 0..<count {
-            guard let packet = TSPacket(data: data.subdata(in: i * TSPacket.size..<(i + 1) * TSPacket.size)) else {
+            let bytes = data.subdata(in: data.startIndex + i * TSPacket.size..<data.startIndex + (i + 1) * TSPacket.size)
+            guard let packet = TSPacket(data: bytes) else {
+                continue
+            }
+            packetCount += 1
+            if isDuplicate(packet, bytes: bytes) {
+                duplicatePacketCount += 1
                 continue
             }
             if packet.pid == 0x0000 {
@@ -78,9 +99,29 @@ public class TSReader {
         formatDescriptions.removeAll()
         packetizedElementaryStreams.removeAll()
         previousPresentationTimeStamps.removeAll()
+        previousPackets.removeAll()
+        packetCount = 0
+        duplicatePacketCount = 0
+    }
+
+    /// Returns whether a packet repeats the previous one of the same PID, as redundant links and ISO/IEC 13818-1 duplicate packets do.
+    /// Such a packet carries the same continuity_counter and must be discarded before it corrupts the PES.
+    private func isDuplicate(_ packet: TSPacket, bytes: Data) -> Bool {
+        // Packets without a payload don't increment the continuity_counter, and null packets carry an undefined one that muxers repeat freely.
+        guard packet.payloadFlag, packet.pid != TSPacket.nullPID else {
+            return false
+        }
+        defer {
+            previousPackets[packet.pid] = bytes
+        }
+        return previousPackets[packet.pid] == bytes
     }
 
     private func readPacketizedElementaryStream(_ packet: TSPacket) {
+        if esSpecData[packet.pid]?.streamType == .metadata {
+            readTimedMetadata(packet)
+            return
+        }
         if packet.payloadUnitStartIndicator {
             if let sampleBuffer = makeSampleBuffer(packet.pid, forUpdate: true) {
                 delegate?.reader(self, id: packet.pid, didRead: sampleBuffer)
@@ -94,6 +135,36 @@ public class TSReader {
         }
     }
 
+    private func readTimedMetadata(_ packet: TSPacket) {
+        if packet.payloadUnitStartIndicator {
+            if let metadata = makeTimedMetadata(packet.pid, forUpdate: true) {
+                delegate?.reader(self, id: packet.pid, didRead: metadata)
+            }
+            packetizedElementaryStreams[packet.pid] = PacketizedElementaryStream(packet.payload)
+        } else {
+            _ = packetizedElementaryStreams[packet.pid]?.append(packet.payload)
+        }
+        // Metadata usually fits in a single packet so that it is delivered as soon as it is entired.
+        if let metadata = makeTimedMetadata(packet.pid) {
+            delegate?.reader(self, id: packet.pid, didRead: metadata)
+        }
+    }
+
+    private func makeTimedMetadata(_ id: UInt16, forUpdate: Bool = false) -> TimedMetadata? {
+        guard
+            let pes = packetizedElementaryStreams[id], pes.isEntired || forUpdate,
+            let timing = pes.optionalPESHeader?.makeSampleTimingInfo(.invalid) else {
+            return nil
+        }
+        defer {
+            packetizedElementaryStreams[id] = nil
+        }
+        // The packet length counts the optional PES header, i.e. the flags, the header data length byte and the header data.
+        let headerLength = PESOptionalHeader.fixedSectionSize + Int(pes.optionalPESHeader?.pesHeaderLength ?? 0)
+        let length = headerLength < pes.packetLength ? min(pes.data.count, Int(pes.packetLength) - headerLength) : pes.data.count
+        return TimedMetadata(timestamp: timing.presentationTimeStamp, payload: pes.data.prefix(length))
+    }
+
     private func makeSampleBuffer(_ id: UInt16, forUpdate: Bool = false) -> CMSampleBuffer? {
         guard
             let data = esSpecData[id],
@@ -112,10 +183,15 @@ public class TSReader {
         var isNotSync = true
         switch data.streamType {
         case .h264:
+            latencyProbe?.probe(pes.data)
             let units = nalUnitReader.read(pes.data)
-            if let unit = units.first(where: { $0.type == .idr || $0.type == .slice }) {
-                var data = Data([0x00, 0x00, 0x00, 0x01])
+            // Keeps every slice and SEI of an access unit. Parameter sets are carried by the format description.
+            var data = Data()
+            for unit in units.reversed() where unit.type != .aud && unit.type != .sps && unit.type != .pps {
+                data.append(contentsOf: [0x00, 0x00, 0x00, 0x01])
                 data.append(unit.data)
+            }
+            if !data.isEmpty {
                 pes.data = data
             }
             isNotSync = !units.contains { $0.type == .idr }
@@ -18,15 +18,39 @@ public final class TSWriter {
     public static let defaultPMTPID: UInt16 = 4095
     public static let defaultVideoPID: UInt16 = 256
     public static let defaultAudioPID: UInt16 = 257
+    public static let defaultMetadataPID: UInt16 = 258
 
     public static let defaultSegmentDuration: Double = 2
 
+    /// The PES stream_id for a metadata stream.
+    static let metadataStreamID: UInt8 = 0xFC
+    /// The metadata_pointer_descriptor of the program that points to the ID3 metadata stream, as HLS timed metadata requires.
+    static let metadataPointerDescriptor = Data([
+        0x25, 15,
+        // metadata_application_format = 0xFFFF, metadata_application_format_identifier = 'ID3 '
+        0xFF, 0xFF, 0x49, 0x44, 0x33, 0x20,
+        // metadata_format = 0xFF, metadata_format_identifier = 'ID3 '
+        0xFF, 0x49, 0x44, 0x33, 0x20,
+        // metadata_service_id = 0, metadata_locator_record_flag = 0, MPEG_carriage_flags = 0, program_number = 1
+        0x00, 0x1F, 0x00, 0x01
+    ])
+    /// The metadata_descriptor of the ID3 metadata stream.
+    static let metadataDescriptor = Data([
+        0x26, 13,
+        0xFF, 0xFF, 0x49, 0x44, 0x33, 0x20,
+        0xFF, 0x49, 0x44, 0x33, 0x20,
+        // metadata_service_id = 0, decoder_config_flags = 0, DSM-CC_flag = 0
+        0x00, 0x0F
+    ])
+
     /// The delegate instance.
     public weak var delegate: (any TSWriterDelegate)?
     /// This instance is running to process(true) or not(false).
     public internal(set) var isRunning: Atomic<Bool> = .init(false)
     /// The exptected medias = [.video, .audio].
     public var expectedMedias: Set<AVMediaType> = []
+    /// Specifies the latency probe that embeds capture times into video frames.
+    public var latencyProbe: LatencyProbe?
 
     public var audioFormat: AVAudioFormat? {
         didSet {
@@ -60,6 +84,7 @@ public final class TSWriter {
 
     var audioContinuityCounter: UInt8 = 0
     var videoContinuityCounter: UInt8 = 0
+    var metadataContinuityCounter: UInt8 = 0
     var PCRPID: UInt16 = TSWriter.defaultVideoPID
     var rotatedTimestamp = CMTime.zero
     var segmentDuration: Double = TSWriter.defaultSegmentDuration
@@ -84,6 +109,8 @@ public final class TSWriter {
     private var videoTimestamp: CMTime = .invalid
     private var audioTimestamp: CMTime = .invalid
     private var PCRTimestamp = CMTime.zero
+    private var metadatas = TimedMetadataQueue()
+    private var hasMetadataStream = false
     private var canWriteFor: Bool {
         guard expectedMedias.isEmpty else {
             return true
@@ -105,7 +132,7 @@ public final class TSWriter {
     }
 
     // swiftlint:disable:next function_parameter_count
-    final func writeSampleBuffer(_ PID: UInt16, streamID: UInt8, bytes: UnsafePointer<UInt8>?, count: UInt32, presentationTimeStamp: CMTime, decodeTimeStamp: CMTime, randomAccessIndicator: Bool) {
+    final func writeSampleBuffer(_ PID: UInt16, streamID: UInt8, bytes: UnsafePointer<UInt8>?, count: UInt32, presentationTimeStamp: CMTime, decodeTimeStamp: CMTime, randomAccessIndicator: Bool, nalUnit: Data? = nil) {
         guard canWriteFor else {
             return
         }
@@ -134,7 +161,8 @@ public final class TSWriter {
                 decodeTimeStamp: decodeTimeStamp,
                 timestamp: PID == TSWriter.defaultVideoPID ? videoTimestamp : audioTimestamp,
                 config: streamID == 192 ? audioConfig : videoConfig,
-                randomAccessIndicator: randomAccessIndicator) else {
+                randomAccessIndicator: randomAccessIndicator,
+                nalUnit: nalUnit) else {
             return
         }
 
@@ -146,19 +174,22 @@ public final class TSWriter {
 
         packets[0].adaptationField?.randomAccessIndicator = randomAccessIndicator
 
-        var bytes = Data()
-        for var packet in packets {
-            switch PID {
-            case TSWriter.defaultAudioPID:
-                packet.continuityCounter = audioContinuityCounter
-                audioContinuityCounter = (audioContinuityCounter + 1) & 0x0f
-            case TSWriter.defaultVideoPID:
-                packet.continuityCounter = videoContinuityCounter
-                videoContinuityCounter = (videoContinuityCounter + 1) & 0x0f
-            default:
-                break
+        let metadata = makeMetadataPackets(PID, presentationTimeStamp: presentationTimeStamp)
+        let bytes = BufferPool.shared.makeData(count: metadata.count + packets.count * TSPacket.size) { pointer in
+            var offset = metadata.copyBytes(to: pointer)
+            for var packet in packets {
+                switch PID {
+                case TSWriter.defaultAudioPID:
+                    packet.continuityCounter = audioContinuityCounter
+                    audioContinuityCounter = (audioContinuityCounter + 1) & 0x0f
+                case TSWriter.defaultVideoPID:
+                    packet.continuityCounter = videoContinuityCounter
+                    videoContinuityCounter = (videoContinuityCounter + 1) & 0x0f
+                default:
+                    break
+                }
+                offset += packet.data.copyBytes(to: UnsafeMutableRawBufferPointer(rebasing: pointer[offset...]))
             }
-            bytes.append(packet.data)
         }
 
         write(bytes)
@@ -200,6 +231,42 @@ public final class TSWriter {
         writeProgram()
     }
 
+    private func makeMetadataPackets(_ PID: UInt16, presentationTimeStamp: CMTime) -> Data {
+        // Metadata rides along with video frames, or with audio frames on an audio only stream.
+        guard !metadatas.isEmpty, PID == (videoConfig == nil ? TSWriter.defaultAudioPID : TSWriter.defaultVideoPID) else {
+            return Data()
+        }
+        let metadatas = self.metadatas.dequeue(presentationTimeStamp)
+        guard !metadatas.isEmpty else {
+            return Data()
+        }
+        if !hasMetadataStream {
+            var data = ESSpecificData()
+            data.streamType = .metadata
+            data.elementaryPID = TSWriter.defaultMetadataPID
+            data.esDescriptors = TSWriter.metadataDescriptor
+            data.esInfoLength = UInt16(TSWriter.metadataDescriptor.count)
+            PMT.programDescriptors = TSWriter.metadataPointerDescriptor
+            PMT.elementaryStreamSpecificData.append(data)
+            hasMetadataStream = true
+            writeProgram()
+        }
+        let timestamp = videoConfig == nil ? audioTimestamp : videoTimestamp
+        var bytes = Data()
+        for metadata in metadatas {
+            guard var PES = PacketizedElementaryStream(metadata: metadata, timestamp: timestamp) else {
+                continue
+            }
+            PES.streamID = TSWriter.metadataStreamID
+            for var packet in PES.arrayOfPackets(TSWriter.defaultMetadataPID, PCR: nil) {
+                packet.continuityCounter = metadataContinuityCounter
+                metadataContinuityCounter = (metadataContinuityCounter + 1) & 0x0f
+                bytes.append(packet.data)
+            }
+        }
+        return bytes
+    }
+
     private func split(_ PID: UInt16, PES: PacketizedElementaryStream, timestamp: CMTime) -> [TSPacket] {
         var PCR: UInt64?
         let duration: Double = timestamp.seconds - PCRTimestamp.seconds
@@ -251,9 +318,15 @@ extension TSWriter: IOMuxer {
             count: UInt32(length),
             presentationTimeStamp: sampleBuffer.presentationTimeStamp,
             decodeTimeStamp: sampleBuffer.decodeTimeStamp,
-            randomAccessIndicator: !sampleBuffer.isNotSync
+            randomAccessIndicator: !sampleBuffer.isNotSync,
+            // The SEI is written into the PES on its own, so the frame isn't copied to put it in front.
+            nalUnit: latencyProbe?.makeNALUnit(sampleBuffer.presentationTimeStamp, isHEVC: false)
         )
     }
+
+    public func append(_ metadata: TimedMetadata) {
+        metadatas.enqueue(metadata)
+    }
 }
 
 extension TSWriter: Running {
@@ -270,6 +343,9 @@ extension TSWriter: Running {
         }
         audioContinuityCounter = 0
         videoContinuityCounter = 0
+        metadataContinuityCounter = 0
+        metadatas.clear()
+        hasMetadataStream = false
         PCRPID = TSWriter.defaultVideoPID
         PAT.programs.removeAll()
         PAT.programs = [1: TSWriter.defaultPMTPID]
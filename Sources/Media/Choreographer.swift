@@ -82,6 +82,27 @@ import QuartzCore
 typealias DisplayLink = CADisplayLink
 #endif
 
+/// The clock that paces the frames of the playback.
+public enum ChoreographerMode: Equatable {
+    /// Paces frames with the display while one is attached, and with a timer otherwise.
+    case automatic
+    /// Paces frames with the refresh of the display.
+    case displayLink
+    /// Paces frames with a monotonic timer, for headless playback and relays.
+    case timer(preferredFramesPerSecond: Int)
+
+    func makeChoreographer() -> any Choreographer {
+        switch self {
+        case .automatic:
+            return DisplayLinkChoreographer.isAvailable ? DisplayLinkChoreographer() : TimerChoreographer()
+        case .displayLink:
+            return DisplayLinkChoreographer()
+        case .timer(let preferredFramesPerSecond):
+            return TimerChoreographer(preferredFramesPerSecond: preferredFramesPerSecond)
+        }
+    }
+}
+
 protocol ChoreographerDelegate: AnyObject {
     func choreographer(_ choreographer: any Choreographer, didFrame duration: Double)
 }
@@ -97,6 +118,16 @@ final class DisplayLinkChoreographer: NSObject, Choreographer {
     private static let duration = 0.0
     private static let preferredFramesPerSecond = 0
 
+    /// Whether a display is attached to drive the display link.
+    static var isAvailable: Bool {
+        #if os(macOS)
+        var displayLink: CVDisplayLink?
+        return CVDisplayLinkCreateWithActiveCGDisplays(&displayLink) == kCVReturnSuccess && displayLink != nil
+        #else
+        return true
+        #endif
+    }
+
     var isPaused: Bool {
         get {
             displayLink?.isPaused ?? true
@@ -143,3 +174,168 @@ extension DisplayLinkChoreographer: Running {
         isRunning.mutate { $0 = false }
     }
 }
+
+// MARK: -
+/// The TimerChoreographer class paces frames with a monotonic timer instead of a display, for headless playback and relays.
+final class TimerChoreographer: Choreographer {
+    static let defaultPreferredFramesPerSecond = 60
+
+    var isPaused: Bool {
+        get {
+            _isPaused.value
+        }
+        set {
+            guard _isPaused.value != newValue else {
+                return
+            }
+            let now = DispatchTime.now().uptimeNanoseconds
+            _isPaused.mutate { $0 = newValue }
+            clock.mutate {
+                if newValue {
+                    $0.elapsed += now - $0.resumedAt
+                } else {
+                    $0.resumedAt = now
+                }
+            }
+        }
+    }
+    weak var delegate: (any ChoreographerDelegate)?
+    var isRunning: Atomic<Bool> = .init(false)
+    /// The frame rate of the timer. Choreographers with the same frame rate share one timer.
+    let preferredFramesPerSecond: Int
+    private var _isPaused: Atomic<Bool> = .init(true)
+    private var clock: Atomic<(elapsed: UInt64, resumedAt: UInt64)> = .init((0, 0))
+
+    init(preferredFramesPerSecond: Int = TimerChoreographer.defaultPreferredFramesPerSecond) {
+        self.preferredFramesPerSecond = max(1, preferredFramesPerSecond)
+    }
+
+    func clear() {
+        clock.mutate {
+            $0.elapsed = 0
+            $0.resumedAt = DispatchTime.now().uptimeNanoseconds
+        }
+    }
+
+    fileprivate func update(_ now: UInt64) {
+        guard !_isPaused.value else {
+            return
+        }
+        let clock = self.clock.value
+        // The duration comes from the monotonic clock, so late ticks never accumulate drift.
+        delegate?.choreographer(self, didFrame: Double(clock.elapsed + now - min(now, clock.resumedAt)) / 1_000_000_000)
+    }
+}
+
+extension TimerChoreographer: Running {
+    func startRunning() {
+        guard !isRunning.value else {
+            return
+        }
+        clear()
+        ChoreographerTimer.shared(preferredFramesPerSecond).add(self)
+        isRunning.mutate { $0 = true }
+    }
+
+    func stopRunning() {
+        guard isRunning.value else {
+            return
+        }
+        ChoreographerTimer.shared(preferredFramesPerSecond).remove(self)
+        isPaused = true
+        clear()
+        isRunning.mutate { $0 = false }
+    }
+}
+
+// MARK: -
+/// The ChoreographerTimer class drives every TimerChoreographer of the same frame rate from one timer.
+final class ChoreographerTimer {
+    private static var timers: Atomic<[Int: ChoreographerTimer]> = .init([:])
+
+    /// Returns the shared timer for the frame rate.
+    static func shared(_ framesPerSecond: Int) -> ChoreographerTimer {
+        var timer: ChoreographerTimer?
+        timers.mutate {
+            if let shared = $0[framesPerSecond] {
+                timer = shared
+            } else {
+                timer = ChoreographerTimer(framesPerSecond: framesPerSecond)
+                $0[framesPerSecond] = timer
+            }
+        }
+        return timer!
+    }
+
+    /// The number of attached choreographers.
+    var count: Int {
+        lockQueue.sync { targets.count }
+    }
+    /// The interval between ticks in nanoseconds.
+    let interval: UInt64
+    private let lockQueue = DispatchQueue(label: "com.haishinkit.HaishinKit.ChoreographerTimer.lock", qos: .userInteractive)
+    private var timer: DispatchSourceTimer?
+    private var targets: [ObjectIdentifier: WeakReference] = [:]
+    private var startedAt: UInt64 = 0
+    private var tick: UInt64 = 0
+
+    private init(framesPerSecond: Int) {
+        interval = 1_000_000_000 / UInt64(max(1, framesPerSecond))
+    }
+
+    func add(_ choreographer: TimerChoreographer) {
+        lockQueue.async {
+            self.targets[ObjectIdentifier(choreographer)] = WeakReference(choreographer)
+            guard self.timer == nil else {
+                return
+            }
+            self.startedAt = DispatchTime.now().uptimeNanoseconds
+            self.tick = 0
+            let timer = DispatchSource.makeTimerSource(flags: .strict, queue: self.lockQueue)
+            timer.setEventHandler { [weak self] in
+                self?.fire()
+            }
+            self.timer = timer
+            self.schedule()
+            timer.resume()
+        }
+    }
+
+    func remove(_ choreographer: TimerChoreographer) {
+        lockQueue.async {
+            self.targets[ObjectIdentifier(choreographer)] = nil
+            if self.targets.isEmpty {
+                self.timer?.cancel()
+                self.timer = nil
+            }
+        }
+    }
+
+    private func fire() {
+        let now = DispatchTime.now().uptimeNanoseconds
+        targets = targets.filter { $0.value.value != nil }
+        for target in targets.values {
+            target.value?.update(now)
+        }
+        guard !targets.isEmpty else {
+            timer?.cancel()
+            timer = nil
+            return
+        }
+        // Deadlines are absolute multiples of the interval. Missed ticks are skipped, not queued.
+        tick = max(tick + 1, (now - startedAt) / interval)
+        schedule()
+    }
+
+    private func schedule() {
+        timer?.schedule(deadline: DispatchTime(uptimeNanoseconds: startedAt + (tick + 1) * interval), leeway: .nanoseconds(0))
+    }
+
+    private final class WeakReference {
+        weak var value: TimerChoreographer?
+
+        init(_ value: TimerChoreographer) {
+            self.value = value
+        }
+    }
+}
@@ -0,0 +1,362 @@
+import AVFoundation
+import Foundation
+
+/// The interface an IOFragmentedRecorder uses to inform its delegate.
+public protocol IOFragmentedRecorderDelegate: AnyObject {
+    /// Tells the receiver to an error occured.
+    func recorder(_ recorder: IOFragmentedRecorder, errorOccured error: IOFragmentedRecorder.Error)
+    /// Tells the receiver to finish writing a file.
+    func recorder(_ recorder: IOFragmentedRecorder, didFinishFile url: URL)
+}
+
+// MARK: -
+/// The IOFragmentedRecorder class records encoded samples into MPEG-2 TS files without re-encoding.
+///
+/// Every prefix of a file written in fragments is playable, so that a recording survives the app being killed. The file is synchronized to
+/// the storage at each fragment boundary, and rolled by duration or size at a keyframe. Finishing a file only synchronizes and closes it.
+///
+/// Samples are muxed on the caller's thread, and the file I/O runs on the recorder's own serial queue, which also tells the delegate.
+public final class IOFragmentedRecorder {
+    /// The IOFragmentedRecorder error domain codes.
+    public enum Error: Swift.Error {
+        /// Failed to open a file.
+        case failedToOpen(url: URL, errno: Int32)
+        /// Failed to write a file.
+        case failedToWrite(url: URL, errno: Int32)
+        /// Failed to synchronize a file to the storage.
+        case failedToSynchronize(url: URL, errno: Int32)
+    }
+
+    /// The settings of an IOFragmentedRecorder.
+    public struct Settings {
+        /// The duration of a fragment in seconds, at which a file is synchronized to the storage.
+        public var fragmentDuration: Double
+        /// The duration of a file in seconds, above which the file is rolled.
+        public var maximumFileDuration: Double
+        /// The size of a file in bytes, above which the file is rolled.
+        public var maximumFileSize: Int
+        /// The medias to record.
+        public var expectedMedias: Set<AVMediaType>
+
+        /// Creates a new settings.
+        public init(fragmentDuration: Double = 2, maximumFileDuration: Double = 600, maximumFileSize: Int = 1024 * 1024 * 1024, expectedMedias: Set<AVMediaType> = [.audio, .video]) {
+            self.fragmentDuration = fragmentDuration
+            self.maximumFileDuration = maximumFileDuration
+            self.maximumFileSize = maximumFileSize
+            self.expectedMedias = expectedMedias
+        }
+    }
+
+    /// Specifies the delegate.
+    public weak var delegate: (any IOFragmentedRecorderDelegate)?
+    /// Specifies the settings, applied from the next start.
+    public var settings = Settings()
+    /// Specifies the directory to write files in.
+    public var directory: URL
+    /// The running indicies whether recording or not.
+    public private(set) var isRunning: Atomic<Bool> = .init(false)
+    /// The url of the file being written.
+    public var url: URL? {
+        lockQueue.sync { file?.url }
+    }
+    /// The number of synchronizations to the storage.
+    public var synchronizationCount: Int {
+        _synchronizationCount.value
+    }
+
+    public var audioFormat: AVAudioFormat? {
+        get {
+            lockQueue.sync { _audioFormat }
+        }
+        set {
+            lockQueue.sync {
+                // The writer rebuilds the program map on every set.
+                guard _audioFormat != newValue else {
+                    return
+                }
+                _audioFormat = newValue
+                writer?.audioFormat = newValue
+            }
+        }
+    }
+
+    public var videoFormat: CMFormatDescription? {
+        get {
+            lockQueue.sync { _videoFormat }
+        }
+        set {
+            lockQueue.sync {
+                guard !CMFormatDescriptionEqual(_videoFormat, otherFormatDescription: newValue) else {
+                    return
+                }
+                _videoFormat = newValue
+                writer?.videoFormat = newValue
+            }
+        }
+    }
+
+    private var writer: TSWriter?
+    private var file: File?
+    /// The bytes handed to the file queue for the current file.
+    private var fileSize = 0
+    private var fileNumber = 0
+    private var fileTimestamp: CMTime = .invalid
+    private var prefix = ""
+    private var _audioFormat: AVAudioFormat?
+    private var _videoFormat: CMFormatDescription?
+    private var _synchronizationCount: Atomic<Int> = .init(0)
+    private let lockQueue = DispatchQueue(label: "com.haishinkit.HaishinKit.IOFragmentedRecorder.lock")
+    private let fileQueue = DispatchQueue(label: "com.haishinkit.HaishinKit.IOFragmentedRecorder.file", qos: .utility)
+
+    /// Creates a new recorder that writes files in the directory.
+    public init(directory: URL) {
+        self.directory = directory
+    }
+
+    /// Truncates a file written until a crash to its last complete packet, and returns the recovered size.
+    @discardableResult
+    public static func recover(_ url: URL) throws -> Int {
+        let handle = try FileHandle(forUpdating: url)
+        defer {
+            handle.closeFile()
+        }
+        let size = Int(handle.seekToEndOfFile())
+        var offset = size - size % TSPacket.size
+        // A torn write may leave an incomplete packet at the end.
+        while 0 < offset {
+            handle.seek(toFileOffset: UInt64(offset - TSPacket.size))
+            if handle.readData(ofLength: 1).first == 0x47 {
+                break
+            }
+            offset -= TSPacket.size
+        }
+        handle.truncateFile(atOffset: UInt64(offset))
+        handle.synchronizeFile()
+        return offset
+    }
+
+    /// Runs the file I/O on the file queue, so that write(2) and fsync never block the caller.
+    private func perform(_ file: File, _ body: @escaping (File) throws -> Void) {
+        fileQueue.async {
+            // The operations queued after a failure are skipped.
+            guard !file.isFailed else {
+                return
+            }
+            do {
+                try body(file)
+            } catch {
+                file.isFailed = true
+                self.fail(file, error)
+            }
+        }
+    }
+
+    private func write(_ data: Data) {
+        guard let file else {
+            return
+        }
+        fileSize += data.count
+        perform(file) { try $0.write(data) }
+    }
+
+    private func roll(_ timestamp: CMTime) {
+        if let file {
+            if fileTimestamp.isValid &&
+                timestamp.seconds - fileTimestamp.seconds < settings.maximumFileDuration &&
+                fileSize < settings.maximumFileSize {
+                return
+            }
+            close(file)
+        }
+        fileNumber += 1
+        let file = File(directory.appendingPathComponent(String(format: "%@-%05d", prefix, fileNumber)).appendingPathExtension("ts"))
+        self.file = file
+        fileSize = 0
+        fileTimestamp = timestamp
+        perform(file) { try $0.open() }
+        // A file starts with the program tables, so that it plays by itself.
+        writer?.writeProgram()
+    }
+
+    private func close(_ file: File) {
+        self.file = nil
+        fileQueue.async {
+            self.finish(file)
+        }
+    }
+
+    /// Synchronizes and closes a file, and tells the delegate. It runs on the file queue.
+    private func finish(_ file: File) {
+        do {
+            try file.close()
+            _synchronizationCount.mutate { $0 += 1 }
+        } catch {
+            delegate?.recorder(self, errorOccured: error as? Error ?? .failedToSynchronize(url: file.url, errno: EIO))
+        }
+        delegate?.recorder(self, didFinishFile: file.url)
+    }
+
+    /// Stops recording on a failed file operation. It runs on the file queue.
+    private func fail(_ file: File, _ error: any Swift.Error) {
+        let isCurrent = lockQueue.sync { () -> Bool in
+            guard self.file === file else {
+                return false
+            }
+            self.file = nil
+            writer = nil
+            isRunning.mutate { $0 = false }
+            return true
+        }
+        delegate?.recorder(self, errorOccured: error as? Error ?? .failedToWrite(url: file.url, errno: EIO))
+        // A file rolled over already has its close queued.
+        if isCurrent {
+            finish(file)
+        }
+    }
+
+    /// The file is only accessed on the file queue, except for its url.
+    private final class File {
+        let url: URL
+        var isFailed = false
+        private var descriptor: Int32 = -1
+
+        init(_ url: URL) {
+            self.url = url
+        }
+
+        func open() throws {
+            descriptor = Foundation.open(url.path, O_WRONLY | O_CREAT | O_TRUNC, 0o644)
+            guard 0 <= descriptor else {
+                throw Error.failedToOpen(url: url, errno: errno)
+            }
+        }
+
+        func write(_ data: Data) throws {
+            try data.withUnsafeBytes { (pointer: UnsafeRawBufferPointer) in
+                var offset = 0
+                while offset < pointer.count {
+                    let count = Foundation.write(descriptor, pointer.baseAddress?.advanced(by: offset), pointer.count - offset)
+                    if count < 0 {
+                        guard errno == EINTR else {
+                            throw Error.failedToWrite(url: url, errno: errno)
+                        }
+                        continue
+                    }
+                    offset += count
+                }
+            }
+        }
+
+        func synchronize() throws {
+            guard fsync(descriptor) == 0 else {
+                throw Error.failedToSynchronize(url: url, errno: errno)
+            }
+        }
+
+        func close() throws {
+            guard 0 <= descriptor else {
+                return
+            }
+            defer {
+                Foundation.close(descriptor)
+                descriptor = -1
+            }
+            // A failed file is only released.
+            guard !isFailed else {
+                return
+            }
+            try synchronize()
+        }
+    }
+}
+
+extension IOFragmentedRecorder: IOMuxer {
+    // MARK: IOMuxer
+    public func append(_ audioBuffer: AVAudioBuffer, when: AVAudioTime) {
+        lockQueue.sync {
+            guard let writer else {
+                return
+            }
+            if !settings.expectedMedias.contains(.video) {
+                roll(when.makeTime())
+            }
+            writer.append(audioBuffer, when: when)
+        }
+    }
+
+    public func append(_ sampleBuffer: CMSampleBuffer) {
+        lockQueue.sync {
+            guard let writer else {
+                return
+            }
+            if !sampleBuffer.isNotSync {
+                roll(sampleBuffer.decodeTimeStamp.isValid ? sampleBuffer.decodeTimeStamp : sampleBuffer.presentationTimeStamp)
+            }
+            // Nothing is written until the first keyframe, so that the first file starts decodable.
+            guard file != nil else {
+                return
+            }
+            writer.append(sampleBuffer)
+        }
+    }
+
+    public func append(_ metadata: TimedMetadata) {
+        lockQueue.sync {
+            writer?.append(metadata)
+        }
+    }
+}
+
+extension IOFragmentedRecorder: TSWriterDelegate {
+    // MARK: TSWriterDelegate
+    public func writer(_ writer: TSWriter, didRotateFileHandle timestamp: CMTime) {
+        guard let file else {
+            return
+        }
+        perform(file) {
+            try $0.synchronize()
+            self._synchronizationCount.mutate { $0 += 1 }
+        }
+    }
+
+    public func writer(_ writer: TSWriter, didOutput data: Data) {
+        write(data)
+    }
+}
+
+extension IOFragmentedRecorder: Running {
+    // MARK: Running
+    public func startRunning() {
+        lockQueue.sync {
+            guard !isRunning.value else {
+                return
+            }
+            let writer = TSWriter(segmentDuration: settings.fragmentDuration)
+            writer.delegate = self
+            writer.expectedMedias = settings.expectedMedias
+            self.writer = writer
+            prefix = UUID().uuidString
+            fileNumber = 0
+            fileTimestamp = .invalid
+            _synchronizationCount.mutate { $0 = 0 }
+            isRunning.mutate { $0 = true }
+            writer.audioFormat = _audioFormat
+            writer.videoFormat = _videoFormat
+        }
+    }
+
+    /// Stops recording, and waits until the last file is synchronized and closed.
+    public func stopRunning() {
+        lockQueue.sync {
+            guard isRunning.value else {
+                return
+            }
+            if let file {
+                close(file)
+            }
+            writer = nil
+            isRunning.mutate { $0 = false }
+        }
+        fileQueue.sync {}
+    }
+}
@@ -11,6 +11,9 @@ protocol IOMixerDelegate: AnyObject {
     func mixer(_ mixer: IOMixer, didOutput video: CMSampleBuffer)
     func mixer(_ mixer: IOMixer, videoErrorOccurred error: IOVideoUnitError)
     func mixer(_ mixer: IOMixer, audioErrorOccurred error: IOAudioUnitError)
+    func mixer(_ mixer: IOMixer, didBufferBytes byteCount: Int)
+    func mixer(_ mixer: IOMixer, didEncodeIn latency: Double)
+    func mixer(_ mixer: IOMixer, didDropFrame sampleBuffer: CMSampleBuffer)
     #if os(iOS) || os(tvOS)
     @available(tvOS 17.0, *)
     func mixer(_ mixer: IOMixer, sessionWasInterrupted session: AVCaptureSession, reason: AVCaptureSession.InterruptionReason?)
@@ -60,9 +63,19 @@ final class IOMixer {
 
     private(set) var isRunning: Atomic<Bool> = .init(false)
     /// The recorder instance.
-    private(set) lazy var recorder = IORecorder()
+    private(set) lazy var recorder: IORecorder = {
+        let recorder = IORecorder()
+        recorder.mixer = self
+        return recorder
+    }()
 
     weak var muxer: (any IOMuxer)?
+    /// The recorder that writes encoded samples into fragmented files, if any.
+    var fragmentedRecorder: IOFragmentedRecorder?
+    /// Specifies whether to drop encoded video frames that no other frame depends on.
+    var dropsNonReferenceFrames: Atomic<Bool> = .init(false)
+    /// The executor of the post-encode path.
+    let executor: IOMuxerExecutor
     weak var delegate: (any IOMixerDelegate)?
 
     lazy var audioIO: IOAudioUnit = {
@@ -160,6 +173,11 @@ final class IOMixer {
         #endif
     }
 
+    /// Creates a new mixer that runs the post-encode path on an executor.
+    init(executor: IOMuxerExecutor = .init()) {
+        self.executor = executor
+    }
+
     deinit {
         #if os(iOS) || os(macOS) || os(tvOS)
         if #available(tvOS 17.0, *) {
@@ -336,27 +354,48 @@ extension IOMixer {
         audioIO.stopRunning()
         muxer?.stopRunning()
     }
+
+    func recorder(_ recorder: IORecorder, didBufferBytes byteCount: Int) {
+        delegate?.mixer(self, didBufferBytes: byteCount)
+    }
 }
 
 extension IOMixer: VideoCodecDelegate {
     // MARK: VideoCodecDelegate
     func videoCodec(_ codec: VideoCodec<IOMixer>, didOutput formatDescription: CMFormatDescription?) {
-        muxer?.videoFormat = formatDescription
+        executor.queue.async {
+            self.muxer?.videoFormat = formatDescription
+            self.fragmentedRecorder?.videoFormat = formatDescription
+        }
     }
 
     func videoCodec(_ codec: VideoCodec<IOMixer>, didOutput sampleBuffer: CMSampleBuffer) {
-        muxer?.append(sampleBuffer)
+        if dropsNonReferenceFrames.value && !sampleBuffer.isDependedOnByOthers {
+            delegate?.mixer(self, didDropFrame: sampleBuffer)
+            return
+        }
+        executor.execute {
+            self.muxer?.append(sampleBuffer)
+            self.fragmentedRecorder?.append(sampleBuffer)
+        }
     }
 
     func videoCodec(_ codec: VideoCodec<IOMixer>, errorOccurred error: IOVideoUnitError) {
         delegate?.mixer(self, videoErrorOccurred: error)
     }
+
+    func videoCodec(_ codec: VideoCodec<IOMixer>, didEncodeIn latency: Double) {
+        delegate?.mixer(self, didEncodeIn: latency)
+    }
 }
 
 extension IOMixer: AudioCodecDelegate {
     // MARK: AudioCodecDelegate
     func audioCodec(_ codec: AudioCodec<IOMixer>, didOutput audioFormat: AVAudioFormat?) {
-        muxer?.audioFormat = audioFormat
+        executor.queue.async {
+            self.muxer?.audioFormat = audioFormat
+            self.fragmentedRecorder?.audioFormat = audioFormat
+        }
     }
 
     func audioCodec(_ codec: AudioCodec<IOMixer>, didOutput audioBuffer: AVAudioBuffer, when: AVAudioTime) {
@@ -366,8 +405,14 @@ extension IOMixer: AudioCodecDelegate {
         default:
             break
         }
-        muxer?.append(audioBuffer, when: when)
-        codec.releaseOutputBuffer(audioBuffer)
+        executor.execute {
+            self.muxer?.append(audioBuffer, when: when)
+            self.fragmentedRecorder?.append(audioBuffer, when: when)
+            // The codec reuses output buffers on its own queue.
+            codec.lockQueue.async {
+                codec.releaseOutputBuffer(audioBuffer)
+            }
+        }
     }
 
     func audioCodec(_ codec: AudioCodec<IOMixer>, errorOccurred error: IOAudioUnitError) {
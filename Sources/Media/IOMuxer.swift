@@ -7,4 +7,10 @@ public protocol IOMuxer: Running, AnyObject {
 
     func append(_ audioBuffer: AVAudioBuffer, when: AVAudioTime)
     func append(_ sampleBuffer: CMSampleBuffer)
+    func append(_ metadata: TimedMetadata)
+}
+
+extension IOMuxer {
+    public func append(_ metadata: TimedMetadata) {
+    }
 }
@@ -0,0 +1,89 @@
+import Foundation
+
+/// The IOMuxerExecutor class runs the post-encode path of a stream on one serial queue, from an encoder output to the socket handoff.
+///
+/// Audio and video frames hop once onto the queue, and the muxer, the stream and the socket handoff run synchronously on it.
+final class IOMuxerExecutor {
+    /// The metrics of the post-encode path.
+    struct Metrics {
+        /// The bucket bounds of the latency histogram in microseconds.
+        static let latencyBounds: [Double] = [10, 20, 50, 100, 200, 500, 1000, 2000, 5000, 10000, 50000]
+
+        /// The number of executed frames.
+        var frameCount = 0
+        /// The number of queue hops of the executed frames.
+        var hopCount = 0
+        /// The number of frames waiting on the queue.
+        var pendingCount = 0
+        /// The histogram of microseconds from an encoder output to the socket handoff.
+        var latency = Histogram(bounds: Metrics.latencyBounds)
+
+        /// The average number of queue hops per frame.
+        var hopsPerFrame: Double {
+            frameCount == 0 ? 0 : Double(hopCount) / Double(frameCount)
+        }
+    }
+
+    private static let key = DispatchSpecificKey<WeakReference>()
+
+    /// The executor of the current queue, if any.
+    static var current: IOMuxerExecutor? {
+        DispatchQueue.getSpecific(key: key)?.value
+    }
+
+    /// The metrics.
+    var metrics: Metrics {
+        _metrics.value
+    }
+
+    let queue: DispatchQueue
+    private var _metrics: Atomic<Metrics> = .init(.init())
+    /// The hops a frame takes beyond the executor, e.g. a socket wakeup. It is only accessed on the queue.
+    private var extraHopCount = 0
+
+    init(qos: DispatchQoS = .userInitiated) {
+        queue = DispatchQueue(label: "com.haishinkit.HaishinKit.IOMuxerExecutor", qos: qos)
+        queue.setSpecific(key: Self.key, value: WeakReference(self))
+    }
+
+    /// Executes the work of a frame on the queue.
+    func execute(_ work: @escaping () -> Void) {
+        let enqueuedAt = DispatchTime.now().uptimeNanoseconds
+        _metrics.mutate { $0.pendingCount += 1 }
+        queue.async {
+            self.extraHopCount = 0
+            work()
+            let latency = Double(DispatchTime.now().uptimeNanoseconds - enqueuedAt) / 1000
+            let hopCount = 1 + self.extraHopCount
+            self._metrics.mutate {
+                $0.frameCount += 1
+                $0.pendingCount -= 1
+                $0.hopCount += hopCount
+                $0.latency.record(latency)
+            }
+        }
+    }
+
+    /// Records a hop of the current frame beyond the executor.
+    func recordHop() {
+        extraHopCount += 1
+    }
+
+    /// Resets the metrics.
+    func reset() {
+        _metrics.mutate {
+            // Frames on the queue are still pending.
+            let pendingCount = $0.pendingCount
+            $0 = .init()
+            $0.pendingCount = pendingCount
+        }
+    }
+
+    private final class WeakReference {
+        weak var value: IOMuxerExecutor?
+
+        init(_ value: IOMuxerExecutor) {
+            self.value = value
+        }
+    }
+}
@@ -46,8 +46,16 @@ public final class IORecorder {
     public var outputSettings: [AVMediaType: [String: Any]] = IORecorder.defaultOutputSettings
     /// The running indicies whether recording or not.
     public private(set) var isRunning: Atomic<Bool> = .init(false)
+    /// The bytes of the sample buffers waiting to be written.
+    public var bufferedBytes: Int {
+        pendingBytes.value
+    }
+
+    /// The mixer that gauges the buffered bytes of the stream, if any.
+    weak var mixer: IOMixer?
 
     private let lockQueue = DispatchQueue(label: "com.haishinkit.HaishinKit.IORecorder.lock")
+    private var pendingBytes: Atomic<Int> = .init(0)
     private var isReadyForStartWriting: Bool {
         guard let writer = writer else {
             return false
@@ -77,7 +85,12 @@ public final class IORecorder {
             return
         }
         let mediaType: AVMediaType = (sampleBuffer.formatDescription?._mediaType == kCMMediaType_Video) ? .video : .audio
+        let byteCount = sampleBuffer.byteCount
+        buffer(byteCount)
         lockQueue.async {
+            defer {
+                self.buffer(-byteCount)
+            }
             guard
                 let writer = self.writer,
                 let input = self.makeWriterInput(mediaType, sourceFormatHint: sampleBuffer.formatDescription),
@@ -119,7 +132,12 @@ public final class IORecorder {
         guard isRunning.value else {
             return
         }
+        let byteCount = CVPixelBufferGetDataSize(pixelBuffer)
+        buffer(byteCount)
         lockQueue.async {
+            defer {
+                self.buffer(-byteCount)
+            }
             if self.dimensions.width != pixelBuffer.width || self.dimensions.height != pixelBuffer.height {
                 self.dimensions = .init(width: Int32(pixelBuffer.width), height: Int32(pixelBuffer.height))
             }
@@ -178,6 +196,11 @@ public final class IORecorder {
         dispatchGroup.wait()
     }
 
+    private func buffer(_ byteCount: Int) {
+        pendingBytes.mutate { $0 += byteCount }
+        mixer?.recorder(self, didBufferBytes: byteCount)
+    }
+
     private func makeWriterInput(_ mediaType: AVMediaType, sourceFormatHint: CMFormatDescription?) -> AVAssetWriterInput? {
         guard writerInputs[mediaType] == nil else {
             return writerInputs[mediaType]
@@ -5,6 +5,7 @@ protocol IOTellyUnitDelegate: AnyObject {
     func tellyUnit(_ tellyUnit: IOTellyUnit, didSetAudioFormat audioFormat: AVAudioFormat?)
     func tellyUnit(_ tellyUnit: IOTellyUnit, dequeue sampleBuffer: CMSampleBuffer)
     func tellyUnit(_ tellyUnit: IOTellyUnit, didBufferingChanged: Bool)
+    func tellyUnit(_ tellyUnit: IOTellyUnit, didBufferBytes byteCount: Int)
 }
 
 final class IOTellyUnit {
@@ -32,6 +33,19 @@ final class IOTellyUnit {
         return mediaLink.playerNode
     }
 
+    var timePitchNode: AVAudioUnitTimePitch {
+        return mediaLink.timePitchNode
+    }
+
+    var choreographerMode: ChoreographerMode {
+        get {
+            mediaLink.choreographerMode
+        }
+        set {
+            mediaLink.choreographerMode = newValue
+        }
+    }
+
     var delegate: (any IOTellyUnitDelegate)?
 
     private lazy var mediaLink: MediaLink = {
@@ -81,4 +95,8 @@ extension IOTellyUnit: MediaLinkDelegate {
     func mediaLink(_ mediaLink: MediaLink<IOTellyUnit>, didBufferingChanged: Bool) {
         delegate?.tellyUnit(self, didBufferingChanged: didBufferingChanged)
     }
+
+    func mediaLink(_ mediaLink: MediaLink<IOTellyUnit>, didBufferBytes byteCount: Int) {
+        delegate?.tellyUnit(self, didBufferBytes: byteCount)
+    }
 }
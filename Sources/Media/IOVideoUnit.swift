@@ -32,6 +32,18 @@ final class IOVideoUnit: NSObject, IOUnit {
     }
     var multiCamCaptureSettings: MultiCamCaptureSettings = .default
     weak var mixer: IOMixer?
+    /// The ladder that encodes mixed frames into renditions besides the codec, if any.
+    var ladder: VideoLadder? {
+        didSet {
+            guard ladder !== oldValue else {
+                return
+            }
+            oldValue?.stopRunning()
+            if isRunning.value {
+                ladder?.startRunning()
+            }
+        }
+    }
     var muted: Bool {
         get {
             videoMixer.muted
@@ -300,9 +312,11 @@ extension IOVideoUnit: Running {
         codec.passthrough = capture.preferredVideoStabilizationMode == .off
         #endif
         codec.startRunning()
+        ladder?.startRunning()
     }
 
     func stopRunning() {
+        ladder?.stopRunning()
         codec.stopRunning()
     }
 }
@@ -331,6 +345,11 @@ extension IOVideoUnit: IOVideoMixerDelegate {
             presentationTimeStamp: presentationTimeStamp,
             duration: .invalid
         )
+        ladder?.append(
+            imageBuffer,
+            presentationTimeStamp: presentationTimeStamp,
+            duration: .invalid
+        )
         mixer?.recorder.append(
             imageBuffer,
             withPresentationTime: presentationTimeStamp
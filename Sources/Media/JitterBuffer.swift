@@ -0,0 +1,113 @@
+import Foundation
+
+/// The JitterBuffer struct estimates network jitter and controls the playback delay of a live stream.
+///
+/// The target delay follows the inter-arrival jitter (RFC 3550). When the buffered delay grows beyond the target,
+/// it asks for a slightly faster playback rate instead of letting the latency drift.
+struct JitterBuffer {
+    struct Settings {
+        /// The lower bound of the target delay in seconds.
+        var minimumDelay: Double = 0.1
+        /// The upper bound of the target delay in seconds.
+        var maximumDelay: Double = 3.0
+        /// The multiplier of the jitter to derive the target delay.
+        var jitterMultiplier: Double = 4.0
+        /// The playback rate while catching up.
+        var catchUpRate: Double = 1.05
+        /// The excess delay over the target in seconds to start catching up.
+        var catchUpThreshold: Double = 0.15
+        /// The delay in seconds to raise the target by on every underrun.
+        var underrunPenalty: Double = 0.1
+        /// The decay in seconds per second of the underrun penalty.
+        var underrunPenaltyDecay: Double = 0.01
+        /// The age in seconds behind the playhead to treat a video frame as late.
+        var lateThreshold: Double = 0.1
+    }
+
+    var settings: Settings
+    /// The estimated inter-arrival jitter in seconds.
+    private(set) var jitter: Double = 0
+    /// The current target delay in seconds.
+    private(set) var targetDelay: Double
+    /// The latest buffered delay in seconds.
+    private(set) var delay: Double = 0
+    /// The playback rate to apply. 1.0 is the normal speed.
+    private(set) var playbackRate: Double = 1.0
+    /// Whether the playback waits to fill the buffer.
+    private(set) var isBuffering = true
+    /// The number of underruns.
+    private(set) var underrunCount = 0
+    private var transit: Double?
+    private var underrunDelay: Double = 0
+
+    init(settings: Settings = .init()) {
+        self.settings = settings
+        self.targetDelay = settings.minimumDelay
+    }
+
+    /// Feeds an arrival of a media frame. The timestamp and the arrival time must be in seconds.
+    mutating func arrive(_ timestamp: Double, at time: Double) {
+        let transit = time - timestamp
+        if let previous = self.transit {
+            jitter += (abs(transit - previous) - jitter) / 16
+        }
+        self.transit = transit
+        updateTargetDelay()
+    }
+
+    /// Updates the state with the buffered delay, and the elapsed time in seconds since the last update.
+    mutating func update(_ delay: Double, elapsed: Double) {
+        self.delay = delay
+        if 0 < elapsed && !isBuffering {
+            underrunDelay = max(0, underrunDelay - elapsed * settings.underrunPenaltyDecay)
+            updateTargetDelay()
+        }
+        if isBuffering {
+            if targetDelay <= delay {
+                isBuffering = false
+            }
+            playbackRate = 1.0
+            return
+        }
+        if delay <= 0 {
+            underrun()
+        } else if targetDelay + settings.catchUpThreshold < delay {
+            playbackRate = settings.catchUpRate
+        } else if delay <= targetDelay {
+            playbackRate = 1.0
+        }
+    }
+
+    /// Tells the buffer ran dry.
+    mutating func underrun() {
+        guard !isBuffering else {
+            return
+        }
+        isBuffering = true
+        playbackRate = 1.0
+        underrunCount += 1
+        underrunDelay = min(underrunDelay + settings.underrunPenalty, settings.maximumDelay)
+        updateTargetDelay()
+    }
+
+    /// Returns whether a video frame is too late to present at the playhead.
+    func isLate(_ timestamp: Double, playhead: Double) -> Bool {
+        return timestamp < playhead - settings.lateThreshold
+    }
+
+    /// Clears all states.
+    mutating func clear() {
+        jitter = 0
+        delay = 0
+        playbackRate = 1.0
+        isBuffering = true
+        underrunCount = 0
+        transit = nil
+        underrunDelay = 0
+        targetDelay = settings.minimumDelay
+    }
+
+    private mutating func updateTargetDelay() {
+        targetDelay = min(max(settings.minimumDelay, jitter * settings.jitterMultiplier) + underrunDelay, settings.maximumDelay)
+    }
+}
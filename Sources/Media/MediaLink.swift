@@ -7,11 +7,9 @@ import SwiftPMSupport
 protocol MediaLinkDelegate: AnyObject {
     func mediaLink(_ mediaLink: MediaLink<Self>, dequeue sampleBuffer: CMSampleBuffer)
     func mediaLink(_ mediaLink: MediaLink<Self>, didBufferingChanged: Bool)
+    func mediaLink(_ mediaLink: MediaLink<Self>, didBufferBytes byteCount: Int)
 }
 
-private let kMediaLink_bufferTime = 0.2
-private let kMediaLink_bufferingTime = 0.0
-
 final class MediaLink<T: MediaLinkDelegate> {
     var isPaused = false {
         didSet {
@@ -31,31 +29,66 @@ final class MediaLink<T: MediaLinkDelegate> {
         }
     }
     var hasVideo = false
-    var bufferTime = kMediaLink_bufferTime
+    /// Specifies the clock that paces the frames. It takes effect when the playback starts.
+    var choreographerMode: ChoreographerMode
+    /// Specifies the settings of the adaptive jitter buffer.
+    var jitterBufferSettings: JitterBuffer.Settings {
+        get {
+            jitterBuffer.value.settings
+        }
+        set {
+            jitterBuffer.mutate { $0.settings = newValue }
+        }
+    }
     weak var delegate: T?
     private(set) lazy var playerNode = AVAudioPlayerNode()
+    /// The time pitch node that speeds up audio slightly while catching up to live.
+    private(set) lazy var timePitchNode = AVAudioUnitTimePitch()
     private(set) var isRunning: Atomic<Bool> = .init(false)
+    /// The bytes of the video frames waiting to be presented.
+    private(set) var bufferedBytes: Atomic<Int> = .init(0)
     private var isBuffering = true {
         didSet {
-            if !isBuffering {
-                bufferingTime = 0.0
-            }
             isPaused = isBuffering
             delegate?.mediaLink(self, didBufferingChanged: isBuffering)
         }
     }
-    private var bufferingTime = kMediaLink_bufferingTime
-    private lazy var choreographer: any Choreographer = {
-        var choreographer = DisplayLinkChoreographer()
-        choreographer.delegate = self
-        return choreographer
-    }()
+    private var playbackRate: Double = 1.0 {
+        didSet {
+            guard playbackRate != oldValue else {
+                return
+            }
+            timePitchNode.rate = Float(playbackRate)
+        }
+    }
+    private var choreographer: any Choreographer
     private let lockQueue = DispatchQueue(label: "com.haishinkit.HaishinKit.MediaLink.lock")
     private var frameCount: AVAudioFramePosition = 0
     private var bufferQueue: CMBufferQueue?
     private var lastRenderTime: AVAudioTime = .zero
     private var scheduledAudioBuffers: Atomic<Int> = .init(0)
     private var presentationTimeStampOrigin: CMTime = .invalid
+    private var jitterBuffer: Atomic<JitterBuffer> = .init(.init())
+    private var playhead: Double = 0
+    private var audioPlayhead: Double = 0
+    private var audioSampleRate: Double = 0
+    private var latestVideoTimestamp: Double = 0
+    private var lastChoreographerDuration: Double = 0
+    private var droppedFrameCount = 0
+
+    /// Creates a new MediaLink. Specify a TimerChoreographer to pace frames without a display.
+    init(choreographerMode: ChoreographerMode = .automatic) {
+        self.choreographerMode = choreographerMode
+        self.choreographer = choreographerMode.makeChoreographer()
+        self.choreographer.delegate = self
+    }
+
+    private var audioDelay: Double {
+        guard 0 < audioSampleRate else {
+            return 0
+        }
+        return Double(frameCount) / audioSampleRate - audioPlayhead
+    }
 
     func enqueue(_ buffer: CMSampleBuffer) {
         guard buffer.presentationTimeStamp != .invalid else {
@@ -68,16 +101,23 @@ final class MediaLink<T: MediaLinkDelegate> {
             delegate?.mediaLink(self, dequeue: buffer)
             return
         }
-        if let bufferQueue {
-            CMBufferQueueEnqueue(bufferQueue, buffer: buffer)
+        if let bufferQueue, CMBufferQueueEnqueue(bufferQueue, buffer: buffer) == noErr {
+            let byteCount = buffer.byteCount
+            bufferedBytes.mutate { $0 += byteCount }
+            delegate?.mediaLink(self, didBufferBytes: byteCount)
         }
-        if isBuffering {
-            bufferingTime += bufferQueue?.duration.seconds ?? 0
-            if bufferTime <= bufferingTime {
-                bufferTime += 0.1
-                isBuffering = false
+        let timestamp = buffer.presentationTimeStamp.seconds - presentationTimeStampOrigin.seconds
+        latestVideoTimestamp = max(latestVideoTimestamp, timestamp)
+        let delay = latestVideoTimestamp - playhead
+        jitterBuffer.mutate {
+            $0.arrive(timestamp, at: ProcessInfo.processInfo.systemUptime)
+            if $0.isBuffering {
+                $0.update(delay, elapsed: 0)
             }
         }
+        if isBuffering && !jitterBuffer.value.isBuffering {
+            isBuffering = false
+        }
     }
 
     func enqueue(_ audioBuffer: AVAudioBuffer, when: AVAudioTime) {
@@ -87,37 +127,53 @@ final class MediaLink<T: MediaLinkDelegate> {
         if lastRenderTime == .zero {
             lastRenderTime = playerNode.lastRenderTime ?? .zero
         }
+        audioSampleRate = audioBuffer.format.sampleRate
         nstry({
             self.scheduledAudioBuffers.mutate { $0 += 1 }
             if let at = AVAudioTime(sampleTime: self.frameCount, atRate: audioBuffer.format.sampleRate).extrapolateTime(fromAnchor: self.lastRenderTime) {
                 self.playerNode.scheduleBuffer(audioBuffer, at: at, completionHandler: self.didAVAudioNodeCompletion)
             }
             self.frameCount += Int64(audioBuffer.frameLength)
-            if !self.hasVideo && !self.playerNode.isPlaying && 10 <= self.scheduledAudioBuffers.value {
-                self.playerNode.play()
-            }
         }, { exeption in
             logger.warn(exeption)
         })
+        guard !hasVideo else {
+            return
+        }
+        // Without video, the audio drives the jitter buffer.
+        let timestamp = when.isSampleTimeValid ? Double(when.sampleTime) / when.sampleRate : AVAudioTime.seconds(forHostTime: when.hostTime)
+        let delay = audioDelay
+        jitterBuffer.mutate {
+            $0.arrive(timestamp, at: ProcessInfo.processInfo.systemUptime)
+            if $0.isBuffering {
+                $0.update(delay, elapsed: 0)
+            }
+        }
+        if isBuffering && !jitterBuffer.value.isBuffering {
+            isBuffering = false
+        }
     }
 
-    private func duration(_ duraiton: Double) -> Double {
-        if playerNode.isPlaying {
-            guard let nodeTime = playerNode.lastRenderTime, let playerTime = playerNode.playerTime(forNodeTime: nodeTime) else {
-                return 0.0
-            }
-            return TimeInterval(playerTime.sampleTime) / playerTime.sampleRate
+    private func updateAudioPlayhead() -> Bool {
+        guard playerNode.isPlaying, let nodeTime = playerNode.lastRenderTime, let playerTime = playerNode.playerTime(forNodeTime: nodeTime) else {
+            return false
         }
-        return duraiton
+        audioPlayhead = TimeInterval(playerTime.sampleTime) / playerTime.sampleRate
+        return true
     }
 
     private func didAVAudioNodeCompletion() {
+        var isEmpty = false
         scheduledAudioBuffers.mutate {
             $0 -= 1
-            if $0 == 0 {
-                isBuffering = true
-            }
+            isEmpty = $0 == 0
         }
+        guard isEmpty else {
+            return
+        }
+        jitterBuffer.mutate { $0.underrun() }
+        playbackRate = 1.0
+        isBuffering = true
     }
 
     private func makeBufferkQueue() {
@@ -133,28 +189,60 @@ final class MediaLink<T: MediaLinkDelegate> {
 extension MediaLink: ChoreographerDelegate {
     // MARK: ChoreographerDelegate
     func choreographer(_ choreographer: any Choreographer, didFrame duration: Double) {
+        let elapsed = max(0, duration - lastChoreographerDuration)
+        lastChoreographerDuration = duration
+        let isAudioPlaying = updateAudioPlayhead()
+        guard hasVideo else {
+            let delay = audioDelay
+            jitterBuffer.mutate { $0.update(delay, elapsed: elapsed) }
+            playbackRate = jitterBuffer.value.playbackRate
+            return
+        }
         guard let bufferQueue else {
             return
         }
-        let duration = self.duration(duration)
-        var frameCount = 0
-        while !CMBufferQueueIsEmpty(bufferQueue) {
-            guard let head = CMBufferQueueGetHead(bufferQueue) else {
+        // The audio clock leads when it plays. Otherwise the display clock advances at the playback rate.
+        playhead = isAudioPlaying ? audioPlayhead : playhead + elapsed * playbackRate
+        var presentation: CMSampleBuffer?
+        while let head = CMBufferQueueGetHead(bufferQueue) {
+            let first = head as! CMSampleBuffer
+            guard first.presentationTimeStamp.seconds - presentationTimeStampOrigin.seconds <= playhead else {
                 break
             }
-            let first = head as! CMSampleBuffer
-            if first.presentationTimeStamp.seconds - presentationTimeStampOrigin.seconds <= duration {
-                delegate?.mediaLink(self, dequeue: first)
-                frameCount += 1
-                CMBufferQueueDequeue(bufferQueue)
-            } else {
-                if 2 < frameCount {
-                    logger.info("droppedFrame: \(frameCount)")
+            CMBufferQueueDequeue(bufferQueue)
+            let byteCount = first.byteCount
+            bufferedBytes.mutate { $0 -= byteCount }
+            delegate?.mediaLink(self, didBufferBytes: -byteCount)
+            if let presentation {
+                // Late frames are dropped to catch up, but the newest due frame is always presented.
+                if jitterBuffer.value.isLate(presentation.presentationTimeStamp.seconds - presentationTimeStampOrigin.seconds, playhead: playhead) {
+                    droppedFrameCount += 1
+                } else {
+                    delegate?.mediaLink(self, dequeue: presentation)
                 }
-                return
             }
+            presentation = first
+        }
+        if let presentation {
+            delegate?.mediaLink(self, dequeue: presentation)
+        }
+        let delay = latestVideoTimestamp - playhead
+        jitterBuffer.mutate {
+            if CMBufferQueueIsEmpty(bufferQueue) && delay <= 0 {
+                $0.underrun()
+            } else {
+                $0.update(delay, elapsed: elapsed)
+            }
+        }
+        let jitterBuffer = self.jitterBuffer.value
+        playbackRate = jitterBuffer.playbackRate
+        if jitterBuffer.isBuffering {
+            if 0 < droppedFrameCount {
+                logger.info("droppedFrame: \(droppedFrameCount)")
+                droppedFrameCount = 0
+            }
+            isBuffering = true
         }
-        isBuffering = true
     }
 }
 
@@ -166,7 +254,10 @@ extension MediaLink: Running {
                 return
             }
             self.hasVideo = false
-            self.bufferingTime = kMediaLink_bufferingTime
+            // A display may be attached or detached since the last playback.
+            self.choreographer = self.choreographerMode.makeChoreographer()
+            self.choreographer.delegate = self
+            self.jitterBuffer.mutate { $0.clear() }
             self.isBuffering = true
             self.choreographer.startRunning()
             self.makeBufferkQueue()
@@ -181,10 +272,22 @@ extension MediaLink: Running {
             }
             self.choreographer.stopRunning()
             self.bufferQueue = nil
+            var byteCount = 0
+            self.bufferedBytes.mutate {
+                byteCount = $0
+                $0 = 0
+            }
+            self.delegate?.mediaLink(self, didBufferBytes: -byteCount)
             self.frameCount = 0
             self.lastRenderTime = .zero
             self.scheduledAudioBuffers.mutate { $0 = 0 }
             self.presentationTimeStampOrigin = .invalid
+            self.playhead = 0
+            self.audioPlayhead = 0
+            self.latestVideoTimestamp = 0
+            self.lastChoreographerDuration = 0
+            self.droppedFrameCount = 0
+            self.playbackRate = 1.0
             self.isRunning.mutate { $0 = false }
         }
     }
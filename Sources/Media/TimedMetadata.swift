@@ -0,0 +1,55 @@
+import CoreMedia
+import Foundation
+
+/// The TimedMetadata struct represents a binary payload tied to a media timestamp such as per-frame telemetry.
+public struct TimedMetadata: Equatable {
+    /// The presentation timestamp that the payload belongs to.
+    public let timestamp: CMTime
+    /// The binary payload. The format is up to the application (ID3, KLV, etc).
+    public let payload: Data
+
+    /// Creates a new TimedMetadata.
+    public init(timestamp: CMTime, payload: Data) {
+        self.timestamp = timestamp
+        self.payload = payload
+    }
+}
+
+extension TimedMetadata: CustomDebugStringConvertible {
+    // MARK: CustomDebugStringConvertible
+    public var debugDescription: String {
+        Mirror(reflecting: self).debugDescription
+    }
+}
+
+// MARK: -
+/// The TimedMetadataQueue holds metadata until the media frame it belongs to is muxed.
+struct TimedMetadataQueue {
+    var isEmpty: Bool {
+        metadatas.value.isEmpty
+    }
+
+    private var metadatas: Atomic<[TimedMetadata]> = .init([])
+
+    mutating func enqueue(_ metadata: TimedMetadata) {
+        metadatas.mutate { $0.append(metadata) }
+    }
+
+    /// Dequeues all metadata whose timestamp is at or before the specified timestamp.
+    mutating func dequeue(_ timestamp: CMTime) -> [TimedMetadata] {
+        var result: [TimedMetadata] = []
+        metadatas.mutate {
+            guard !$0.isEmpty else {
+                return
+            }
+            let index = $0.firstIndex { timestamp < $0.timestamp } ?? $0.endIndex
+            result = Array($0[0..<index])
+            $0.removeSubrange(0..<index)
+        }
+        return result
+    }
+
+    mutating func clear() {
+        metadatas.mutate { $0.removeAll() }
+    }
+}
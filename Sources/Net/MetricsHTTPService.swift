@@ -0,0 +1,162 @@
+import Foundation
+
+/// The MetricsHTTPService class serves the metrics of a registry over HTTP in the Prometheus text exposition format.
+///
+/// It answers GET and HEAD requests to the path, and keeps connections alive as a scraper expects.
+/// It listens on the bind address without publishing a Bonjour service, so the metrics stay on the device unless a caller binds another address.
+public final class MetricsHTTPService: NetService {
+    /// The default bind address, which is the loopback.
+    public static let defaultAddress = "127.0.0.1"
+    /// The default port.
+    public static let defaultPort: Int32 = 9464
+    /// The default path.
+    public static let defaultPath = "/metrics"
+    /// The maximum size of a request header.
+    static let maximumHeaderSize = 8 * 1024
+    static let headerTerminator = Data("\r\n\r\n".utf8)
+
+    /// The registry to serve.
+    public let registry: MetricsRegistry
+    /// The path to serve.
+    public let path: String
+    /// The numeric IPv4 or IPv6 address to bind, e.g. "0.0.0.0" to serve every interface.
+    public let address: String
+
+    /// The listener and its run loop are set on the network queue and cleared by the caller of stopRunning(), so they are guarded by the lock.
+    private var listener: CFSocket?
+    private var runloop: CFRunLoop?
+    /// The generation of the listener, bumped on every start and stop, so that a listener set up after a stop is discarded.
+    private var generation = 0
+    private let lockQueue = DispatchQueue(label: "com.haishinkit.HaishinKit.MetricsHTTPService.lock")
+
+    /// Creates a new service.
+    public init(registry: MetricsRegistry = .shared, address: String = MetricsHTTPService.defaultAddress, port: Int32 = MetricsHTTPService.defaultPort, path: String = MetricsHTTPService.defaultPath) {
+        self.registry = registry
+        self.address = address
+        self.path = path
+        super.init(domain: "", type: "_http._tcp", name: "HaishinKit", port: port)
+    }
+
+    override func willStartRunning() {
+        let generation = lockQueue.sync { () -> Int in
+            self.generation += 1
+            return self.generation
+        }
+        networkQueue.async {
+            self.initListener(generation)
+        }
+    }
+
+    override func willStopRunning() {
+        let (listener, runloop) = lockQueue.sync { () -> (CFSocket?, CFRunLoop?) in
+            defer {
+                self.generation += 1
+                self.listener = nil
+                self.runloop = nil
+            }
+            return (self.listener, self.runloop)
+        }
+        if let listener {
+            CFSocketInvalidate(listener)
+        }
+        if let runloop {
+            CFRunLoopStop(runloop)
+        }
+    }
+
+    override func client(inputBuffer client: NetClient) {
+        while let range = client.inputBuffer.range(of: Self.headerTerminator) {
+            let header = client.inputBuffer.subdata(in: client.inputBuffer.startIndex..<range.lowerBound)
+            client.inputBuffer.removeSubrange(client.inputBuffer.startIndex..<range.upperBound)
+            client.doOutput(data: makeResponse(String(decoding: header, as: UTF8.self)))
+        }
+        if Self.maximumHeaderSize < client.inputBuffer.count {
+            disconnect(client)
+        }
+    }
+
+    /// Makes the response to a request header.
+    func makeResponse(_ header: String) -> Data {
+        let requestLine = header.components(separatedBy: "\r\n").first?.components(separatedBy: " ") ?? []
+        guard requestLine.count == 3 else {
+            return makeResponse(status: "400 Bad Request", body: "")
+        }
+        let method = requestLine[0]
+        guard method == "GET" || method == "HEAD" else {
+            return makeResponse(status: "405 Method Not Allowed", body: "")
+        }
+        guard requestLine[1].components(separatedBy: "?").first == path else {
+            return makeResponse(status: "404 Not Found", body: "")
+        }
+        return makeResponse(status: "200 OK", body: registry.exposition(), contentType: MetricsCollector.contentType, includesBody: method == "GET")
+    }
+
+    private func initListener(_ generation: Int) {
+        var hints = addrinfo()
+        hints.ai_flags = AI_NUMERICHOST | AI_PASSIVE
+        hints.ai_socktype = SOCK_STREAM
+        var result: UnsafeMutablePointer<addrinfo>?
+        guard getaddrinfo(address, String(port), &hints, &result) == 0, let info = result else {
+            logger.error("invalid bind address:", address)
+            return
+        }
+        let family = info.pointee.ai_family
+        let bindAddress = Data(bytes: info.pointee.ai_addr, count: Int(info.pointee.ai_addrlen))
+        freeaddrinfo(info)
+        var context = CFSocketContext(version: 0, info: Unmanaged.passUnretained(self).toOpaque(), retain: nil, release: nil, copyDescription: nil)
+        guard let listener = CFSocketCreate(kCFAllocatorDefault, family, SOCK_STREAM, IPPROTO_TCP, CFSocketCallBackType.acceptCallBack.rawValue, { _, _, _, data, info in
+            guard let data, let info else {
+                return
+            }
+            Unmanaged<MetricsHTTPService>.fromOpaque(info).takeUnretainedValue().accept(data.load(as: CFSocketNativeHandle.self))
+        }, &context) else {
+            return
+        }
+        var reuseAddress: Int32 = 1
+        setsockopt(CFSocketGetNative(listener), SOL_SOCKET, SO_REUSEADDR, &reuseAddress, socklen_t(MemoryLayout<Int32>.size))
+        guard CFSocketSetAddress(listener, bindAddress as CFData) == .success else {
+            logger.error("failed to listen on", address, port)
+            CFSocketInvalidate(listener)
+            return
+        }
+        let runloop = CFRunLoopGetCurrent()
+        let isCurrent = lockQueue.sync { () -> Bool in
+            guard self.generation == generation else {
+                return false
+            }
+            self.listener = listener
+            self.runloop = runloop
+            return true
+        }
+        guard isCurrent else {
+            CFSocketInvalidate(listener)
+            return
+        }
+        CFRunLoopAddSource(runloop, CFSocketCreateRunLoopSource(kCFAllocatorDefault, listener, 0), .defaultMode)
+        // A stop in between invalidates the listener, which removes its source, so the run loop returns at once.
+        CFRunLoopRun()
+    }
+
+    private func accept(_ handle: CFSocketNativeHandle) {
+        var readStream: Unmanaged<CFReadStream>?
+        var writeStream: Unmanaged<CFWriteStream>?
+        CFStreamCreatePairWithSocket(kCFAllocatorDefault, handle, &readStream, &writeStream)
+        guard let inputStream = readStream?.takeRetainedValue(), let outputStream = writeStream?.takeRetainedValue() else {
+            close(handle)
+            return
+        }
+        // The streams own the accepted socket.
+        CFReadStreamSetProperty(inputStream, CFStreamPropertyKey(kCFStreamPropertyShouldCloseNativeSocket), kCFBooleanTrue)
+        CFWriteStreamSetProperty(outputStream, CFStreamPropertyKey(kCFStreamPropertyShouldCloseNativeSocket), kCFBooleanTrue)
+        accept(inputStream: inputStream as InputStream, outputStream: outputStream as OutputStream)
+    }
+
+    private func makeResponse(status: String, body: String, contentType: String = "text/plain; charset=utf-8", includesBody: Bool = true) -> Data {
+        let body = Data(body.utf8)
+        var response = Data("HTTP/1.1 \(status)\r\nContent-Type: \(contentType)\r\nContent-Length: \(body.count)\r\n\r\n".utf8)
+        if includesBody {
+            response.append(body)
+        }
+        return response
+    }
+}
@@ -0,0 +1,297 @@
+import Foundation
+
+/// The NetCapture class records the bytes a socket sends and receives into a compact binary file, so that a session is replayed exactly.
+///
+/// A file starts with the magic "HKCP", a version, the content and the start time in microseconds since 1970. Each record follows as the
+/// direction, the microseconds since the previous record and the length, both as LEB128 varints, and the bytes.
+public final class NetCapture {
+    /// The NetCapture error domain codes.
+    public enum Error: Swift.Error {
+        /// The file isn't a capture.
+        case invalidFormat
+        /// The file ends in the middle of a record.
+        case truncated(records: [Record])
+    }
+
+    /// The direction of a record.
+    public enum Direction: UInt8 {
+        /// The bytes received.
+        case input = 0
+        /// The bytes sent.
+        case output = 1
+    }
+
+    /// The content of a capture.
+    public enum Content: UInt8 {
+        /// The RTMP byte stream over TCP, including the handshake.
+        case rtmp = 0
+        /// The SRT messages over UDP.
+        case srt = 1
+        /// The MPEG-2 TS packets.
+        case ts = 2
+    }
+
+    /// A record of a capture.
+    public struct Record: Equatable {
+        /// The direction.
+        public let direction: Direction
+        /// The seconds since the start of the capture.
+        public let timestamp: TimeInterval
+        /// The bytes.
+        public let data: Data
+    }
+
+    static let magic = Data("HKCP".utf8)
+    static let version: UInt8 = 1
+    static let headerSize = 14
+
+    /// The url of the capture.
+    public let url: URL
+    /// The content of the capture.
+    public let content: Content
+    /// The number of bytes captured.
+    public var byteCount: Int {
+        lockQueue.sync { _byteCount }
+    }
+
+    private let handle: FileHandle
+    private let startedAt: UInt64
+    private var previousTimestamp: UInt64 = 0
+    private var buffer = Data()
+    private var isClosed = false
+    private var _byteCount = 0
+    private let lockQueue = DispatchQueue(label: "com.haishinkit.HaishinKit.NetCapture.lock")
+
+    /// Creates a new capture into the url.
+    public init(url: URL, content: Content) throws {
+        FileManager.default.createFile(atPath: url.path, contents: nil)
+        handle = try FileHandle(forWritingTo: url)
+        self.url = url
+        self.content = content
+        startedAt = DispatchTime.now().uptimeNanoseconds
+        var header = Self.magic
+        header.append(Self.version)
+        header.append(content.rawValue)
+        header.append(UInt64(Date().timeIntervalSince1970 * 1_000_000).bigEndian.data)
+        handle.write(header)
+    }
+
+    deinit {
+        close()
+    }
+
+    /// Appends the bytes of a direction.
+    public func append(_ data: Data, direction: Direction) {
+        let timestamp = (DispatchTime.now().uptimeNanoseconds - startedAt) / 1000
+        lockQueue.async {
+            guard !self.isClosed else {
+                return
+            }
+            self.buffer.append(direction.rawValue)
+            self.buffer.appendVarint(timestamp - min(timestamp, self.previousTimestamp))
+            self.buffer.appendVarint(UInt64(data.count))
+            self.buffer.append(data)
+            self.previousTimestamp = max(timestamp, self.previousTimestamp)
+            self._byteCount += data.count
+            if 64 * 1024 <= self.buffer.count {
+                self.flush()
+            }
+        }
+    }
+
+    /// Writes the buffered records, and closes the file.
+    public func close() {
+        lockQueue.sync {
+            guard !isClosed else {
+                return
+            }
+            flush()
+            handle.closeFile()
+            isClosed = true
+        }
+    }
+
+    /// Reads the content, the start time and the records of a capture.
+    public static func read(_ url: URL) throws -> (content: Content, startedAt: Date, records: [Record]) {
+        let data = try Data(contentsOf: url)
+        guard
+            headerSize <= data.count,
+            data.prefix(magic.count) == magic,
+            data[data.startIndex + 4] == version,
+            let content = Content(rawValue: data[data.startIndex + 5]) else {
+            throw Error.invalidFormat
+        }
+        let startedAt = data[data.startIndex + 6..<data.startIndex + headerSize].reduce(UInt64(0)) { $0 << 8 | UInt64($1) }
+        var records: [Record] = []
+        var offset = data.startIndex + headerSize
+        var timestamp: UInt64 = 0
+        while offset < data.endIndex {
+            guard let direction = Direction(rawValue: data[offset]) else {
+                throw Error.truncated(records: records)
+            }
+            offset += 1
+            guard
+                let delta = data.readVarint(&offset),
+                let count = data.readVarint(&offset),
+                Int(count) <= data.endIndex - offset else {
+                throw Error.truncated(records: records)
+            }
+            timestamp += delta
+            records.append(Record(direction: direction, timestamp: Double(timestamp) / 1_000_000, data: data.subdata(in: offset..<offset + Int(count))))
+            offset += Int(count)
+        }
+        return (content, Date(timeIntervalSince1970: Double(startedAt) / 1_000_000), records)
+    }
+
+    private func flush() {
+        guard !buffer.isEmpty else {
+            return
+        }
+        handle.write(buffer)
+        buffer.removeAll(keepingCapacity: true)
+    }
+}
+
+extension NetCapture {
+    /// Exports a capture as pcapng, where the bytes are wrapped in synthetic IPv4 and TCP or UDP headers that dissectors recognize.
+    public static func exportPcapng(_ url: URL, to destination: URL) throws {
+        let (content, startedAt, records) = try read(url)
+        var pcapng = Data()
+        // Section Header Block.
+        pcapng.appendBlock(0x0A0D0D0A, body: UInt32(0x1A2B3C4D).littleEndian.data + UInt16(1).littleEndian.data + UInt16(0).littleEndian.data + Int64(-1).littleEndian.data)
+        // Interface Description Block of LINKTYPE_RAW, in microseconds.
+        pcapng.appendBlock(0x00000001, body: UInt16(101).littleEndian.data + UInt16(0).littleEndian.data + UInt32(0).littleEndian.data)
+        var packetizer = Packetizer(content: content)
+        let origin = UInt64(startedAt.timeIntervalSince1970 * 1_000_000)
+        for record in records {
+            let timestamp = origin + UInt64(record.timestamp * 1_000_000)
+            for packet in packetizer.makePackets(record) {
+                var body = UInt32(0).littleEndian.data
+                body.append(UInt32(truncatingIfNeeded: timestamp >> 32).littleEndian.data)
+                body.append(UInt32(truncatingIfNeeded: timestamp).littleEndian.data)
+                body.append(UInt32(packet.count).littleEndian.data)
+                body.append(UInt32(packet.count).littleEndian.data)
+                body.append(packet)
+                body.append(Data(count: (4 - packet.count % 4) % 4))
+                // Enhanced Packet Block.
+                pcapng.appendBlock(0x00000006, body: body)
+            }
+        }
+        try pcapng.write(to: destination)
+    }
+
+    /// A client at 10.0.0.1 and a server at 10.0.0.2, where outputs go from the client to the server.
+    struct Packetizer {
+        static let clientAddress: [UInt8] = [10, 0, 0, 1]
+        static let serverAddress: [UInt8] = [10, 0, 0, 2]
+        static let clientPort: UInt16 = 49152
+        static let maximumPayloadSize = 65535 - 20 - 20
+
+        let content: Content
+        private var sequenceNumbers: [Direction: UInt32] = [.input: 0, .output: 0]
+
+        init(content: Content) {
+            self.content = content
+        }
+
+        var serverPort: UInt16 {
+            switch content {
+            case .rtmp:
+                return 1935
+            case .srt:
+                return 9000
+            case .ts:
+                return 1234
+            }
+        }
+
+        mutating func makePackets(_ record: Record) -> [Data] {
+            var packets: [Data] = []
+            var offset = record.data.startIndex
+            repeat {
+                let payload = record.data[offset..<min(offset + Self.maximumPayloadSize, record.data.endIndex)]
+                packets.append(makePacket(record.direction, payload: payload))
+                offset += payload.count
+            } while offset < record.data.endIndex
+            return packets
+        }
+
+        private mutating func makePacket(_ direction: Direction, payload: Data) -> Data {
+            let isOutput = direction == .output
+            let (sourcePort, destinationPort) = isOutput ? (Self.clientPort, serverPort) : (serverPort, Self.clientPort)
+            var transport = sourcePort.bigEndian.data + destinationPort.bigEndian.data
+            let proto: UInt8
+            switch content {
+            case .rtmp:
+                proto = 6
+                let reverse: Direction = isOutput ? .input : .output
+                transport.append(sequenceNumbers[direction, default: 0].bigEndian.data)
+                transport.append(sequenceNumbers[reverse, default: 0].bigEndian.data)
+                // Data offset of 5 words, PSH and ACK, the window, no checksum and no urgent pointer.
+                transport.append(contentsOf: [0x50, 0x18, 0xff, 0xff, 0x00, 0x00, 0x00, 0x00])
+                sequenceNumbers[direction, default: 0] &+= UInt32(payload.count)
+            case .srt, .ts:
+                proto = 17
+                transport.append(UInt16(8 + payload.count).bigEndian.data)
+                transport.append(contentsOf: [0x00, 0x00])
+            }
+            var header: [UInt8] = [0x45, 0x00]
+            header.append(contentsOf: UInt16(20 + transport.count + payload.count).bigEndian.data)
+            header.append(contentsOf: [0x00, 0x00, 0x40, 0x00, 64, proto, 0x00, 0x00])
+            header.append(contentsOf: isOutput ? Self.clientAddress : Self.serverAddress)
+            header.append(contentsOf: isOutput ? Self.serverAddress : Self.clientAddress)
+            let checksum = Self.checksum(header)
+            header[10] = UInt8(checksum >> 8)
+            header[11] = UInt8(checksum & 0xff)
+            return Data(header) + transport + payload
+        }
+
+        static func checksum(_ header: [UInt8]) -> UInt16 {
+            var sum: UInt32 = 0
+            for i in stride(from: 0, to: header.count, by: 2) {
+                sum += UInt32(header[i]) << 8 | UInt32(header[i + 1])
+            }
+            while sum >> 16 != 0 {
+                sum = (sum & 0xffff) + (sum >> 16)
+            }
+            return ~UInt16(sum)
+        }
+    }
+}
+
+private extension Data {
+    mutating func appendVarint(_ value: UInt64) {
+        var value = value
+        repeat {
+            let byte = UInt8(value & 0x7f)
+            value >>= 7
+            append(value == 0 ? byte : byte | 0x80)
+        } while value != 0
+    }
+
+    /// Reads a varint at the offset, and moves the offset after it.
+    func readVarint(_ offset: inout Int) -> UInt64? {
+        var value: UInt64 = 0
+        var shift: UInt64 = 0
+        var index = offset
+        while index < endIndex && shift < 64 {
+            let byte = self[index]
+            value |= UInt64(byte & 0x7f) << shift
+            index += 1
+            if byte & 0x80 == 0 {
+                offset = index
+                return value
+            }
+            shift += 7
+        }
+        return nil
+    }
+
+    mutating func appendBlock(_ type: UInt32, body: Data) {
+        let length = UInt32(12 + body.count)
+        append(type.littleEndian.data)
+        append(length.littleEndian.data)
+        append(body)
+        append(length.littleEndian.data)
+    }
+}
@@ -0,0 +1,106 @@
+import Foundation
+
+/// The NetCaptureReplayer class feeds the records of a capture back into the parsers, at the original pacing or as fast as possible.
+public final class NetCaptureReplayer {
+    /// The pacing of a replay.
+    public enum Pacing {
+        /// Feeds each record at its captured time.
+        case original
+        /// Feeds records without waiting.
+        case asFastAsPossible
+    }
+
+    /// The result of a replay.
+    public struct Result {
+        /// The number of fed records.
+        public let recordCount: Int
+        /// The number of fed bytes.
+        public let byteCount: Int
+        /// The seconds the replay took.
+        public let duration: TimeInterval
+
+        /// The fed bytes per second.
+        public var throughput: Double {
+            0 < duration ? Double(byteCount) / duration : 0
+        }
+    }
+
+    /// The content of the capture.
+    public let content: NetCapture.Content
+    /// The records of the capture.
+    public let records: [NetCapture.Record]
+
+    /// Creates a new replayer of a capture file.
+    public convenience init(url: URL) throws {
+        let (content, _, records) = try NetCapture.read(url)
+        self.init(content: content, records: records)
+    }
+
+    /// Creates a new replayer of records.
+    public init(content: NetCapture.Content, records: [NetCapture.Record]) {
+        self.content = content
+        self.records = records
+    }
+
+    /// Feeds the records of a direction to the handler on the current thread.
+    @discardableResult
+    public func replay(_ direction: NetCapture.Direction = .input, pacing: Pacing = .asFastAsPossible, handler: (Data) -> Void) -> Result {
+        let startedAt = DispatchTime.now().uptimeNanoseconds
+        var recordCount = 0
+        var byteCount = 0
+        for record in records where record.direction == direction {
+            if pacing == .original {
+                let elapsed = Double(DispatchTime.now().uptimeNanoseconds - startedAt) / 1_000_000_000
+                if elapsed < record.timestamp {
+                    Thread.sleep(forTimeInterval: record.timestamp - elapsed)
+                }
+            }
+            handler(record.data)
+            recordCount += 1
+            byteCount += record.data.count
+        }
+        return Result(
+            recordCount: recordCount,
+            byteCount: byteCount,
+            duration: Double(DispatchTime.now().uptimeNanoseconds - startedAt) / 1_000_000_000
+        )
+    }
+
+    /// Feeds the received transport stream to a reader.
+    @discardableResult
+    public func replay(to reader: TSReader, pacing: Pacing = .asFastAsPossible) -> Result {
+        var remain = Data()
+        return replay(.input, pacing: pacing) { data in
+            // A record may end in the middle of a packet over a byte stream.
+            remain.append(data)
+            let count = reader.read(remain)
+            remain = Data(remain.dropFirst(count))
+        }
+    }
+
+    /// Feeds the received RTMP messages to a connection, as a socket does after the handshake.
+    @discardableResult
+    public func replay(to connection: RTMPConnection, pacing: Pacing = .asFastAsPossible) -> Result {
+        if connection.socket == nil {
+            connection.socket = RTMPSocket()
+        }
+        let socket: any RTMPSocketCompatible = connection.socket
+        // S0, S1 and S2 precede the chunks.
+        var handshakeBytes = 1 + RTMPHandshake.sigSize * 2
+        return replay(.input, pacing: pacing) { data in
+            var data = data
+            if 0 < handshakeBytes {
+                let count = min(handshakeBytes, data.count)
+                data = Data(data.dropFirst(count))
+                handshakeBytes -= count
+            }
+            socket.inputBuffer.append(data)
+            guard !socket.inputBuffer.isEmpty else {
+                return
+            }
+            let bytes = socket.inputBuffer
+            socket.inputBuffer.removeAll()
+            connection.socket(socket, data: bytes)
+        }
+    }
+}
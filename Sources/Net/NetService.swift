@@ -33,6 +33,15 @@ open class NetService: NSObject {
         self.type = type
     }
 
+    func accept(inputStream: InputStream, outputStream: OutputStream) {
+        lockQueue.sync {
+            let client = NetClient(inputStream: inputStream, outputStream: outputStream)
+            clients.append(client)
+            client.delegate = self
+            client.acceptConnection()
+        }
+    }
+
     func disconnect(_ client: NetClient) {
         lockQueue.sync {
             guard let index: Int = clients.firstIndex(of: client) else {
@@ -79,17 +88,15 @@ open class NetService: NSObject {
 extension NetService: NetServiceDelegate {
     // MARK: NSNetServiceDelegate
     public func netService(_ sender: Foundation.NetService, didAcceptConnectionWith inputStream: InputStream, outputStream: OutputStream) {
-        lockQueue.sync {
-            let client = NetClient(inputStream: inputStream, outputStream: outputStream)
-            clients.append(client)
-            client.delegate = self
-            client.acceptConnection()
-        }
+        accept(inputStream: inputStream, outputStream: outputStream)
     }
 }
 
 extension NetService: NetClientDelegate {
     // MARK: NetClientDelegate
+    func client(inputBuffer client: NetClient) {
+    }
+
     func client(client: NetClient, isDisconnected: Bool) {
         disconnect(client)
     }
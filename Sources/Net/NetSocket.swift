@@ -26,6 +26,8 @@ open class NetSocket: NSObject {
     public private(set) var totalBytesOut: Atomic<Int64> = .init(0)
     /// Specifies  statistics of total outgoing queued bytes.
     public private(set) var queueBytesOut: Atomic<Int64> = .init(0)
+    /// Specifies the capture that records the bytes on the wire.
+    public var capture: NetCapture?
 
     var inputStream: InputStream? {
         didSet {
@@ -58,6 +60,7 @@ open class NetSocket: NSObject {
     private lazy var buffer = [UInt8](repeating: 0, count: windowSizeC)
     private lazy var outputBuffer: DataBuffer = .init(capacity: outputBufferSize)
     private lazy var outputQueue: DispatchQueue = .init(label: "com.haishinkit.HaishinKit.NetSocket.output", qos: qualityOfService)
+    private var pendingOutputs: Atomic<[Data]> = .init([])
 
     deinit {
         inputStream?.delegate = nil
@@ -81,11 +84,25 @@ open class NetSocket: NSObject {
     @discardableResult
     public func doOutput(data: Data, locked: UnsafeMutablePointer<UInt32>? = nil) -> Int {
         queueBytesOut.mutate { $0 += Int64(data.count) }
+        // Chunks are handed off in batches. Only the first chunk after a flush wakes the output queue up.
+        var isIdle = false
+        pendingOutputs.mutate {
+            isIdle = $0.isEmpty
+            $0.append(data)
+        }
+        guard isIdle else {
+            return data.count
+        }
+        IOMuxerExecutor.current?.recordHop()
         outputQueue.async { [weak self] in
             guard let self = self else {
                 return
             }
-            self.outputBuffer.append(data)
+            var outputs: [Data] = []
+            self.pendingOutputs.mutate { swap(&outputs, &$0) }
+            for output in outputs {
+                self.outputBuffer.append(output)
+            }
             if let outputStream = self.outputStream, outputStream.hasSpaceAvailable {
                 self.doOutput(outputStream)
             }
@@ -115,6 +132,7 @@ open class NetSocket: NSObject {
         totalBytesIn.mutate { $0 = 0 }
         totalBytesOut.mutate { $0 = 0 }
         queueBytesOut.mutate { $0 = 0 }
+        pendingOutputs.mutate { $0.removeAll() }
         inputBuffer.removeAll(keepingCapacity: false)
         if outputBuffer.capacity < outputBufferSize {
             outputBuffer = .init(capacity: outputBufferSize)
@@ -156,6 +174,7 @@ open class NetSocket: NSObject {
         if 0 < length {
             totalBytesIn.mutate { $0 += Int64(length) }
             inputBuffer.append(buffer, count: length)
+            capture?.append(Data(buffer[0..<length]), direction: .input)
             listen()
         }
     }
@@ -168,6 +187,7 @@ open class NetSocket: NSObject {
         if 0 < length {
             totalBytesOut.mutate { $0 += Int64(length) }
             queueBytesOut.mutate { $0 -= Int64(length) }
+            capture?.append(Data(bytes: bytes, count: length), direction: .output)
             outputBuffer.skip(length)
         }
     }
@@ -17,6 +17,8 @@ public protocol NetStreamDelegate: AnyObject {
     func stream(_ stream: NetStream, didOutput audio: AVAudioBuffer, when: AVAudioTime)
     /// Tells the receiver to playback a video packet incoming.
     func stream(_ stream: NetStream, didOutput video: CMSampleBuffer)
+    /// Tells the receiver to a timed metadata incoming.
+    func stream(_ stream: NetStream, didOutput metadata: TimedMetadata)
     #if os(iOS) || os(tvOS)
     /// Tells the receiver to session was interrupted.
     @available(tvOS 17.0, *)
@@ -33,6 +35,13 @@ public protocol NetStreamDelegate: AnyObject {
     func streamDidOpen(_ stream: NetStream)
 }
 
+extension NetStreamDelegate {
+    /// Tells the receiver to a timed metadata incoming. Its default implementation does nothing.
+    public func stream(_ stream: NetStream, didOutput metadata: TimedMetadata) {
+    }
+}
+
+// MARK: -
 /// The `NetStream` class is the foundation of a RTMPStream, HTTPStream.
 open class NetStream: NSObject {
     /// The AVAudioEngine shared instance holder.
@@ -217,6 +226,28 @@ open class NetStream: NSObject {
         }
     }
 
+    /// Specifies the ladder that encodes the mixed video into renditions besides the video codec.
+    public var videoLadder: VideoLadder? {
+        get {
+            mixer.videoIO.ladder
+        }
+        set {
+            mixer.videoIO.ladder = newValue
+        }
+    }
+
+    /// Specifies the recorder that writes the encoded samples into fragmented files.
+    public var fragmentedRecorder: IOFragmentedRecorder? {
+        get {
+            mixer.fragmentedRecorder
+        }
+        set {
+            newValue?.audioFormat = mixer.audioIO.outputFormat
+            newValue?.videoFormat = mixer.videoIO.outputFormat
+            mixer.fragmentedRecorder = newValue
+        }
+    }
+
     /// The video input format.
     public var videoInputFormat: CMVideoFormatDescription? {
         return mixer.videoIO.inputFormat
@@ -237,12 +268,63 @@ open class NetStream: NSObject {
         }
     }
 
+    /// Specifies the clock that paces the frames of the playback, e.g. a timer for a headless relay. It takes effect when the playback starts.
+    public var choreographerMode: ChoreographerMode {
+        get {
+            telly.choreographerMode
+        }
+        set {
+            telly.choreographerMode = newValue
+        }
+    }
+
     /// The number of frames per second being displayed.
-    @objc public internal(set) dynamic var currentFPS: UInt16 = 0
+    @objc public internal(set) dynamic var currentFPS: UInt16 = 0 {
+        didSet {
+            fpsGauge.mutate { $0 = currentFPS }
+        }
+    }
 
     /// Specifies the delegate..
     public weak var delegate: (any NetStreamDelegate)?
 
+    /// The histogram of microseconds from an encoder output to the socket handoff.
+    public var postEncodeLatency: Histogram {
+        executor.metrics.latency
+    }
+
+    /// The average number of queue hops per frame from an encoder output to the socket handoff.
+    public var postEncodeHopsPerFrame: Double {
+        executor.metrics.hopsPerFrame
+    }
+
+    /// The bytes buffered by the player and the recorder of the stream.
+    /// It is gauged as the player and the recorder push their changes, so reading it never builds either of them.
+    public var bufferedBytes: Int {
+        bufferedBytesGauge.value
+    }
+
+    /// Specifies whether to drop encoded video frames that no other frame depends on, e.g. while a destination falls behind.
+    public var dropsNonReferenceFrames: Bool {
+        get {
+            mixer.dropsNonReferenceFrames.value
+        }
+        set {
+            mixer.dropsNonReferenceFrames.mutate { $0 = newValue }
+        }
+    }
+
+    /// Specifies the labels that identify the metrics of the stream, e.g. ["stream": "camera1"].
+    /// Stream names aren't reported by default, as a publishing name may be a secret key. The series of streams with the same labels are added up.
+    public var metricsLabels: [String: String] {
+        get {
+            _metricsLabels.value
+        }
+        set {
+            _metricsLabels.mutate { $0 = newValue }
+        }
+    }
+
     public var readyState: ReadyState = .initialized {
         willSet {
             guard readyState != newValue else {
@@ -258,8 +340,17 @@ open class NetStream: NSObject {
         }
     }
 
+    private var bufferedBytesGauge: Atomic<Int> = .init(0)
+    private var droppedFrameCounter: Atomic<Int> = .init(0)
+    private var fpsGauge: Atomic<UInt16> = .init(0)
+    private var _metricsLabels: Atomic<[String: String]> = .init([:])
+    private var encodeLatency: Atomic<Histogram> = .init(.init())
+
+    /// The executor of the mixer, which is held apart so that reading its metrics never builds the mixer. Anything that feeds the muxer runs on it.
+    let executor = IOMuxerExecutor()
+
     private(set) lazy var mixer: IOMixer = {
-        let mixer = IOMixer()
+        let mixer = IOMixer(executor: executor)
         mixer.delegate = self
         return mixer
     }()
@@ -273,6 +364,8 @@ open class NetStream: NSObject {
     /// Creates a NetStream object.
     override public init() {
         super.init()
+        MemoryAccountant.shared.register(self, owner: self)
+        MetricsRegistry.shared.register(self)
         #if os(iOS) || os(tvOS)
         NotificationCenter.default.addObserver(self, selector: #selector(didEnterBackground(_:)), name: UIApplication.didEnterBackgroundNotification, object: nil)
         NotificationCenter.default.addObserver(self, selector: #selector(willEnterForeground(_:)), name: UIApplication.willEnterForegroundNotification, object: nil)
@@ -369,6 +462,11 @@ open class NetStream: NSObject {
         }
     }
 
+    /// Append a timed metadata that is muxed with the frame at the same timestamp.
+    public func append(_ metadata: TimedMetadata) {
+        mixer.muxer?.append(metadata)
+    }
+
     /// Register a video effect.
     public func registerVideoEffect(_ effect: VideoEffect) -> Bool {
         mixer.videoIO.lockQueue.sync {
@@ -395,6 +493,26 @@ open class NetStream: NSObject {
         mixer.recorder.stopRunning()
     }
 
+    /// Disconnects the stream from the destination. A MemoryAccountant calls it to shed a stream that falls behind.
+    /// - Returns: false unless a subclass overrides it, so that an accountant doesn't count a stream it can't shed.
+    @discardableResult
+    open func disconnect() -> Bool {
+        false
+    }
+
+    /// Reports the metrics of the stream. A MetricsRegistry calls it to collect.
+    /// It reads only atomics, as a registry collects on its own thread.
+    open func collect(_ collector: MetricsCollector) {
+        let labels = metricsLabels
+        let executor = self.executor.metrics
+        collector.gauge("haishinkit_stream_fps", help: "The number of frames per second being displayed.", value: Double(fpsGauge.value), labels: labels)
+        collector.gauge("haishinkit_stream_buffered_bytes", help: "The bytes buffered by the player and the recorder.", value: Double(bufferedBytes), labels: labels)
+        collector.gauge("haishinkit_stream_post_encode_queue_depth", help: "The number of encoded frames waiting for the muxer.", value: Double(executor.pendingCount), labels: labels)
+        collector.counter("haishinkit_stream_dropped_frames_total", help: "The number of encoded video frames dropped to shed load.", value: Double(droppedFrameCounter.value), labels: labels)
+        collector.histogram("haishinkit_stream_encode_latency_seconds", help: "The time the video codec takes to encode a frame.", histogram: encodeLatency.value, scale: 0.001, labels: labels)
+        collector.histogram("haishinkit_stream_post_encode_latency_seconds", help: "The time from an encoder output to the socket handoff.", histogram: executor.latency, scale: 0.000001, labels: labels)
+    }
+
     /// A handler that receives stream readyState will update.
     /// - Warning: Please do not call this method yourself.
     open func readyStateWillChange(to readyState: ReadyState) {
@@ -458,6 +576,18 @@ extension NetStream: IOMixerDelegate {
         delegate?.stream(self, videoErrorOccurred: error)
     }
 
+    func mixer(_ mixer: IOMixer, didBufferBytes byteCount: Int) {
+        bufferedBytesGauge.mutate { $0 += byteCount }
+    }
+
+    func mixer(_ mixer: IOMixer, didEncodeIn latency: Double) {
+        encodeLatency.mutate { $0.record(latency) }
+    }
+
+    func mixer(_ mixer: IOMixer, didDropFrame sampleBuffer: CMSampleBuffer) {
+        droppedFrameCounter.mutate { $0 += 1 }
+    }
+
     #if os(iOS) || os(tvOS)
     @available(tvOS 17.0, *)
     func mixer(_ mixer: IOMixer, sessionWasInterrupted session: AVCaptureSession, reason: AVCaptureSession.InterruptionReason?) {
@@ -471,6 +601,12 @@ extension NetStream: IOMixerDelegate {
     #endif
 }
 
+extension NetStream: MetricsCollectable {
+}
+
+extension NetStream: MemoryAccountable {
+}
+
 extension NetStream: IOTellyUnitDelegate {
     // MARK: IOTellyUnitDelegate
     func tellyUnit(_ tellyUnit: IOTellyUnit, dequeue sampleBuffer: CMSampleBuffer) {
@@ -480,6 +616,10 @@ extension NetStream: IOTellyUnitDelegate {
     func tellyUnit(_ tellyUnit: IOTellyUnit, didBufferingChanged: Bool) {
     }
 
+    func tellyUnit(_ tellyUnit: IOTellyUnit, didBufferBytes byteCount: Int) {
+        bufferedBytesGauge.mutate { $0 += byteCount }
+    }
+
     func tellyUnit(_ tellyUnit: IOTellyUnit, didSetAudioFormat audioFormat: AVAudioFormat?) {
         guard let audioEngine = mixer.audioEngine else {
             return
@@ -487,13 +627,17 @@ extension NetStream: IOTellyUnitDelegate {
         nstry({
             if let audioFormat {
                 audioEngine.attach(tellyUnit.playerNode)
-                audioEngine.connect(tellyUnit.playerNode, to: audioEngine.mainMixerNode, format: audioFormat)
+                audioEngine.attach(tellyUnit.timePitchNode)
+                audioEngine.connect(tellyUnit.playerNode, to: tellyUnit.timePitchNode, format: audioFormat)
+                audioEngine.connect(tellyUnit.timePitchNode, to: audioEngine.mainMixerNode, format: audioFormat)
                 if !audioEngine.isRunning {
                     try? audioEngine.start()
                 }
             } else {
                 audioEngine.detach(tellyUnit.playerNode)
                 audioEngine.disconnectNodeInput(tellyUnit.playerNode)
+                audioEngine.detach(tellyUnit.timePitchNode)
+                audioEngine.disconnectNodeInput(tellyUnit.timePitchNode)
                 if audioEngine.isRunning {
                     audioEngine.stop()
                 }
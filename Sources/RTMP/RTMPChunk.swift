@@ -41,6 +41,7 @@ final class RTMPChunk {
         case audio = 0x04
         case video = 0x05
         case data = 0x08
+        case timedMetadata = 0x0A
     }
 
     static let defaultSize: Int = 128
@@ -215,6 +215,26 @@ public class RTMPConnection: EventDispatcher {
     }
     /// Specifies the delegate of the NetStream.
     public weak var delegate: (any RTMPConnectionDelegate)?
+    /// The bytes queued to send, sampled every second while connected.
+    public var bufferedBytes: Int {
+        queueBytesOutGauge.value
+    }
+    /// Specifies whether the streams drop encoded video frames that no other frame depends on.
+    public var dropsNonReferenceFrames = false {
+        didSet {
+            for stream in streams {
+                stream.dropsNonReferenceFrames = dropsNonReferenceFrames
+            }
+        }
+    }
+    /// Specifies the capture that records the bytes on the wire, e.g. to replay a session with NetCaptureReplayer.
+    public var capture: NetCapture? {
+        didSet {
+            socket?.capture = capture
+        }
+    }
+    /// Specifies the labels that identify the metrics of the connection, e.g. ["connection": "ingest1"].
+    public var metricsLabels: [String: String] = [:]
     /// The statistics of outgoing queue bytes per second.
     @objc open private(set) dynamic var previousQueueBytesOut: [Int64] = []
     /// The statistics of incoming bytes per second.
@@ -257,10 +277,14 @@ public class RTMPConnection: EventDispatcher {
     private var fragmentedChunks: [UInt16: RTMPChunk] = [:]
     private var previousTotalBytesIn: Int64 = 0
     private var previousTotalBytesOut: Int64 = 0
+    /// The snapshot of the socket queue taken every second, as the socket is replaced on the caller thread.
+    private var queueBytesOutGauge: Atomic<Int> = .init(0)
 
     /// Creates a new connection.
     override public init() {
         super.init()
+        MemoryAccountant.shared.register(self, owner: self)
+        MetricsRegistry.shared.register(self)
         addEventListener(.rtmpStatus, selector: #selector(on(status:)))
     }
 
@@ -308,6 +332,7 @@ public class RTMPConnection: EventDispatcher {
             }
         }
         socket.delegate = self
+        socket.capture = capture
         var outputBufferSize: Int = 0
         for stream in streams {
             // in bytes.
@@ -328,6 +353,7 @@ public class RTMPConnection: EventDispatcher {
     }
 
     func close(isDisconnected: Bool) {
+        queueBytesOutGauge.mutate { $0 = 0 }
         guard connected || isDisconnected else {
             timer = nil
             return
@@ -451,6 +477,7 @@ public class RTMPConnection: EventDispatcher {
         let totalBytesIn = self.totalBytesIn
         let totalBytesOut = self.totalBytesOut
         let queueBytesOut = self.socket.queueBytesOut.value
+        queueBytesOutGauge.mutate { $0 = Int(queueBytesOut) }
         currentBytesInPerSecond = Int32(totalBytesIn - previousTotalBytesIn)
         currentBytesOutPerSecond = Int32(totalBytesOut - previousTotalBytesOut)
         previousTotalBytesIn = totalBytesIn
@@ -491,6 +518,28 @@ public class RTMPConnection: EventDispatcher {
     }
 }
 
+extension RTMPConnection: MemoryAccountable {
+    // MARK: MemoryAccountable
+    @discardableResult
+    public func disconnect() -> Bool {
+        close()
+        return true
+    }
+}
+
+extension RTMPConnection: MetricsCollectable {
+    // MARK: MetricsCollectable
+    public func collect(_ collector: MetricsCollector) {
+        collector.gauge("haishinkit_rtmp_connection_connected", help: "Whether the connection is connected.", value: connected ? 1 : 0, labels: metricsLabels)
+        collector.gauge("haishinkit_rtmp_connection_streams", help: "The number of streams on the connection.", value: Double(totalStreamsCount), labels: metricsLabels)
+        collector.counter("haishinkit_rtmp_connection_received_bytes_total", help: "The bytes received.", value: Double(socket?.totalBytesIn.value ?? 0), labels: metricsLabels)
+        collector.counter("haishinkit_rtmp_connection_sent_bytes_total", help: "The bytes sent.", value: Double(socket?.totalBytesOut.value ?? 0), labels: metricsLabels)
+        collector.gauge("haishinkit_rtmp_connection_received_bytes_per_second", help: "The bytes received in the last second.", value: Double(currentBytesInPerSecond), labels: metricsLabels)
+        collector.gauge("haishinkit_rtmp_connection_sent_bytes_per_second", help: "The bytes sent in the last second.", value: Double(currentBytesOutPerSecond), labels: metricsLabels)
+        collector.gauge("haishinkit_rtmp_connection_queued_bytes", help: "The bytes queued to send.", value: Double(bufferedBytes), labels: metricsLabels)
+    }
+}
+
 extension RTMPConnection: RTMPSocketDelegate {
     // MARK: RTMPSocketDelegate
     func socket(_ socket: any RTMPSocketCompatible, readyState: RTMPSocketReadyState) {
@@ -569,6 +618,7 @@ extension RTMPConnection: RTMPSocketDelegate {
             case .three:
                 break
             }
+            message.chunkStreamId = chunk.streamId
             message.execute(self, type: chunk.type)
             currentChunk = nil
             messages[chunk.streamId] = message
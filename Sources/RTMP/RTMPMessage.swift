@@ -59,6 +59,8 @@ class RTMPMessage {
     var streamId: UInt32 = 0
     var timestamp: UInt32 = 0
     var payload = Data()
+    /// The chunk stream the message arrived on, whose previous message the timestamp of type 1 to 3 chunks is relative to.
+    var chunkStreamId: UInt16 = 0
 
     init(type: RTMPMessageType) {
         self.type = type
@@ -387,6 +389,12 @@ final class RTMPDataMessage: RTMPMessage {
                 return
             }
 
+            if newValue.starts(with: RTMPTimedMetadataMessage.header) {
+                handlerName = RTMPTimedMetadataMessage.handlerName
+                super.payload = newValue
+                return
+            }
+
             if length == newValue.count {
                 serializer.writeBytes(newValue)
                 serializer.position = 0
@@ -426,7 +434,77 @@ final class RTMPDataMessage: RTMPMessage {
         guard let stream = connection.streams.first(where: { $0.id == streamId }) else {
             return
         }
-        stream.info.byteCount.mutate { $0 += Int64(payload.count) }
+        // Every data message advances the timestamp of its chunk stream, whether it carries timed metadata or not.
+        stream.muxer.append(self, type: type)
+    }
+}
+
+// MARK: -
+/**
+ 7.1.2. Data Message (18) for a timed metadata.
+ The payload is the AMF0 handler name followed by an AMF3 ByteArray, so that a binary payload is sent without the dynamic AMF encoding.
+ */
+final class RTMPTimedMetadataMessage: RTMPMessage {
+    static let handlerName = "onTimedMetadata"
+    static let header: Data = ByteArray()
+        .writeUInt8(AMF0Type.string.rawValue)
+        .writeUInt16(UInt16(handlerName.utf8.count))
+        .writeUTF8Bytes(handlerName)
+        .writeUInt8(AMF0Type.avmplush.rawValue)
+        .writeUInt8(AMF3Type.byteArray.rawValue)
+        .data
+
+    /// Extracts a binary payload from a data message payload.
+    static func decode(_ payload: Data) -> Data? {
+        guard payload.starts(with: header) else {
+            return nil
+        }
+        var position = payload.startIndex + header.count
+        var value = 0
+        for count in 0..<4 {
+            guard position < payload.endIndex else {
+                return nil
+            }
+            let byte = payload[position]
+            position += 1
+            if count == 3 {
+                value = value << 8 | Int(byte)
+                break
+            }
+            value = value << 7 | Int(byte & 0x7F)
+            if byte & 0x80 == 0 {
+                break
+            }
+        }
+        let length = value >> 1
+        guard value & 0x01 == 0x01, length <= payload.endIndex - position else {
+            return nil
+        }
+        return payload.subdata(in: position..<position + length)
+    }
+
+    static func encode(_ length: Int) -> Data {
+        let value = UInt32(length << 1 | 0x01)
+        switch UInt32(0) {
+        case value & 0xFFFFFF80:
+            return Data([UInt8(value & 0x7F)])
+        case value & 0xFFFFC000:
+            return Data([UInt8(value >> 7 & 0x7F | 0x80), UInt8(value & 0x7F)])
+        case value & 0xFFE00000:
+            return Data([UInt8(value >> 14 & 0x7F | 0x80), UInt8(value >> 7 & 0x7F | 0x80), UInt8(value & 0x7F)])
+        default:
+            return Data([UInt8(value >> 22 & 0x7F | 0x80), UInt8(value >> 15 & 0x7F | 0x80), UInt8(value >> 8 & 0x7F | 0x80), UInt8(value & 0xFF)])
+        }
+    }
+
+    init(streamId: UInt32, timestamp: UInt32, metadata: Data) {
+        super.init(type: .amf0Data)
+        self.streamId = streamId
+        self.timestamp = timestamp
+        var payload = RTMPTimedMetadataMessage.header
+        payload.append(RTMPTimedMetadataMessage.encode(metadata.count))
+        payload.append(metadata)
+        self.payload = payload
     }
 }
 
@@ -653,9 +731,60 @@ final class RTMPVideoMessage: RTMPMessage {
  7.1.6. Aggregate Message (22)
  */
 final class RTMPAggregateMessage: RTMPMessage {
+    /// The size of a FLV tag header.
+    static let tagHeaderSize = 11
+    /// The size of a FLV back pointer.
+    static let backPointerSize = 4
+
     init() {
         super.init(type: .aggregate)
     }
+
+    init(streamId: UInt32, timestamp: UInt32, payload: Data) {
+        super.init(type: .aggregate)
+        self.streamId = streamId
+        self.timestamp = timestamp
+        self.payload = payload
+    }
+
+    override func execute(_ connection: RTMPConnection, type: RTMPChunkType) {
+        guard let stream = connection.streams.first(where: { $0.id == streamId }) else {
+            return
+        }
+        stream.muxer.append(self, type: type)
+    }
+
+    /// Splits the payload into audio and video messages. Timestamps are rebased onto the absolute timestamp of the aggregate message.
+    /// The timestamp of a message in a type 1, 2 or 3 chunk is a delta, so the caller passes the accumulated one.
+    func makeMessages(_ timestamp: UInt32? = nil) -> [RTMPMessage] {
+        let timestamp = timestamp ?? self.timestamp
+        var messages: [RTMPMessage] = []
+        var offset: Int64?
+        var cursor = payload.startIndex
+        while cursor + RTMPAggregateMessage.tagHeaderSize <= payload.endIndex {
+            let tagType = payload[cursor] & 0x1F
+            let dataSize = Int(payload[cursor + 1]) << 16 | Int(payload[cursor + 2]) << 8 | Int(payload[cursor + 3])
+            let tagTimestamp = Int64(payload[cursor + 7]) << 24 | Int64(payload[cursor + 4]) << 16 | Int64(payload[cursor + 5]) << 8 | Int64(payload[cursor + 6])
+            let start = cursor + RTMPAggregateMessage.tagHeaderSize
+            guard start + dataSize <= payload.endIndex else {
+                break
+            }
+            if offset == nil {
+                offset = Int64(timestamp) - tagTimestamp
+            }
+            let messageTimestamp = UInt32(truncatingIfNeeded: tagTimestamp + (offset ?? 0))
+            switch FLVTagType(rawValue: tagType) {
+            case .audio:
+                messages.append(RTMPAudioMessage(streamId: streamId, timestamp: messageTimestamp, payload: payload.subdata(in: start..<start + dataSize)))
+            case .video:
+                messages.append(RTMPVideoMessage(streamId: streamId, timestamp: messageTimestamp, payload: payload.subdata(in: start..<start + dataSize)))
+            default:
+                break
+            }
+            cursor = start + dataSize + RTMPAggregateMessage.backPointerSize
+        }
+        return messages
+    }
 }
 
 // MARK: -
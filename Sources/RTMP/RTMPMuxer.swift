@@ -2,6 +2,7 @@ import AVFoundation
 
 // MARK: -
 final class RTMPMuxer {
+    static let aggregatedAudioPacketCapacity: AVAudioPacketCount = 64
     static let aac: UInt8 = FLVAudioCodec.aac.rawValue << 4 | FLVSoundRate.kHz44.rawValue << 2 | FLVSoundSize.snd16bit.rawValue << 1 | FLVSoundType.stereo.rawValue
 
     var audioFormat: AVAudioFormat? {
@@ -17,8 +18,10 @@ final class RTMPMuxer {
             case .playing:
                 if let audioFormat {
                     audioBuffer = AVAudioCompressedBuffer(format: audioFormat, packetCapacity: 1, maximumPacketSize: 1024 * Int(audioFormat.channelCount))
+                    aggregatedAudioBuffer = AVAudioCompressedBuffer(format: audioFormat, packetCapacity: RTMPMuxer.aggregatedAudioPacketCapacity, maximumPacketSize: 1024 * Int(audioFormat.channelCount))
                 } else {
                     audioBuffer = nil
+                    aggregatedAudioBuffer = nil
                 }
             default:
                 break
@@ -60,9 +63,16 @@ final class RTMPMuxer {
     }
 
     var isRunning: Atomic<Bool> = .init(false)
+    var latencyProbe: LatencyProbe?
+    var gateway: RTMPTSGateway?
     private var videoTimeStamp: CMTime = .zero
     private var audioBuffer: AVAudioCompressedBuffer?
+    private var aggregatedAudioBuffer: AVAudioCompressedBuffer?
     private var audioTimeStamp: AVAudioTime = .init(hostTime: 0)
+    private var dataTimeStamps: [UInt16: CMTime] = [:]
+    private var aggregateTimeStamp: UInt32 = 0
+    private var timedMetadatas = TimedMetadataQueue()
+    private var timedMetadataTimeStamp: CMTime = .invalid
     private let compositiionTimeOffset: CMTime = .init(value: 3, timescale: 30)
     private weak var stream: RTMPStream?
 
@@ -75,6 +85,10 @@ final class RTMPMuxer {
         let codec = message.codec
         stream?.info.byteCount.mutate { $0 += Int64(payload.count) }
 
+        if let gateway {
+            gateway.append(message, type: type)
+            return
+        }
         guard let stream, message.codec.isSupported else {
             return
         }
@@ -112,6 +126,10 @@ final class RTMPMuxer {
 
     func append(_ message: RTMPVideoMessage, type: RTMPChunkType) {
         stream?.info.byteCount.mutate { $0 += Int64( message.payload.count) }
+        if let gateway {
+            gateway.append(message, type: type)
+            return
+        }
         guard let stream, FLVTagType.video.headerSize <= message.payload.count && message.isSupported else {
             return
         }
@@ -122,6 +140,7 @@ final class RTMPMuxer {
             case FLVVideoPacketType.sequenceStart.rawValue:
                 videoFormat = message.makeFormatDescription()
             case FLVVideoPacketType.codedFrames.rawValue:
+                latencyProbe?.probe(message.payload)
                 if let sampleBuffer = message.makeSampleBuffer(videoTimeStamp, formatDesciption: videoFormat) {
                     stream.mixer.videoIO.append(sampleBuffer)
                 }
@@ -133,6 +152,7 @@ final class RTMPMuxer {
             case FLVAVCPacketType.seq.rawValue:
                 videoFormat = message.makeFormatDescription()
             case FLVAVCPacketType.nal.rawValue:
+                latencyProbe?.probe(message.payload)
                 if let sampleBuffer = message.makeSampleBuffer(videoTimeStamp, formatDesciption: videoFormat) {
                     stream.mixer.videoIO.append(sampleBuffer)
                 }
@@ -148,6 +168,107 @@ final class RTMPMuxer {
             videoTimeStamp = CMTimeAdd(videoTimeStamp, .init(value: CMTimeValue(message.timestamp), timescale: 1000))
         }
     }
+
+    func append(_ message: RTMPAggregateMessage, type: RTMPChunkType) {
+        switch type {
+        case .zero:
+            aggregateTimeStamp = message.timestamp
+        default:
+            aggregateTimeStamp &+= message.timestamp
+        }
+        guard let stream else {
+            return
+        }
+        let messages = message.makeMessages(aggregateTimeStamp)
+        if gateway != nil {
+            for message in messages {
+                switch message {
+                case let message as RTMPAudioMessage:
+                    append(message, type: .zero)
+                case let message as RTMPVideoMessage:
+                    append(message, type: .zero)
+                default:
+                    break
+                }
+            }
+            return
+        }
+        // Consecutive raw AAC frames in an aggregate message are handed to the decoder as one multi-packet buffer.
+        var audioPacketTimeStamp: AVAudioTime?
+        for message in messages {
+            switch message {
+            case let message as RTMPAudioMessage:
+                let payload = message.payload
+                let codec = message.codec
+                guard
+                    codec == .aac,
+                    codec.headerSize < payload.count,
+                    payload[1] == FLVAACPacketType.raw.rawValue,
+                    let aggregatedAudioBuffer, aggregatedAudioBuffer.packetCount < aggregatedAudioBuffer.packetCapacity else {
+                    if let audioPacketTimeStamp, let aggregatedAudioBuffer {
+                        stream.mixer.audioIO.append(aggregatedAudioBuffer, when: audioPacketTimeStamp)
+                        aggregatedAudioBuffer.removeAll()
+                    }
+                    audioPacketTimeStamp = nil
+                    append(message, type: .zero)
+                    continue
+                }
+                stream.info.byteCount.mutate { $0 += Int64(payload.count) }
+                let appended = payload.withUnsafeBytes { (buffer: UnsafeRawBufferPointer) -> Bool in
+                    guard let baseAddress = buffer.baseAddress else {
+                        return false
+                    }
+                    return aggregatedAudioBuffer.append(baseAddress.advanced(by: codec.headerSize), count: payload.count - codec.headerSize)
+                }
+                audioTimeStamp = .init(hostTime: AVAudioTime.hostTime(forSeconds: Double(message.timestamp) / 1000))
+                if appended && audioPacketTimeStamp == nil {
+                    audioPacketTimeStamp = audioTimeStamp
+                }
+            case let message as RTMPVideoMessage:
+                append(message, type: .zero)
+            default:
+                break
+            }
+        }
+        if let audioPacketTimeStamp, let aggregatedAudioBuffer {
+            stream.mixer.audioIO.append(aggregatedAudioBuffer, when: audioPacketTimeStamp)
+            aggregatedAudioBuffer.removeAll()
+        }
+    }
+
+    func append(_ message: RTMPDataMessage, type: RTMPChunkType) {
+        stream?.info.byteCount.mutate { $0 += Int64(message.payload.count) }
+        let timestamp = CMTime(value: CMTimeValue(message.timestamp), timescale: 1000)
+        let dataTimeStamp: CMTime
+        switch type {
+        case .zero:
+            dataTimeStamp = timestamp
+        default:
+            dataTimeStamp = CMTimeAdd(dataTimeStamps[message.chunkStreamId] ?? .zero, timestamp)
+        }
+        dataTimeStamps[message.chunkStreamId] = dataTimeStamp
+        guard
+            let stream,
+            message.handlerName == RTMPTimedMetadataMessage.handlerName,
+            let payload = RTMPTimedMetadataMessage.decode(message.payload) else {
+            return
+        }
+        stream.delegate?.stream(stream, didOutput: TimedMetadata(timestamp: dataTimeStamp, payload: payload))
+    }
+
+    private func outputTimedMetadata(_ timestamp: CMTime, decodeTimeStamp: CMTime) {
+        // The first frame of the stream is sent at 0 msec.
+        if timedMetadataTimeStamp == .invalid {
+            timedMetadataTimeStamp = decodeTimeStamp
+        }
+        guard !timedMetadatas.isEmpty else {
+            return
+        }
+        for metadata in timedMetadatas.dequeue(timestamp) {
+            let delta = max(0, (metadata.timestamp - timedMetadataTimeStamp).seconds * 1000)
+            stream?.outputTimedMetadata(metadata.payload, withTimestamp: UInt32(delta))
+        }
+    }
 }
 
 extension RTMPMuxer: IOMuxer {
@@ -161,8 +282,15 @@ extension RTMPMuxer: IOMuxer {
         guard 0 <= delta else {
             return
         }
-        var buffer = Data([RTMPMuxer.aac, FLVAACPacketType.raw.rawValue])
-        buffer.append(audioBuffer.data.assumingMemoryBound(to: UInt8.self), count: Int(audioBuffer.byteLength))
+        if videoFormat == nil {
+            outputTimedMetadata(when.makeTime(), decodeTimeStamp: when.makeTime())
+        }
+        let byteLength = Int(audioBuffer.byteLength)
+        let buffer = BufferPool.shared.makeData(count: 2 + byteLength) { pointer in
+            pointer[0] = RTMPMuxer.aac
+            pointer[1] = FLVAACPacketType.raw.rawValue
+            pointer.baseAddress?.advanced(by: 2).copyMemory(from: audioBuffer.data, byteCount: byteLength)
+        }
         stream?.outputAudio(buffer, withTimestamp: delta)
         audioTimeStamp = when
     }
@@ -172,23 +300,36 @@ extension RTMPMuxer: IOMuxer {
         let decodeTimeStamp = sampleBuffer.decodeTimeStamp.isValid ? sampleBuffer.decodeTimeStamp : sampleBuffer.presentationTimeStamp
         let compositionTime = getCompositionTime(sampleBuffer)
         let delta = videoTimeStamp == .zero ? 0 : (decodeTimeStamp.seconds - videoTimeStamp.seconds) * 1000
-        guard let formatDescription = sampleBuffer.formatDescription, let data = sampleBuffer.dataBuffer?.data, 0 <= delta else {
+        guard let formatDescription = sampleBuffer.formatDescription, let dataBuffer = sampleBuffer.dataBuffer, 0 <= delta else {
             return
         }
+        outputTimedMetadata(sampleBuffer.presentationTimeStamp, decodeTimeStamp: decodeTimeStamp)
+        var header: Data
         switch CMFormatDescriptionGetMediaSubType(formatDescription) {
         case kCMVideoCodecType_H264:
-            var buffer = Data([((keyframe ? FLVFrameType.key.rawValue : FLVFrameType.inter.rawValue) << 4) | FLVVideoCodec.avc.rawValue, FLVAVCPacketType.nal.rawValue])
-            buffer.append(contentsOf: compositionTime.bigEndian.data[1..<4])
-            buffer.append(data)
-            stream?.outputVideo(buffer, withTimestamp: delta)
+            header = Data([((keyframe ? FLVFrameType.key.rawValue : FLVFrameType.inter.rawValue) << 4) | FLVVideoCodec.avc.rawValue, FLVAVCPacketType.nal.rawValue])
+            header.append(contentsOf: compositionTime.bigEndian.data[1..<4])
+            if let latencyProbe {
+                header.append(latencyProbe.makeLengthPrefixedNALUnit(sampleBuffer.presentationTimeStamp, isHEVC: false))
+            }
         case kCMVideoCodecType_HEVC:
-            var buffer = Data([0b10000000 | ((keyframe ? FLVFrameType.key.rawValue : FLVFrameType.inter.rawValue) << 4) | FLVVideoPacketType.codedFrames.rawValue, 0x68, 0x76, 0x63, 0x31])
-            buffer.append(contentsOf: compositionTime.bigEndian.data[1..<4])
-            buffer.append(data)
-            stream?.outputVideo(buffer, withTimestamp: delta)
+            header = Data([0b10000000 | ((keyframe ? FLVFrameType.key.rawValue : FLVFrameType.inter.rawValue) << 4) | FLVVideoPacketType.codedFrames.rawValue, 0x68, 0x76, 0x63, 0x31])
+            header.append(contentsOf: compositionTime.bigEndian.data[1..<4])
+            if let latencyProbe {
+                header.append(latencyProbe.makeLengthPrefixedNALUnit(sampleBuffer.presentationTimeStamp, isHEVC: true))
+            }
         default:
-            break
+            videoTimeStamp = decodeTimeStamp
+            return
+        }
+        // Copies the sample straight from the block buffer into a pooled buffer.
+        let buffer = BufferPool.shared.makeData(count: header.count + dataBuffer.dataLength) { pointer in
+            header.copyBytes(to: pointer)
+            if let baseAddress = pointer.baseAddress {
+                dataBuffer.copyDataBytes(to: baseAddress.advanced(by: header.count))
+            }
         }
+        stream?.outputVideo(buffer, withTimestamp: delta)
         videoTimeStamp = decodeTimeStamp
     }
 
@@ -198,6 +339,10 @@ extension RTMPMuxer: IOMuxer {
         }
         return Int32((sampleBuffer.presentationTimeStamp - videoTimeStamp + compositiionTimeOffset).seconds * 1000)
     }
+
+    func append(_ metadata: TimedMetadata) {
+        timedMetadatas.enqueue(metadata)
+    }
 }
 
 extension RTMPMuxer: Running {
@@ -208,6 +353,9 @@ extension RTMPMuxer: Running {
         }
         audioTimeStamp = .init(hostTime: 0)
         videoTimeStamp = .zero
+        dataTimeStamps.removeAll()
+        timedMetadatas.clear()
+        timedMetadataTimeStamp = .invalid
         audioFormat = nil
         videoFormat = nil
         isRunning.mutate { $0 = true }
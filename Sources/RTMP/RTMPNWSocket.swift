@@ -30,6 +30,7 @@ final class RTMPNWSocket: RTMPSocketCompatible {
     }
     var qualityOfService: DispatchQoS = .userInitiated
     var inputBuffer = Data()
+    var capture: NetCapture?
     weak var delegate: (any RTMPSocketDelegate)?
 
     private(set) var queueBytesOut: Atomic<Int64> = .init(0)
@@ -116,10 +117,12 @@ final class RTMPNWSocket: RTMPSocketCompatible {
     @discardableResult
     func doOutput(chunk: RTMPChunk) -> Int {
         let chunks: [Data] = chunk.split(chunkSizeS)
-        for i in 0..<chunks.count - 1 {
-            doOutput(data: chunks[i])
+        // Sends the chunks of a message at once instead of one send per chunk.
+        var data = Data(capacity: chunks.reduce(0) { $0 + $1.count })
+        for chunk in chunks {
+            data.append(chunk)
         }
-        doOutput(data: chunks.last!)
+        doOutput(data: data)
         if logger.isEnabledFor(level: .trace) {
             logger.trace(chunk)
         }
@@ -129,6 +132,7 @@ final class RTMPNWSocket: RTMPSocketCompatible {
     @discardableResult
     func doOutput(data: Data) -> Int {
         queueBytesOut.mutate { $0 += Int64(data.count) }
+        capture?.append(data, direction: .output)
         connection?.send(content: data, completion: .contentProcessed { error in
             guard self.connected else {
                 return
@@ -192,6 +196,7 @@ final class RTMPNWSocket: RTMPSocketCompatible {
                 return
             }
             self.inputBuffer.append(data)
+            self.capture?.append(data, direction: .input)
             self.totalBytesIn.mutate { $0 += Int64(data.count) }
             self.listen()
             self.receive(on: connection)
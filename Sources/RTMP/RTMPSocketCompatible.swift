@@ -24,6 +24,7 @@ protocol RTMPSocketCompatible: AnyObject {
     var queueBytesOut: Atomic<Int64> { get }
     var securityLevel: StreamSocketSecurityLevel { get set }
     var qualityOfService: DispatchQoS { get set }
+    var capture: NetCapture? { get set }
 
     @discardableResult
     func doOutput(chunk: RTMPChunk) -> Int
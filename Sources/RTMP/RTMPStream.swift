@@ -159,6 +159,25 @@ open class RTMPStream: NetStream {
     public internal(set) var info = RTMPStreamInfo()
     /// The object encoding (AMF). Framework supports AMF0 only.
     public private(set) var objectEncoding: RTMPObjectEncoding = RTMPConnection.defaultObjectEncoding
+    /// Specifies the latency probe that embeds capture times into outgoing video and measures them on incoming video.
+    public var latencyProbe: LatencyProbe? {
+        get {
+            muxer.latencyProbe
+        }
+        set {
+            muxer.latencyProbe = newValue
+        }
+    }
+    /// Specifies the gateway that remuxes incoming audio and video to transport stream without decoding.
+    /// While it is set, playback doesn't decode or render incoming media.
+    public var gateway: RTMPTSGateway? {
+        get {
+            muxer.gateway
+        }
+        set {
+            muxer.gateway = newValue
+        }
+    }
     /// Incoming audio plays on the stream or not.
     public var receiveAudio = true {
         didSet {
@@ -239,6 +258,8 @@ open class RTMPStream: NetStream {
     private var pausedStatus = PausedStatus(hasAudio: false, hasVideo: false)
     private var howToPublish: RTMPStream.HowToPublish = .live
     private var dataTimeStamps: [String: Date] = .init()
+    /// The bytes per second of the last second, which collect(_:) reads from the thread of a registry.
+    private var bytesPerSecondGauge: Atomic<Int32> = .init(0)
     private weak var rtmpConnection: RTMPConnection?
 
     /// Creates a new stream.
@@ -359,6 +380,18 @@ open class RTMPStream: NetStream {
         close(withLockQueue: true)
     }
 
+    @discardableResult
+    override public func disconnect() -> Bool {
+        close()
+        return true
+    }
+
+    override public func collect(_ collector: MetricsCollector) {
+        super.collect(collector)
+        collector.counter("haishinkit_rtmp_stream_bytes_total", help: "The bytes of the stream sent or received.", value: Double(info.byteCount.value), labels: metricsLabels)
+        collector.gauge("haishinkit_rtmp_stream_bytes_per_second", help: "The bytes of the stream sent or received in the last second.", value: Double(bytesPerSecondGauge.value), labels: metricsLabels)
+    }
+
     /// Sends a message on a published stream to all subscribing clients.
     public func send(handlerName: String, arguments: Any?...) {
         lockQueue.async {
@@ -429,6 +462,7 @@ open class RTMPStream: NetStream {
             currentFPS = 0
             frameCount = 0
             info.clear()
+            bytesPerSecondGauge.mutate { $0 = 0 }
             delegate?.streamDidOpen(self)
             for message in messages {
                 rtmpConnection.currentTransactionId += 1
@@ -492,6 +526,8 @@ open class RTMPStream: NetStream {
         currentFPS = frameCount
         frameCount = 0
         info.on(timer: timer)
+        let currentBytesPerSecond = info.currentBytesPerSecond
+        bytesPerSecondGauge.mutate { $0 = currentBytesPerSecond }
     }
 
     func outputAudio(_ buffer: Data, withTimestamp: Double) {
@@ -528,6 +564,18 @@ open class RTMPStream: NetStream {
         frameCount += 1
     }
 
+    func outputTimedMetadata(_ buffer: Data, withTimestamp: UInt32) {
+        guard let rtmpConnection, readyState == .publishing(muxer: muxer) else {
+            return
+        }
+        let length = rtmpConnection.socket.doOutput(chunk: RTMPChunk(
+            type: .zero,
+            streamId: RTMPChunk.StreamID.timedMetadata.rawValue,
+            message: RTMPTimedMetadataMessage(streamId: id, timestamp: withTimestamp, metadata: buffer)
+        ))
+        info.byteCount.mutate { $0 += Int64(length) }
+    }
+
     @objc
     private func on(status: Notification) {
         guard let rtmpConnection else {
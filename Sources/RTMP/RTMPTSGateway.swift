@@ -0,0 +1,238 @@
+import Foundation
+
+/// The interface a RTMPTSGateway uses to inform its delegate.
+public protocol RTMPTSGatewayDelegate: AnyObject {
+    func gateway(_ gateway: RTMPTSGateway, didOutput data: Data)
+}
+
+/// The RTMPTSGateway class remuxes RTMP audio and video messages (FLV tag bodies) into an MPEG-2 transport stream, e.g. to forward an RTMP publish to SRT.
+///
+/// It converts AVCC to Annex-B and raw AAC to ADTS straight from the payloads without Core Media objects. Timestamps stay in integer 90kHz ticks,
+/// so that RTMP timestamps and composition time offsets are exact in PTS and DTS.
+/// - Note: Only H.264 and AAC are supported.
+public final class RTMPTSGateway {
+    /// The delay in 90kHz ticks of PTS and DTS ahead of PCR, which leaves decoders room to buffer.
+    public static let delay: UInt64 = 63000
+    static let pcrInterval: UInt64 = 20 * 90
+    static let programInterval: UInt64 = 1000 * 90
+
+    /// Specifies the delegate object.
+    public weak var delegate: (any RTMPTSGatewayDelegate)?
+    /// Whether the stream carries audio.
+    public let hasAudio: Bool
+    /// Whether the stream carries video.
+    public let hasVideo: Bool
+    /// The number of remuxed audio and video frames.
+    public private(set) var frameCount = 0
+
+    private var audioConfig: AudioSpecificConfig?
+    private var videoConfig: AVCDecoderConfigurationRecord?
+    private var audioTimestamp: UInt32 = 0
+    private var videoTimestamp: UInt32 = 0
+    private var pcrTimestamp: UInt64?
+    private var programTimestamp: UInt64?
+    private var continuityCounters: [UInt16: UInt8] = [:]
+    private let PAT: TSProgramAssociation = {
+        let PAT = TSProgramAssociation()
+        PAT.programs = [1: TSWriter.defaultPMTPID]
+        return PAT
+    }()
+    private let PMT = TSProgramMap()
+
+    private var canWrite: Bool {
+        (!hasAudio || audioConfig != nil) && (!hasVideo || videoConfig != nil)
+    }
+
+    private var PCRPID: UInt16 {
+        hasVideo ? TSWriter.defaultVideoPID : TSWriter.defaultAudioPID
+    }
+
+    /// Creates a new gateway. Frames are held back until the sequence headers of all expected streams arrive.
+    public init(hasAudio: Bool = true, hasVideo: Bool = true) {
+        self.hasAudio = hasAudio
+        self.hasVideo = hasVideo
+        if hasVideo {
+            var data = ESSpecificData()
+            data.streamType = .h264
+            data.elementaryPID = TSWriter.defaultVideoPID
+            PMT.elementaryStreamSpecificData.append(data)
+        }
+        if hasAudio {
+            var data = ESSpecificData()
+            data.streamType = .adtsAac
+            data.elementaryPID = TSWriter.defaultAudioPID
+            PMT.elementaryStreamSpecificData.append(data)
+        }
+        PMT.PCRPID = PCRPID
+    }
+
+    /// Appends the body of an audio tag. The timestamp is absolute in milliseconds.
+    public func append(audio payload: Data, timestamp: UInt32) {
+        let index = payload.startIndex
+        guard hasAudio, 2 < payload.count, payload[index] >> 4 == FLVAudioCodec.aac.rawValue else {
+            return
+        }
+        switch payload[index + 1] {
+        case FLVAACPacketType.seq.rawValue:
+            guard 4 <= payload.count else {
+                return
+            }
+            audioConfig = AudioSpecificConfig(bytes: [UInt8](payload[(index + 2)...]))
+            if canWrite {
+                writeProgram(nil)
+            }
+        case FLVAACPacketType.raw.rawValue:
+            guard let audioConfig, canWrite else {
+                return
+            }
+            var data = Data(audioConfig.makeHeader(payload.count - 2))
+            data.append(payload[(index + 2)...])
+            let timestamp = Self.makeTicks(timestamp)
+            if !hasVideo, programTimestamp.map({ $0 + Self.programInterval <= timestamp }) ?? true {
+                writeProgram(timestamp)
+            }
+            write(TSWriter.defaultAudioPID, streamID: 192, data: data, presentationTimeStamp: timestamp, decodeTimeStamp: nil, randomAccessIndicator: true)
+        default:
+            break
+        }
+    }
+
+    /// Appends the body of a video tag. The timestamp is absolute in milliseconds.
+    public func append(video payload: Data, timestamp: UInt32) {
+        let index = payload.startIndex
+        // The extended header of Enhanced RTMP isn't supported.
+        guard hasVideo, 5 < payload.count, payload[index] & 0x80 == 0, payload[index] & 0x0f == FLVVideoCodec.avc.rawValue else {
+            return
+        }
+        switch payload[index + 1] {
+        case FLVAVCPacketType.seq.rawValue:
+            let config = AVCDecoderConfigurationRecord(data: payload.subdata(in: index + 5..<payload.endIndex))
+            guard !config.sequenceParameterSets.isEmpty, !config.pictureParameterSets.isEmpty else {
+                return
+            }
+            videoConfig = config
+            if canWrite {
+                writeProgram(nil)
+            }
+        case FLVAVCPacketType.nal.rawValue:
+            guard let videoConfig, canWrite else {
+                return
+            }
+            let keyframe = payload[index] >> 4 == FLVFrameType.key.rawValue
+            // SI24 composition time offset in milliseconds.
+            var compositionTime = Int64(payload[index + 2]) << 16 | Int64(payload[index + 3]) << 8 | Int64(payload[index + 4])
+            if compositionTime & 0x80_0000 != 0 {
+                compositionTime -= 0x100_0000
+            }
+            let decodeTimeStamp = Self.makeTicks(timestamp)
+            let presentationTimeStamp = UInt64(max(0, Int64(decodeTimeStamp) + compositionTime * 90))
+            if keyframe {
+                writeProgram(decodeTimeStamp)
+            }
+            let data = Self.makeByteStream(payload[(index + 5)...], config: videoConfig, keyframe: keyframe)
+            write(TSWriter.defaultVideoPID, streamID: 224, data: data, presentationTimeStamp: presentationTimeStamp, decodeTimeStamp: decodeTimeStamp, randomAccessIndicator: keyframe)
+        default:
+            break
+        }
+    }
+
+    /// Clears the gateway for a new stream.
+    public func clear() {
+        audioConfig = nil
+        videoConfig = nil
+        audioTimestamp = 0
+        videoTimestamp = 0
+        pcrTimestamp = nil
+        programTimestamp = nil
+        continuityCounters.removeAll()
+        frameCount = 0
+    }
+
+    func append(_ message: RTMPAudioMessage, type: RTMPChunkType) {
+        audioTimestamp = type == .zero ? message.timestamp : audioTimestamp &+ message.timestamp
+        append(audio: message.payload, timestamp: audioTimestamp)
+    }
+
+    func append(_ message: RTMPVideoMessage, type: RTMPChunkType) {
+        videoTimestamp = type == .zero ? message.timestamp : videoTimestamp &+ message.timestamp
+        append(video: message.payload, timestamp: videoTimestamp)
+    }
+
+    // swiftlint:disable:next function_parameter_count
+    private func write(_ PID: UInt16, streamID: UInt8, data: Data, presentationTimeStamp: UInt64, decodeTimeStamp: UInt64?, randomAccessIndicator: Bool) {
+        let PES = PacketizedElementaryStream(data: data, streamID: streamID, presentationTimeStamp: presentationTimeStamp, decodeTimeStamp: decodeTimeStamp)
+        let timestamp = decodeTimeStamp ?? presentationTimeStamp
+        var PCR: UInt64?
+        if PID == PCRPID, pcrTimestamp.map({ $0 + Self.pcrInterval <= timestamp || timestamp < $0 }) ?? true {
+            PCR = (timestamp - Self.delay) & TSTimestamp.mask
+            pcrTimestamp = timestamp
+        }
+        var packets = PES.arrayOfPackets(PID, PCR: PCR)
+        packets[0].adaptationField?.randomAccessIndicator = randomAccessIndicator
+        var bytes = Data(capacity: packets.count * TSPacket.size)
+        for var packet in packets {
+            packet.continuityCounter = makeContinuityCounter(PID)
+            bytes.append(packet.data)
+        }
+        frameCount += 1
+        delegate?.gateway(self, didOutput: bytes)
+    }
+
+    private func writeProgram(_ timestamp: UInt64?) {
+        var bytes = Data(capacity: TSPacket.size * 2)
+        for var packet in PAT.arrayOfPackets(TSWriter.defaultPATPID) + PMT.arrayOfPackets(TSWriter.defaultPMTPID) {
+            packet.continuityCounter = makeContinuityCounter(packet.pid)
+            bytes.append(packet.data)
+        }
+        if let timestamp {
+            programTimestamp = timestamp
+        }
+        delegate?.gateway(self, didOutput: bytes)
+    }
+
+    private func makeContinuityCounter(_ PID: UInt16) -> UInt8 {
+        let continuityCounter = continuityCounters[PID] ?? 0
+        continuityCounters[PID] = (continuityCounter + 1) & 0x0f
+        return continuityCounter
+    }
+
+    /// Converts milliseconds to 90kHz ticks ahead of PCR by the delay.
+    static func makeTicks(_ timestamp: UInt32) -> UInt64 {
+        UInt64(timestamp) * 90 + delay
+    }
+
+    /// Converts an AVCC sample to an Annex-B access unit. A keyframe gets the parameter sets in front of it.
+    static func makeByteStream(_ data: Data, config: AVCDecoderConfigurationRecord, keyframe: Bool) -> Data {
+        let startCode: [UInt8] = [0x00, 0x00, 0x00, 0x01]
+        var result = Data(capacity: data.count + 64)
+        result.append(contentsOf: startCode)
+        result.append(contentsOf: [AVCNALUnitType.aud.rawValue, keyframe ? 0x10 : 0x30])
+        if keyframe {
+            for parameterSet in config.sequenceParameterSets + config.pictureParameterSets {
+                result.append(contentsOf: startCode)
+                result.append(contentsOf: parameterSet)
+            }
+        }
+        let lengthSize = Int(config.lengthSizeMinusOneWithReserved & 0x03) + 1
+        data.withUnsafeBytes { (pointer: UnsafeRawBufferPointer) in
+            var offset = 0
+            while offset + lengthSize <= pointer.count {
+                var length = 0
+                for i in 0..<lengthSize {
+                    length = length << 8 | Int(pointer[offset + i])
+                }
+                offset += lengthSize
+                guard 0 < length, offset + length <= pointer.count else {
+                    break
+                }
+                // Access unit delimiters are replaced by the one above.
+                if pointer[offset] & 0x1f != AVCNALUnitType.aud.rawValue {
+                    result.append(contentsOf: startCode)
+                    result.append(contentsOf: UnsafeRawBufferPointer(rebasing: pointer[offset..<offset + length]))
+                }
+                offset += length
+            }
+        }
+        return result
+    }
+}
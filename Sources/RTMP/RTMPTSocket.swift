@@ -11,6 +11,7 @@ final class RTMPTSocket: NSObject, RTMPSocketCompatible {
     var qualityOfService: DispatchQoS = .userInitiated
     var securityLevel: StreamSocketSecurityLevel = .none
     var outputBufferSize: Int = RTMPTSocket.defaultWindowSizeC
+    var capture: NetCapture?
     weak var delegate: (any RTMPSocketDelegate)?
     var connected = false {
         didSet {
@@ -165,6 +166,7 @@ final class RTMPTSocket: NSObject, RTMPSocketCompatible {
         totalBytesIn.mutate { $0 += Int64(buffer.count) }
         delay = buffer.remove(at: 0)
         inputBuffer.append(contentsOf: buffer)
+        capture?.append(Data(buffer), direction: .input)
 
         switch readyState {
         case .versionSent:
@@ -263,6 +265,7 @@ final class RTMPTSocket: NSObject, RTMPSocketCompatible {
         guard let connectionID: String = connectionID, connected else {
             return 0
         }
+        capture?.append(c2packet + data, direction: .output)
         doRequest("/send/\(connectionID)/\(index)", c2packet + data, listen)
         c2packet.removeAll()
         return data.count
@@ -0,0 +1,170 @@
+import AVFoundation
+import CoreMedia
+import Foundation
+
+/// The TSRTMPGateway class republishes an MPEG-2 transport stream, such as an SRT contribution, to an RTMPStream without decoding or encoding.
+///
+/// H.264 access units are converted from Annex-B to AVCC, and ADTS headers are stripped from AAC frames. The same samples can be teed to a TSWriter, e.g. for an HLS segmenter.
+/// - Note: The read(_:) method must be called from a single thread. Frames hop onto the executor of the stream, so publishing may start and stop at any time.
+public final class TSRTMPGateway {
+    /// The bucket bounds of the processing time histogram in microseconds.
+    public static let processingTimeBounds: [Double] = [10, 50, 100, 200, 500, 1000, 2000, 5000, 10000, 50000]
+
+    /// The stream to republish to. It must be publishing to forward frames.
+    public let stream: RTMPStream
+    /// Specifies the writer to tee frames to.
+    public var writer: TSWriter?
+    /// The histogram of the processing time per read in microseconds.
+    public var processingTime: Histogram {
+        _processingTime.value
+    }
+    /// The thread CPU time in seconds spent by reads.
+    public var cpuTime: Double {
+        _cpuTime.value
+    }
+    /// The number of republished audio and video frames.
+    public var frameCount: Int {
+        _frameCount.value
+    }
+
+    private var _processingTime: Atomic<Histogram> = .init(.init(bounds: TSRTMPGateway.processingTimeBounds))
+    private var _cpuTime: Atomic<Double> = .init(0)
+    private var _frameCount: Atomic<Int> = .init(0)
+    private var readFrameCount = 0
+    private let reader = TSReader()
+    private var audioFormat: AVAudioFormat?
+    private var videoFormat: CMFormatDescription?
+
+    /// Creates a new gateway.
+    public init(stream: RTMPStream) {
+        self.stream = stream
+        reader.delegate = self
+    }
+
+    /// Reads transport stream data and republishes the frames in it.
+    public func read(_ data: Data) {
+        let startedAt = DispatchTime.now().uptimeNanoseconds
+        let cpuTime = Self.threadCPUTime()
+        readFrameCount = 0
+        _ = reader.read(data)
+        let processingTime = Double(DispatchTime.now().uptimeNanoseconds - startedAt) / 1000
+        let frameCount = readFrameCount
+        _processingTime.mutate { $0.record(processingTime) }
+        _cpuTime.mutate { $0 += Self.threadCPUTime() - cpuTime }
+        _frameCount.mutate { $0 += frameCount }
+    }
+
+    /// Clears the gateway for a new transport stream.
+    public func clear() {
+        reader.clear()
+        audioFormat = nil
+        videoFormat = nil
+        _processingTime.mutate { $0.reset() }
+        _cpuTime.mutate { $0 = 0 }
+        _frameCount.mutate { $0 = 0 }
+    }
+
+    private func append(audio sampleBuffer: CMSampleBuffer) {
+        guard let audioFormat, let data = sampleBuffer.dataBuffer?.data else {
+            return
+        }
+        let muxer = stream.muxer
+        var offset = 0
+        for i in 0..<sampleBuffer.numSamples {
+            let size = CMSampleBufferGetSampleSize(sampleBuffer, at: i)
+            defer {
+                offset += size
+            }
+            guard ADTSHeader.size <= size, offset + size <= data.count else {
+                break
+            }
+            let header = ADTSHeader(data: data.subdata(in: offset..<offset + ADTSHeader.size))
+            let headerSize = header.protectionAbsent ? ADTSHeader.size : ADTSHeader.sizeWithCrc
+            var timing = CMSampleTimingInfo()
+            guard headerSize < size, CMSampleBufferGetSampleTimingInfo(sampleBuffer, at: i, timingInfoOut: &timing) == noErr else {
+                continue
+            }
+            let byteCount = size - headerSize
+            // Each frame owns its buffer because the muxer consumes it later on the executor.
+            let audioBuffer = AVAudioCompressedBuffer(format: audioFormat, packetCapacity: 1, maximumPacketSize: byteCount)
+            data.withUnsafeBytes { (buffer: UnsafeRawBufferPointer) in
+                guard let baseAddress = buffer.baseAddress else {
+                    return
+                }
+                audioBuffer.packetDescriptions?.pointee = AudioStreamPacketDescription(mStartOffset: 0, mVariableFramesInPacket: 0, mDataByteSize: UInt32(byteCount))
+                audioBuffer.packetCount = 1
+                audioBuffer.byteLength = UInt32(byteCount)
+                audioBuffer.data.copyMemory(from: baseAddress.advanced(by: offset + headerSize), byteCount: byteCount)
+            }
+            let when = AVAudioTime(hostTime: AVAudioTime.hostTime(forSeconds: timing.presentationTimeStamp.seconds))
+            stream.executor.execute {
+                // The muxer forgets formats whenever publishing restarts.
+                if muxer.audioFormat == nil {
+                    muxer.audioFormat = audioFormat
+                }
+                muxer.append(audioBuffer, when: when)
+            }
+            writer?.append(audioBuffer, when: when)
+            readFrameCount += 1
+        }
+    }
+
+    private func append(video sampleBuffer: CMSampleBuffer) {
+        let muxer = stream.muxer
+        let videoFormat = self.videoFormat
+        stream.executor.execute {
+            if muxer.videoFormat == nil {
+                muxer.videoFormat = videoFormat
+            }
+            muxer.append(sampleBuffer)
+        }
+        writer?.append(sampleBuffer)
+        readFrameCount += 1
+    }
+
+    private static func threadCPUTime() -> Double {
+        var time = timespec()
+        clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time)
+        return Double(time.tv_sec) + Double(time.tv_nsec) / 1_000_000_000
+    }
+}
+
+extension TSRTMPGateway: TSReaderDelegate {
+    // MARK: TSReaderDelegate
+    public func reader(_ reader: TSReader, id: UInt16, didRead formatDescription: CMFormatDescription) {
+        switch formatDescription.mediaType {
+        case .video:
+            videoFormat = formatDescription
+            if writer?.videoFormat == nil {
+                writer?.videoFormat = formatDescription
+            }
+        case .audio:
+            let audioFormat = AVAudioFormat(cmAudioFormatDescription: formatDescription)
+            self.audioFormat = audioFormat
+            if writer?.audioFormat == nil {
+                writer?.audioFormat = audioFormat
+            }
+        default:
+            break
+        }
+    }
+
+    public func reader(_ reader: TSReader, id: UInt16, didRead sampleBuffer: CMSampleBuffer) {
+        switch sampleBuffer.formatDescription?.mediaType {
+        case .video:
+            append(video: sampleBuffer)
+        case .audio:
+            append(audio: sampleBuffer)
+        default:
+            break
+        }
+    }
+
+    public func reader(_ reader: TSReader, id: UInt16, didRead metadata: TimedMetadata) {
+        let muxer = stream.muxer
+        stream.executor.queue.async {
+            muxer.append(metadata)
+        }
+        writer?.append(metadata)
+    }
+}
@@ -0,0 +1,133 @@
+import Foundation
+
+/// The BufferPool class recycles byte buffers of transient media payloads in power-of-two size classes.
+///
+/// A buffer is handed out wrapped in a Data, and returns to the pool when the last copy of the Data is released.
+/// The idle buffers are capped in bytes, and released when the system reports memory pressure.
+public final class BufferPool {
+    /// The metrics of a pool.
+    public struct Metrics {
+        /// The number of requests served from the pool.
+        public internal(set) var hitCount = 0
+        /// The number of requests that allocated a new buffer.
+        public internal(set) var missCount = 0
+        /// The bytes handed out and not returned yet.
+        public internal(set) var outstandingBytes = 0
+        /// The bytes kept in the pool for reuse.
+        public internal(set) var pooledBytes = 0
+
+        /// The ratio of requests served from the pool.
+        public var hitRate: Double {
+            let count = hitCount + missCount
+            return count == 0 ? 0 : Double(hitCount) / Double(count)
+        }
+    }
+
+    /// The shared pool.
+    public static let shared = BufferPool()
+    /// The smallest size class in bytes.
+    public static let minimumSize = 256
+    /// The largest size class in bytes. Larger buffers aren't pooled.
+    public static let maximumSize = 4 * 1024 * 1024
+
+    /// The default maximum bytes of idle buffers.
+    public static let defaultMaximumPooledBytes = 16 * 1024 * 1024
+
+    /// The maximum number of idle buffers kept per size class.
+    public let maximumBuffersPerClass: Int
+    /// The maximum bytes of idle buffers kept over all size classes.
+    public let maximumPooledBytes: Int
+
+    /// The current metrics.
+    public var metrics: Metrics {
+        lockQueue.sync { _metrics }
+    }
+
+    private var buffers: [[UnsafeMutableRawPointer]]
+    private var _metrics = Metrics()
+    private var memoryPressureSource: (any DispatchSourceMemoryPressure)?
+    private let lockQueue = DispatchQueue(label: "com.haishinkit.HaishinKit.BufferPool.lock")
+
+    /// Creates a new pool.
+    public init(maximumBuffersPerClass: Int = 32, maximumPooledBytes: Int = BufferPool.defaultMaximumPooledBytes) {
+        self.maximumBuffersPerClass = maximumBuffersPerClass
+        self.maximumPooledBytes = maximumPooledBytes
+        buffers = .init(repeating: [], count: Self.sizeClass(Self.maximumSize) + 1)
+        let memoryPressureSource = DispatchSource.makeMemoryPressureSource(eventMask: [.warning, .critical], queue: .global(qos: .utility))
+        memoryPressureSource.setEventHandler { [weak self] in
+            self?.removeAll()
+        }
+        memoryPressureSource.resume()
+        self.memoryPressureSource = memoryPressureSource
+    }
+
+    deinit {
+        memoryPressureSource?.cancel()
+        for pointer in buffers.joined() {
+            pointer.deallocate()
+        }
+    }
+
+    /// Makes a Data of the count, and fills it with the body.
+    public func makeData(count: Int, _ body: (UnsafeMutableRawBufferPointer) -> Void) -> Data {
+        guard 0 < count && count <= Self.maximumSize else {
+            var data = Data(count: count)
+            data.withUnsafeMutableBytes(body)
+            return data
+        }
+        let index = Self.sizeClass(count)
+        let capacity = Self.minimumSize << index
+        let pooled = lockQueue.sync { () -> UnsafeMutableRawPointer? in
+            _metrics.outstandingBytes += capacity
+            guard let pointer = buffers[index].popLast() else {
+                _metrics.missCount += 1
+                return nil
+            }
+            _metrics.hitCount += 1
+            _metrics.pooledBytes -= capacity
+            return pointer
+        }
+        let pointer = pooled ?? UnsafeMutableRawPointer.allocate(byteCount: capacity, alignment: MemoryLayout<UInt64>.alignment)
+        body(UnsafeMutableRawBufferPointer(start: pointer, count: count))
+        return Data(bytesNoCopy: pointer, count: count, deallocator: .custom { pointer, _ in
+            self.recycle(pointer, index: index)
+        })
+    }
+
+    /// Releases all idle buffers.
+    public func removeAll() {
+        let pointers = lockQueue.sync { () -> [UnsafeMutableRawPointer] in
+            let pointers = Array(buffers.joined())
+            buffers = .init(repeating: [], count: buffers.count)
+            _metrics.pooledBytes = 0
+            return pointers
+        }
+        for pointer in pointers {
+            pointer.deallocate()
+        }
+    }
+
+    private func recycle(_ pointer: UnsafeMutableRawPointer, index: Int) {
+        let capacity = Self.minimumSize << index
+        let isPooled = lockQueue.sync { () -> Bool in
+            _metrics.outstandingBytes -= capacity
+            guard buffers[index].count < maximumBuffersPerClass && _metrics.pooledBytes + capacity <= maximumPooledBytes else {
+                return false
+            }
+            buffers[index].append(pointer)
+            _metrics.pooledBytes += capacity
+            return true
+        }
+        if !isPooled {
+            pointer.deallocate()
+        }
+    }
+
+    static func sizeClass(_ count: Int) -> Int {
+        var index = 0
+        while minimumSize << index < count {
+            index += 1
+        }
+        return index
+    }
+}
@@ -0,0 +1,96 @@
+import Foundation
+
+/// The Histogram struct represents a distribution of values with fixed bucket bounds.
+public struct Histogram {
+    /// The default bucket bounds in milliseconds.
+    public static let defaultBounds: [Double] = [1, 2, 5, 10, 20, 50, 100, 200, 500, 1000, 2000, 5000, 10000]
+
+    /// The ascending upper bounds of buckets. The last bucket, which is not listed, is +Inf.
+    public let bounds: [Double]
+    /// The number of values in each bucket. The count is bounds.count + 1.
+    public private(set) var counts: [UInt64]
+    /// The number of recorded values.
+    public private(set) var count: UInt64 = 0
+    /// The sum of recorded values.
+    public private(set) var sum: Double = 0
+    /// The minimum recorded value.
+    public private(set) var min: Double = .infinity
+    /// The maximum recorded value.
+    public private(set) var max: Double = -.infinity
+
+    /// The arithmetic mean of recorded values.
+    public var mean: Double {
+        count == 0 ? 0 : sum / Double(count)
+    }
+
+    /// Creates a new histogram.
+    public init(bounds: [Double] = Histogram.defaultBounds) {
+        self.bounds = bounds.sorted()
+        self.counts = .init(repeating: 0, count: bounds.count + 1)
+    }
+
+    /// Records a value.
+    public mutating func record(_ value: Double) {
+        var lower = 0
+        var upper = bounds.count
+        while lower < upper {
+            let middle = (lower + upper) / 2
+            if value <= bounds[middle] {
+                upper = middle
+            } else {
+                lower = middle + 1
+            }
+        }
+        counts[lower] += 1
+        count += 1
+        sum += value
+        min = Swift.min(min, value)
+        max = Swift.max(max, value)
+    }
+
+    /// Returns the upper bound of the bucket which contains the specified percentile (0...1).
+    public func percentile(_ percentile: Double) -> Double {
+        guard 0 < count else {
+            return 0
+        }
+        let rank = UInt64((Double(count) * Swift.min(Swift.max(percentile, 0), 1)).rounded(.up))
+        var total: UInt64 = 0
+        for (i, value) in counts.enumerated() {
+            total += value
+            if Swift.max(rank, 1) <= total {
+                return i < bounds.count ? Swift.min(bounds[i], max) : max
+            }
+        }
+        return max
+    }
+
+    /// Adds the values of another histogram with the same bounds.
+    public mutating func merge(_ other: Histogram) {
+        guard bounds == other.bounds else {
+            return
+        }
+        for i in counts.indices {
+            counts[i] += other.counts[i]
+        }
+        count += other.count
+        sum += other.sum
+        min = Swift.min(min, other.min)
+        max = Swift.max(max, other.max)
+    }
+
+    /// Removes all recorded values.
+    public mutating func reset() {
+        counts = .init(repeating: 0, count: bounds.count + 1)
+        count = 0
+        sum = 0
+        min = .infinity
+        max = -.infinity
+    }
+}
+
+extension Histogram: CustomDebugStringConvertible {
+    // MARK: CustomDebugStringConvertible
+    public var debugDescription: String {
+        Mirror(reflecting: self).debugDescription
+    }
+}
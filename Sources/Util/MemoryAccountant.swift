@@ -0,0 +1,205 @@
+import Foundation
+
+/// The interface a component that buffers media implements to be accounted by a MemoryAccountant.
+public protocol MemoryAccountable: AnyObject {
+    /// The bytes currently buffered. It is read from the queue of an accountant, so it must be an atomic snapshot.
+    var bufferedBytes: Int { get }
+    /// Specifies whether to drop frames that no other frame depends on.
+    var dropsNonReferenceFrames: Bool { get set }
+    /// Disconnects the destination that the buffers feed, and returns false if the component can't disconnect.
+    @discardableResult
+    func disconnect() -> Bool
+}
+
+// MARK: -
+/// The MemoryAccountant class keeps a process-wide account of the bytes buffered by streams and connections, and sheds load above thresholds.
+///
+/// Components register under an owner, such as a stream or a connection, and the bytes are gauged per owner. Above the shedding threshold,
+/// the worst owners drop non-reference frames until they cover the excess. Above the disconnection threshold, the worst owners that can disconnect are disconnected.
+public final class MemoryAccountant {
+    /// The thresholds of shedding.
+    public struct Policy {
+        /// The total bytes above which non-reference frames are dropped.
+        public var sheddingThreshold: Int
+        /// The total bytes above which the worst owners are disconnected.
+        public var disconnectionThreshold: Int
+
+        /// Creates a new policy.
+        public init(sheddingThreshold: Int = 128 * 1024 * 1024, disconnectionThreshold: Int = 256 * 1024 * 1024) {
+            self.sheddingThreshold = sheddingThreshold
+            self.disconnectionThreshold = disconnectionThreshold
+        }
+    }
+
+    /// The actions taken by an evaluation.
+    public enum Action: Equatable {
+        /// The owner started to drop non-reference frames.
+        case dropNonReferenceFrames(owner: ObjectIdentifier)
+        /// The owner was disconnected.
+        case disconnect(owner: ObjectIdentifier)
+    }
+
+    /// The shared accountant.
+    public static let shared = MemoryAccountant()
+
+    /// Specifies the policy.
+    public var policy: Policy {
+        get {
+            lockQueue.sync { _policy }
+        }
+        set {
+            lockQueue.sync { _policy = newValue }
+        }
+    }
+    /// Specifies the interval in seconds between evaluations while running.
+    public var interval: Double = 1.0
+    /// The total bytes buffered by all registered components.
+    public var totalBytes: Int {
+        lockQueue.sync { Array(groups.values) }.reduce(0) { $0 + $1.bufferedBytes }
+    }
+    /// The number of owners with live components.
+    public var count: Int {
+        lockQueue.sync { groups.count }
+    }
+    /// The number of owners disconnected by the policy.
+    public var disconnectionCount: Int {
+        lockQueue.sync { _disconnectionCount }
+    }
+    /// The running indicies whether evaluating periodically or not.
+    public private(set) var isRunning: Atomic<Bool> = .init(false)
+
+    private var _policy = Policy()
+    private var _disconnectionCount = 0
+    private var groups: [ObjectIdentifier: Group] = [:]
+    private var timer: DispatchSourceTimer?
+    private let lockQueue = DispatchQueue(label: "com.haishinkit.HaishinKit.MemoryAccountant.lock")
+    private let timerQueue = DispatchQueue(label: "com.haishinkit.HaishinKit.MemoryAccountant.timer", qos: .utility)
+
+    /// Creates a new accountant.
+    public init() {
+    }
+
+    /// Registers a component under an owner.
+    public func register(_ component: some MemoryAccountable, owner: AnyObject) {
+        let id = ObjectIdentifier(owner)
+        lockQueue.sync {
+            // Prunes released owners here too, as evaluate() only runs while an app has started the accountant.
+            groups = groups.filter { $0.value.owner != nil }
+            // An identifier of a released owner may be reused.
+            if groups[id]?.owner !== owner {
+                groups[id] = Group(owner: owner)
+            }
+            groups[id]?.components.append(WeakReference(component))
+        }
+    }
+
+    /// Unregisters a component.
+    public func unregister(_ component: some MemoryAccountable) {
+        lockQueue.sync {
+            for id in groups.keys {
+                groups[id]?.components.removeAll { $0.value == nil || $0.value === component }
+                if groups[id]?.components.isEmpty == true {
+                    groups[id] = nil
+                }
+            }
+        }
+    }
+
+    /// Gauges the bytes buffered by the components of an owner.
+    public func bufferedBytes(of owner: AnyObject) -> Int {
+        lockQueue.sync { groups[ObjectIdentifier(owner)] }?.bufferedBytes ?? 0
+    }
+
+    /// Applies the policy once, and returns the actions taken.
+    @discardableResult
+    public func evaluate() -> [Action] {
+        let (groups, policy) = lockQueue.sync { () -> ([ObjectIdentifier: Group], Policy) in
+            self.groups = self.groups.filter { $0.value.owner != nil }
+            return (self.groups, _policy)
+        }
+        // The worst owners come first.
+        let usages = groups.map { ($0.key, $0.value, $0.value.bufferedBytes) }.sorted { $1.2 < $0.2 }
+        let total = usages.reduce(0) { $0 + $1.2 }
+        var actions: [Action] = []
+        var excess = total - policy.sheddingThreshold
+        for (id, group, bytes) in usages {
+            let isShedding = 0 < excess
+            // Components are only told of transitions, as a connection forwards the setting to streams that are owners by themselves.
+            if group.isShedding != isShedding {
+                for component in group.components.compactMap({ $0.value }) {
+                    component.dropsNonReferenceFrames = isShedding
+                }
+                lockQueue.sync {
+                    self.groups[id]?.isShedding = isShedding
+                }
+            }
+            if isShedding {
+                actions.append(.dropNonReferenceFrames(owner: id))
+                excess -= bytes
+            }
+        }
+        var remaining = total
+        for (id, group, bytes) in usages where policy.disconnectionThreshold < remaining {
+            // Every component is told, and an owner none of which can disconnect is left to the next worst ones.
+            let results = group.components.compactMap { $0.value }.map { $0.disconnect() }
+            guard results.contains(true) else {
+                continue
+            }
+            logger.warn("disconnects an owner buffering", bytes, "bytes of", total)
+            actions.append(.disconnect(owner: id))
+            remaining -= bytes
+            lockQueue.sync {
+                _disconnectionCount += 1
+            }
+        }
+        return actions
+    }
+
+    private struct Group {
+        weak var owner: AnyObject?
+        var components: [WeakReference] = []
+        var isShedding = false
+
+        var bufferedBytes: Int {
+            components.reduce(0) { $0 + ($1.value?.bufferedBytes ?? 0) }
+        }
+    }
+
+    private final class WeakReference {
+        weak var value: (any MemoryAccountable)?
+
+        init(_ value: any MemoryAccountable) {
+            self.value = value
+        }
+    }
+}
+
+extension MemoryAccountant: Running {
+    // MARK: Running
+    public func startRunning() {
+        lockQueue.async {
+            guard !self.isRunning.value else {
+                return
+            }
+            let timer = DispatchSource.makeTimerSource(queue: self.timerQueue)
+            timer.schedule(deadline: .now() + self.interval, repeating: self.interval)
+            timer.setEventHandler { [weak self] in
+                self?.evaluate()
+            }
+            self.timer = timer
+            timer.resume()
+            self.isRunning.mutate { $0 = true }
+        }
+    }
+
+    public func stopRunning() {
+        lockQueue.async {
+            guard self.isRunning.value else {
+                return
+            }
+            self.timer?.cancel()
+            self.timer = nil
+            self.isRunning.mutate { $0 = false }
+        }
+    }
+}
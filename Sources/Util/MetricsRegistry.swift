@@ -0,0 +1,264 @@
+import Foundation
+
+/// The interface a component implements to report metrics into a MetricsRegistry.
+public protocol MetricsCollectable: AnyObject {
+    /// Reports the current values of the component.
+    func collect(_ collector: MetricsCollector)
+}
+
+// MARK: -
+/// The MetricsRegistry class keeps a process-wide list of components that report metrics, and renders them in the Prometheus text exposition format.
+///
+/// Components keep their own counters on their own queues, and are only sampled when the metrics are collected. So reporting adds nothing
+/// to the media path. Streams and connections register themselves to the shared registry on creation.
+/// A component must read only atomics or snapshots in collect(_:), as it is called on the thread of the scraper. The lock of the registry
+/// guards only the list of components and is never taken on the media path.
+public final class MetricsRegistry {
+    /// The cardinality controls of a collection.
+    public struct Policy {
+        /// The maximum number of series per metric. The series beyond it are dropped.
+        public var maximumSeriesCount: Int
+        /// The labels to remove from series, e.g. "stream" for hundreds of streams. The series that become the same are added up.
+        public var droppedLabels: Set<String>
+
+        /// Creates a new policy.
+        public init(maximumSeriesCount: Int = 1000, droppedLabels: Set<String> = []) {
+            self.maximumSeriesCount = maximumSeriesCount
+            self.droppedLabels = droppedLabels
+        }
+    }
+
+    /// The shared registry.
+    public static let shared = MetricsRegistry()
+
+    /// Specifies the policy.
+    public var policy: Policy {
+        get {
+            lockQueue.sync { _policy }
+        }
+        set {
+            lockQueue.sync { _policy = newValue }
+        }
+    }
+    /// The number of registered components.
+    public var count: Int {
+        lockQueue.sync { components.filter { $0.value != nil }.count }
+    }
+
+    private var _policy = Policy()
+    private var components: [WeakReference] = []
+    private let lockQueue = DispatchQueue(label: "com.haishinkit.HaishinKit.MetricsRegistry.lock")
+
+    /// Creates a new registry.
+    public init() {
+    }
+
+    /// Registers a component.
+    public func register(_ component: some MetricsCollectable) {
+        lockQueue.sync {
+            components.removeAll { $0.value == nil || $0.value === component }
+            components.append(WeakReference(component))
+        }
+    }
+
+    /// Unregisters a component.
+    public func unregister(_ component: some MetricsCollectable) {
+        lockQueue.sync {
+            components.removeAll { $0.value == nil || $0.value === component }
+        }
+    }
+
+    /// Collects the metrics of the registered components.
+    public func collect() -> MetricsCollector {
+        let (components, policy) = lockQueue.sync { () -> ([any MetricsCollectable], Policy) in
+            self.components.removeAll { $0.value == nil }
+            return (self.components.compactMap { $0.value }, _policy)
+        }
+        let collector = MetricsCollector(policy: policy)
+        for component in components {
+            component.collect(collector)
+        }
+        collector.gauge(
+            "haishinkit_metrics_dropped_series",
+            help: "The number of series dropped by the cardinality limit in the last collection.",
+            value: Double(collector.droppedSeriesCount)
+        )
+        return collector
+    }
+
+    /// Collects the metrics in the text exposition format.
+    public func exposition() -> String {
+        collect().exposition
+    }
+
+    private final class WeakReference {
+        weak var value: (any MetricsCollectable)?
+
+        init(_ value: any MetricsCollectable) {
+            self.value = value
+        }
+    }
+}
+
+// MARK: -
+/// The MetricsCollector class gathers the samples of one collection.
+public final class MetricsCollector {
+    /// The type of a metric.
+    public enum MetricType: String {
+        /// A value that only goes up.
+        case counter
+        /// A value that goes up and down.
+        case gauge
+        /// A distribution of values in buckets.
+        case histogram
+    }
+
+    /// The content type of the text exposition format.
+    public static let contentType = "text/plain; version=0.0.4; charset=utf-8"
+
+    /// The policy of the collection.
+    public let policy: MetricsRegistry.Policy
+    /// The number of series dropped by the cardinality limit.
+    public private(set) var droppedSeriesCount = 0
+    /// The names of the collected metrics in order.
+    public var names: [String] {
+        families.map { $0.name }
+    }
+
+    private var families: [Family] = []
+    private var indices: [String: Int] = [:]
+
+    /// Creates a new collector.
+    public init(policy: MetricsRegistry.Policy = .init()) {
+        self.policy = policy
+    }
+
+    /// Reports a counter.
+    public func counter(_ name: String, help: String, value: Double, labels: [String: String] = [:]) {
+        append(name, help: help, type: .counter, labels: labels, value: .scalar(value))
+    }
+
+    /// Reports a gauge.
+    public func gauge(_ name: String, help: String, value: Double, labels: [String: String] = [:]) {
+        append(name, help: help, type: .gauge, labels: labels, value: .scalar(value))
+    }
+
+    /// Reports a histogram, where the bounds and the values are multiplied by the scale, e.g. 0.001 for milliseconds to seconds.
+    public func histogram(_ name: String, help: String, histogram: Histogram, scale: Double = 1, labels: [String: String] = [:]) {
+        append(name, help: help, type: .histogram, labels: labels, value: .histogram(histogram, scale: scale))
+    }
+
+    /// The value of a counter or a gauge series, if any.
+    public func value(_ name: String, labels: [String: String] = [:]) -> Double? {
+        guard let index = indices[name], case .scalar(let value) = families[index].series[makeKey(labels)] else {
+            return nil
+        }
+        return value
+    }
+
+    /// The samples in the text exposition format.
+    public var exposition: String {
+        var text = ""
+        for family in families {
+            text += "# HELP \(family.name) \(Self.escape(family.help, quotes: false))\n"
+            text += "# TYPE \(family.name) \(family.type.rawValue)\n"
+            for key in family.keys {
+                switch family.series[key] {
+                case .scalar(let value):
+                    text += "\(family.name)\(Self.braced(key)) \(Self.format(value))\n"
+                case .histogram(let histogram, let scale):
+                    let separator = key.isEmpty ? "" : ","
+                    var cumulative: UInt64 = 0
+                    for (i, bound) in histogram.bounds.enumerated() {
+                        cumulative += histogram.counts[i]
+                        text += "\(family.name)_bucket{\(key)\(separator)le=\"\(Self.format(bound * scale))\"} \(cumulative)\n"
+                    }
+                    text += "\(family.name)_bucket{\(key)\(separator)le=\"+Inf\"} \(histogram.count)\n"
+                    text += "\(family.name)_sum\(Self.braced(key)) \(Self.format(histogram.sum * scale))\n"
+                    text += "\(family.name)_count\(Self.braced(key)) \(histogram.count)\n"
+                case .none:
+                    break
+                }
+            }
+        }
+        return text
+    }
+
+    private func append(_ name: String, help: String, type: MetricType, labels: [String: String], value: Value) {
+        let key = makeKey(labels)
+        let index: Int
+        if let existing = indices[name] {
+            index = existing
+        } else {
+            index = families.count
+            indices[name] = index
+            families.append(Family(name: name, help: help, type: type))
+        }
+        guard families[index].type == type else {
+            logger.warn("reports", name, "as", type, "besides", families[index].type)
+            return
+        }
+        switch (families[index].series[key], value) {
+        case (.none, _):
+            guard families[index].keys.count < policy.maximumSeriesCount else {
+                droppedSeriesCount += 1
+                return
+            }
+            families[index].keys.append(key)
+            families[index].series[key] = value
+        case (.scalar(let lhs), .scalar(let rhs)):
+            families[index].series[key] = .scalar(lhs + rhs)
+        case (.histogram(var lhs, let scale), .histogram(let rhs, _)):
+            lhs.merge(rhs)
+            families[index].series[key] = .histogram(lhs, scale: scale)
+        default:
+            break
+        }
+    }
+
+    private func makeKey(_ labels: [String: String]) -> String {
+        labels
+            .filter { !policy.droppedLabels.contains($0.key) }
+            .sorted { $0.key < $1.key }
+            .map { "\($0.key)=\"\(Self.escape($0.value, quotes: true))\"" }
+            .joined(separator: ",")
+    }
+
+    private static func braced(_ key: String) -> String {
+        key.isEmpty ? "" : "{\(key)}"
+    }
+
+    private static func escape(_ value: String, quotes: Bool) -> String {
+        var escaped = value.replacingOccurrences(of: "\\", with: "\\\\").replacingOccurrences(of: "\n", with: "\\n")
+        if quotes {
+            escaped = escaped.replacingOccurrences(of: "\"", with: "\\\"")
+        }
+        return escaped
+    }
+
+    private static func format(_ value: Double) -> String {
+        if value.isNaN {
+            return "NaN"
+        }
+        if value.isInfinite {
+            return value < 0 ? "-Inf" : "+Inf"
+        }
+        if value == value.rounded() && abs(value) < 1e15 {
+            return String(Int64(value))
+        }
+        return String(value)
+    }
+
+    private enum Value {
+        case scalar(Double)
+        case histogram(Histogram, scale: Double)
+    }
+
+    private struct Family {
+        let name: String
+        let help: String
+        let type: MetricType
+        var keys: [String] = []
+        var series: [String: Value] = [:]
+    }
+}
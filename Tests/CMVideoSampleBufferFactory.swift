@@ -0,0 +1,71 @@
+import AVFoundation
+
+@testable import HaishinKit
+
+/// Makes synthetic H.264 frames as an encoder would output them, so that the post-encode path runs without VideoToolbox.
+enum CMVideoSampleBufferFactory {
+    /// The Baseline profile 640x480.
+    static let sequenceParameterSet: [UInt8] = [0x67, 0x42, 0x00, 0x1e, 0x95, 0xa8, 0x28, 0x0f, 0x64]
+    static let pictureParameterSet: [UInt8] = [0x68, 0xce, 0x3c, 0x80]
+
+    static func makeFormatDescription() -> CMFormatDescription? {
+        var formatDescription: CMFormatDescription?
+        let status = sequenceParameterSet.withUnsafeBufferPointer { sps in
+            pictureParameterSet.withUnsafeBufferPointer { pps in
+                let pointers = [sps.baseAddress!, pps.baseAddress!]
+                let sizes = [sps.count, pps.count]
+                return CMVideoFormatDescriptionCreateFromH264ParameterSets(
+                    allocator: kCFAllocatorDefault,
+                    parameterSetCount: pointers.count,
+                    parameterSetPointers: pointers,
+                    parameterSetSizes: sizes,
+                    nalUnitHeaderLength: 4,
+                    formatDescriptionOut: &formatDescription
+                )
+            }
+        }
+        return status == noErr ? formatDescription : nil
+    }
+
+    /// Makes an AVCC frame of a single slice NAL unit of the size.
+    static func makeEncodedFrame(_ formatDescription: CMFormatDescription?, size: Int = 4096, frameNumber: Int = 0, frameRate: Int32 = 30, keyframeInterval: Int = 30) -> CMSampleBuffer? {
+        let keyframe = frameNumber % keyframeInterval == 0
+        var bytes = [UInt8](repeating: 0xa5, count: size)
+        let length = UInt32(size - 4).bigEndian
+        withUnsafeBytes(of: length) { bytes.replaceSubrange(0..<4, with: $0) }
+        bytes[4] = keyframe ? 0x65 : 0x41
+        var blockBuffer: CMBlockBuffer?
+        guard CMBlockBufferCreateWithMemoryBlock(
+            allocator: kCFAllocatorDefault,
+            memoryBlock: nil,
+            blockLength: size,
+            blockAllocator: kCFAllocatorDefault,
+            customBlockSource: nil,
+            offsetToData: 0,
+            dataLength: size,
+            flags: 0,
+            blockBufferOut: &blockBuffer
+        ) == noErr, let blockBuffer, CMBlockBufferReplaceDataBytes(with: bytes, blockBuffer: blockBuffer, offsetIntoDestination: 0, dataLength: size) == noErr else {
+            return nil
+        }
+        let presentationTimeStamp = CMTime(value: CMTimeValue(frameNumber), timescale: frameRate)
+        var timing = CMSampleTimingInfo(duration: CMTime(value: 1, timescale: frameRate), presentationTimeStamp: presentationTimeStamp, decodeTimeStamp: presentationTimeStamp)
+        var sampleSize = size
+        var sampleBuffer: CMSampleBuffer?
+        guard CMSampleBufferCreateReady(
+            allocator: kCFAllocatorDefault,
+            dataBuffer: blockBuffer,
+            formatDescription: formatDescription,
+            sampleCount: 1,
+            sampleTimingEntryCount: 1,
+            sampleTimingArray: &timing,
+            sampleSizeEntryCount: 1,
+            sampleSizeArray: &sampleSize,
+            sampleBufferOut: &sampleBuffer
+        ) == noErr, let sampleBuffer else {
+            return nil
+        }
+        sampleBuffer.isNotSync = !keyframe
+        return sampleBuffer
+    }
+}
@@ -5,6 +5,20 @@ import AVFoundation
 @testable import HaishinKit
 
 final class AudioCodecTests: XCTestCase {
+    func testReleasedBufferOfEarlierFormatIsDropped() {
+        let encoder = HaishinKit.AudioCodec<AudioCodecTests>(lockQueue: DispatchQueue(label: "AudioCodecTests"))
+        encoder.inputFormat = AVAudioFormat(commonFormat: .pcmFormatInt16, sampleRate: 44100, channels: 2, interleaved: true)
+        let buffer = encoder.outputBuffer
+        encoder.inputFormat = AVAudioFormat(commonFormat: .pcmFormatInt16, sampleRate: 48000, channels: 1, interleaved: true)
+        encoder.releaseOutputBuffer(buffer)
+        for _ in 0..<encoder.settings.format.outputBufferCounts + 1 {
+            let next = encoder.outputBuffer
+            XCTAssertFalse(next === buffer)
+            XCTAssertEqual(next.format, encoder.outputFormat)
+            encoder.releaseOutputBuffer(next)
+        }
+    }
+
     func testEncoderCMSampleBuffer44100_1024() {
         let encoder = HaishinKit.AudioCodec<AudioCodecTests>(lockQueue: DispatchQueue(label: "AudioCodecTests"))
         encoder.startRunning()
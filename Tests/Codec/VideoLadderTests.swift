@@ -0,0 +1,197 @@
+import Foundation
+import XCTest
+import AVFoundation
+
+@testable import HaishinKit
+
+final class VideoLadderTests: XCTestCase {
+    private let renditions: [VideoCodecSettings] = [
+        .init(videoSize: .init(width: 854, height: 480)),
+        .init(videoSize: .init(width: 1920, height: 1080)),
+        .init(videoSize: .init(width: 1280, height: 720))
+    ]
+
+    func testScalesDownPyramid() {
+        let scaler = FakeScaler()
+        let (ladder, queues) = makeLadder(scaler)
+        ladder.startRunning()
+        ladder.append(makePixelBuffer(1920, 1080), presentationTimeStamp: .zero, duration: .invalid)
+        drain(queues)
+        XCTAssertEqual(scaler.scales, [
+            .init(from: .init(width: 1920, height: 1080), to: .init(width: 1280, height: 720)),
+            .init(from: .init(width: 1280, height: 720), to: .init(width: 854, height: 480))
+        ])
+        // The capture thread only decides keyframes.
+        XCTAssertFalse(scaler.scalesOnCallerThread)
+    }
+
+    func testAlignsKeyFrames() {
+        let (ladder, queues) = makeLadder(FakeScaler())
+        ladder.startRunning()
+        let source = makePixelBuffer(1920, 1080)
+        for frameNumber in 0..<150 {
+            ladder.append(source, presentationTimeStamp: CMTime(value: CMTimeValue(frameNumber), timescale: 30), duration: .invalid)
+        }
+        drain(queues)
+        for metrics in ladder.metrics {
+            XCTAssertEqual(metrics.frameCount, 150)
+            XCTAssertEqual(metrics.keyFrameCount, 3)
+            XCTAssertEqual(metrics.misalignedFrameCount, 0)
+            XCTAssertEqual(metrics.latency.count, 150)
+        }
+    }
+
+    func testCountsMisalignedKeyFrames() {
+        let encoders = renditions.map { _ in FakeEncoder() }
+        encoders[0].extraKeyFrameNumber = 45
+        let (ladder, queues) = makeLadder(FakeScaler(), encoders: encoders)
+        ladder.startRunning()
+        let source = makePixelBuffer(1920, 1080)
+        for frameNumber in 0..<90 {
+            ladder.append(source, presentationTimeStamp: CMTime(value: CMTimeValue(frameNumber), timescale: 30), duration: .invalid)
+        }
+        drain(queues)
+        XCTAssertEqual(ladder.metrics[0].misalignedFrameCount, 1)
+        XCTAssertEqual(ladder.metrics[1].misalignedFrameCount, 0)
+        XCTAssertEqual(ladder.metrics[2].misalignedFrameCount, 0)
+    }
+
+    func testCountsFramesDroppedByEncoder() {
+        let encoders = renditions.map { _ in FakeEncoder() }
+        encoders[1].droppedFrameNumbers = [10, 11, 140]
+        let (ladder, queues) = makeLadder(FakeScaler(), encoders: encoders)
+        ladder.startRunning()
+        let source = makePixelBuffer(1920, 1080)
+        for frameNumber in 0..<150 {
+            ladder.append(source, presentationTimeStamp: CMTime(value: CMTimeValue(frameNumber), timescale: 30), duration: .invalid)
+        }
+        drain(queues)
+        // The frame 140 is still within the keyframe interval.
+        XCTAssertEqual(ladder.metrics.map { $0.droppedFrameCount }, [0, 2, 0])
+        XCTAssertEqual(ladder.metrics[1].frameCount, 147)
+    }
+
+    func testVideoCodecNeverDropsForcedKeyFrames() {
+        let queues = renditions.indices.map { DispatchQueue(label: "VideoLadderTests.\($0)") }
+        let encoders = zip(renditions, queues).map { settings, queue in
+            let codec = VideoCodec<IOMixer>(lockQueue: queue)
+            codec.settings = settings
+            // Drops every frame after the first output unless it forces a keyframe.
+            codec.frameInterval = 60
+            return codec
+        }
+        let ladder = VideoLadder(renditions: renditions, keyFrameInterval: 2, encoders: encoders, scaler: VideoLadderImageScaler(), queues: queues)
+        let delegate = KeyFrameDelegate(renditionCount: renditions.count, keyFrameCount: 3)
+        ladder.delegate = delegate
+        ladder.startRunning()
+        let source = makePixelBuffer(1920, 1080)
+        for frameNumber in 0..<150 {
+            ladder.append(source, presentationTimeStamp: CMTime(value: CMTimeValue(frameNumber), timescale: 30), duration: CMTime(value: 1, timescale: 30))
+        }
+        wait(for: [delegate.expectation], timeout: 10)
+        ladder.stopRunning()
+        XCTAssertEqual(delegate.keyFrameTimestamps, .init(repeating: [0, 2, 4], count: renditions.count))
+        for metrics in ladder.metrics {
+            XCTAssertEqual(metrics.misalignedFrameCount, 0)
+        }
+    }
+
+    func testDropsFramesWhileStopped() {
+        let (ladder, queues) = makeLadder(FakeScaler())
+        ladder.append(makePixelBuffer(1920, 1080), presentationTimeStamp: .zero, duration: .invalid)
+        drain(queues)
+        XCTAssertEqual(ladder.metrics.map { $0.frameCount }, [0, 0, 0])
+    }
+
+    private func makeLadder(_ scaler: FakeScaler, encoders: [FakeEncoder]? = nil) -> (VideoLadder, [DispatchQueue]) {
+        let queues = renditions.indices.map { DispatchQueue(label: "VideoLadderTests.\($0)") }
+        let ladder = VideoLadder(
+            renditions: renditions,
+            keyFrameInterval: 2,
+            encoders: encoders ?? renditions.map { _ in FakeEncoder() },
+            scaler: scaler,
+            queues: queues
+        )
+        return (ladder, queues)
+    }
+
+    /// Waits for the queues from the largest rendition to the smallest, as each one passes frames down to the next.
+    private func drain(_ queues: [DispatchQueue]) {
+        for index in [1, 2, 0] {
+            queues[index].sync {}
+        }
+    }
+
+    private func makePixelBuffer(_ width: Int, _ height: Int) -> CVPixelBuffer {
+        var pixelBuffer: CVPixelBuffer?
+        CVPixelBufferCreate(kCFAllocatorDefault, width, height, kCVPixelFormatType_32BGRA, nil, &pixelBuffer)
+        return pixelBuffer!
+    }
+}
+
+private final class FakeEncoder: VideoLadderEncoder {
+    private let formatDescription = CMVideoSampleBufferFactory.makeFormatDescription()
+    var extraKeyFrameNumber: Int?
+    var droppedFrameNumbers: Set<Int> = []
+
+    func encode(_ imageBuffer: CVImageBuffer, presentationTimeStamp: CMTime, duration: CMTime, forcesKeyFrame: Bool, handler: @escaping (CMSampleBuffer) -> Void) {
+        let frameNumber = Int(presentationTimeStamp.value)
+        guard !droppedFrameNumbers.contains(frameNumber), let sampleBuffer = CMVideoSampleBufferFactory.makeEncodedFrame(formatDescription, size: 256, frameNumber: frameNumber) else {
+            return
+        }
+        sampleBuffer.isNotSync = !(forcesKeyFrame || frameNumber == extraKeyFrameNumber)
+        handler(sampleBuffer)
+    }
+}
+
+private final class FakeScaler: VideoLadderScaler {
+    struct Scale: Equatable {
+        let from: CGSize
+        let to: CGSize
+    }
+
+    var scales: [Scale] {
+        _scales.value
+    }
+    var scalesOnCallerThread: Bool {
+        _scalesOnCallerThread.value
+    }
+
+    private var _scales: Atomic<[Scale]> = .init([])
+    private var _scalesOnCallerThread: Atomic<Bool> = .init(false)
+
+    func scale(_ imageBuffer: CVImageBuffer, to size: CGSize) -> CVImageBuffer? {
+        let scale = Scale(from: .init(width: CVPixelBufferGetWidth(imageBuffer), height: CVPixelBufferGetHeight(imageBuffer)), to: size)
+        _scales.mutate { $0.append(scale) }
+        if Thread.isMainThread {
+            _scalesOnCallerThread.mutate { $0 = true }
+        }
+        var pixelBuffer: CVPixelBuffer?
+        CVPixelBufferCreate(kCFAllocatorDefault, Int(size.width), Int(size.height), kCVPixelFormatType_32BGRA, nil, &pixelBuffer)
+        return pixelBuffer
+    }
+}
+
+private final class KeyFrameDelegate: VideoLadderDelegate {
+    let expectation = XCTestExpectation()
+
+    var keyFrameTimestamps: [[Double]] {
+        _keyFrameTimestamps.value
+    }
+
+    private var _keyFrameTimestamps: Atomic<[[Double]]>
+
+    init(renditionCount: Int, keyFrameCount: Int) {
+        _keyFrameTimestamps = .init(.init(repeating: [], count: renditionCount))
+        expectation.expectedFulfillmentCount = renditionCount * keyFrameCount
+        expectation.assertForOverFulfill = false
+    }
+
+    func ladder(_ ladder: VideoLadder, rendition: Int, didOutput sampleBuffer: CMSampleBuffer) {
+        guard !sampleBuffer.isNotSync else {
+            return
+        }
+        _keyFrameTimestamps.mutate { $0[rendition].append(sampleBuffer.presentationTimeStamp.seconds) }
+        expectation.fulfill()
+    }
+}
@@ -0,0 +1,39 @@
+import CoreMedia
+import Foundation
+import XCTest
+
+@testable import HaishinKit
+
+final class LatencyProbeTests: XCTestCase {
+    func testReadNALUnit() {
+        let probe = LatencyProbe()
+        let unit = probe.makeNALUnit(.invalid, isHEVC: false)
+        XCTAssertEqual(unit.first, 0x06)
+        XCTAssertEqual(unit.last, 0x80)
+        var frame = Data([0x00, 0x00, 0x00, 0x01])
+        frame.append(unit)
+        frame.append(contentsOf: [0x00, 0x00, 0x00, 0x01, 0x65, 0x88, 0x84])
+        let captureTime = probe.read(frame)
+        XCTAssertNotNil(captureTime)
+        let now = UInt64(Date().timeIntervalSince1970 * 1_000_000_000)
+        XCTAssertLessThanOrEqual(captureTime ?? 0, now)
+        XCTAssertLessThan(now - (captureTime ?? 0), 1_000_000_000)
+    }
+
+    func testReadEscapedNALUnit() {
+        let probe = LatencyProbe(uuid: UUID(uuidString: "00000000-0000-0001-0000-000000000000")!)
+        let unit = probe.makeLengthPrefixedNALUnit(.invalid, isHEVC: true)
+        XCTAssertEqual(unit[4], 39 << 1)
+        XCTAssertNil(unit[4...].range(of: Data([0x00, 0x00, 0x00])))
+        XCTAssertNil(unit[4...].range(of: Data([0x00, 0x00, 0x01])))
+        XCTAssertNotNil(probe.probe(unit))
+        XCTAssertEqual(probe.histogram.count, 1)
+    }
+
+    func testMissingNALUnit() {
+        let probe = LatencyProbe()
+        XCTAssertNil(probe.probe(Data([0x00, 0x00, 0x00, 0x01, 0x65, 0x88, 0x84])))
+        XCTAssertNil(LatencyProbe(uuid: UUID()).probe(probe.makeNALUnit(.invalid, isHEVC: false)))
+        XCTAssertEqual(probe.histogram.count, 0)
+    }
+}
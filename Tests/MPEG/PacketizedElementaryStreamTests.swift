@@ -12,7 +12,33 @@ final class PacketizedElementaryStreamTests: XCTestCase {
         let pes = PacketizedElementaryStream(PacketizedElementaryStreamTests.dataWithVideo)!
         let header = pes.optionalPESHeader
         let timingInfo = header?.makeSampleTimingInfo(.invalid)
-        XCTAssertEqual(timingInfo?.presentationTimeStamp, CMTime(value: 126384, timescale: CMTimeScale(TSTimestamp.resolution)))
+        XCTAssertEqual(timingInfo?.presentationTimeStamp, CMTime(value: 126000, timescale: CMTimeScale(TSTimestamp.resolution)))
         XCTAssertEqual(pes.payload, PacketizedElementaryStreamTests.dataWithVideo)
     }
+
+    func testAudioDataWithMultipleFrames() {
+        // AAC-LC, 48kHz, 2ch, 16 bytes per ADTS frame.
+        let frame: [UInt8] = [0xFF, 0xF1, 0x4C, 0x80, 0x02, 0x1F, 0xFC] + [UInt8](repeating: 0x21, count: 9)
+        var data = Data([0, 0, 1, 192, 0, 0, 128, 128, 5, 33, 0, 7, 216, 97])
+        for _ in 0..<3 {
+            data.append(contentsOf: frame)
+        }
+        var pes = PacketizedElementaryStream(data)!
+        let formatDescription = ADTSHeader(data: Data(frame)).makeFormatDescription()
+        let sampleBuffer = pes.makeSampleBuffer(.adtsAac, previousPresentationTimeStamp: .invalid, formatDescription: formatDescription)
+        XCTAssertEqual(sampleBuffer?.numSamples, 3)
+        XCTAssertEqual(sampleBuffer.map { CMSampleBufferGetSampleSize($0, at: 2) }, 16)
+        var timingInfo = CMSampleTimingInfo()
+        XCTAssertEqual(sampleBuffer.map { CMSampleBufferGetSampleTimingInfo($0, at: 2, timingInfoOut: &timingInfo) }, noErr)
+        XCTAssertEqual(timingInfo.presentationTimeStamp.seconds, 126000.0 / 90000.0 + 2048.0 / 48000.0, accuracy: 0.0001)
+        XCTAssertEqual(timingInfo.duration, CMTime(value: 1024, timescale: 48000))
+    }
+
+    func testVideoDataWithNALUnit() {
+        let frame: [UInt8] = [0x00, 0x00, 0x00, 0x02, 0x65, 0x88]
+        let pes = frame.withUnsafeBufferPointer {
+            PacketizedElementaryStream(bytes: $0.baseAddress, count: UInt32($0.count), presentationTimeStamp: .zero, decodeTimeStamp: .invalid, timestamp: .zero, config: nil, nalUnit: Data([0x06, 0x05]))
+        }
+        XCTAssertEqual(pes?.data, Data([0x00, 0x00, 0x00, 0x01, 0x09, 0x30, 0x00, 0x00, 0x00, 0x01, 0x06, 0x05, 0x00, 0x00, 0x00, 0x01, 0x65, 0x88]))
+    }
 }
@@ -0,0 +1,301 @@
+import Foundation
+import XCTest
+
+@testable import HaishinKit
+
+final class TSAnalyzerTests: XCTestCase {
+    private static let pmtPID: UInt16 = 4095
+    private static let videoPID: UInt16 = 256
+
+    private var alarms: [TSAnalyzer.Alarm] = []
+
+    override func setUp() {
+        alarms.removeAll()
+    }
+
+    func testHealthyStreamRaisesNoAlarms() {
+        let analyzer = makeAnalyzer()
+        analyzer.analyze(makeStream().reduce(Data(), +))
+        XCTAssertEqual(alarms, [])
+        XCTAssertEqual(analyzer.packetCount, 1000)
+        XCTAssertEqual(analyzer.bitRate, Double(TSPacket.size * 8 * 1000), accuracy: 1)
+        XCTAssertEqual(Set(analyzer.pids), [0, Self.pmtPID, Self.videoPID])
+        XCTAssertEqual(analyzer.statistics(of: Self.videoPID)?.pcrCount, 100)
+        XCTAssertEqual(analyzer.statistics(of: Self.videoPID)?.ptsCount, 34)
+    }
+
+    func testAnalyzesStreamSplitAnywhere() {
+        let analyzer = makeAnalyzer()
+        let data = makeStream().reduce(Data(), +)
+        var offset = 0
+        while offset < data.count {
+            let count = min(1316 + offset % 7, data.count - offset)
+            analyzer.analyze(data.subdata(in: offset..<offset + count))
+            offset += count
+        }
+        XCTAssertEqual(alarms, [])
+        XCTAssertEqual(analyzer.packetCount, 1000)
+    }
+
+    func testContinuityCountError() {
+        var gap: UInt8 = 0
+        let analyzer = makeAnalyzer()
+        analyzer.analyze(makeStream { index, packet in
+            if index == 500 {
+                gap = 1
+            }
+            if packet.pid == Self.videoPID {
+                packet.continuityCounter = (packet.continuityCounter + gap) & 0x0f
+            }
+        }.reduce(Data(), +))
+        XCTAssertEqual(alarms.map { $0.kind }, [.continuityCountError])
+        XCTAssertEqual(alarms.first?.pid, Self.videoPID)
+        XCTAssertEqual(analyzer.statistics(of: Self.videoPID)?.continuityCountErrorCount, 1)
+    }
+
+    func testAllowsOneDuplicatePacket() {
+        var packets = makeStream()
+        packets.insert(packets[505], at: 505)
+        var analyzer = makeAnalyzer()
+        analyzer.analyze(packets.reduce(Data(), +))
+        XCTAssertNil(analyzer.alarmCounts[.continuityCountError])
+
+        packets.insert(packets[505], at: 505)
+        analyzer = makeAnalyzer()
+        analyzer.analyze(packets.reduce(Data(), +))
+        XCTAssertEqual(analyzer.alarmCounts[.continuityCountError], 1)
+    }
+
+    func testSyncByteErrorAndSyncLoss() {
+        var packets = makeStream()
+        packets[300][0] = 0x00
+        var analyzer = makeAnalyzer()
+        analyzer.analyze(packets.reduce(Data(), +))
+        XCTAssertEqual(analyzer.alarmCounts[.syncByteError], 1)
+        XCTAssertNil(analyzer.alarmCounts[.syncLoss])
+
+        packets[301][0] = 0x00
+        analyzer = makeAnalyzer()
+        analyzer.analyze(packets.reduce(Data(), +))
+        XCTAssertEqual(analyzer.alarmCounts[.syncByteError], 2)
+        XCTAssertEqual(analyzer.alarmCounts[.syncLoss], 1)
+        // The sync is acquired again at the next packet.
+        XCTAssertEqual(analyzer.packetCount, 1000 - 2)
+    }
+
+    func testTransportError() {
+        let analyzer = makeAnalyzer()
+        analyzer.analyze(makeStream { index, packet in
+            packet.transportErrorIndicator = index == 400
+        }.reduce(Data(), +))
+        XCTAssertEqual(alarms.map { $0.kind }, [.transportError])
+        XCTAssertEqual(alarms.first?.position, Int64(TSPacket.size * 400))
+    }
+
+    func testCRCError() {
+        let analyzer = makeAnalyzer()
+        analyzer.analyze(makeStream { index, packet in
+            if index == 200 {
+                packet.payload[4] ^= 0xff
+            }
+        }.reduce(Data(), +))
+        XCTAssertEqual(alarms.map { $0.kind }, [.crcError])
+        XCTAssertEqual(alarms.first?.pid, 0)
+    }
+
+    func testPATError() {
+        let analyzer = makeAnalyzer()
+        analyzer.analyze(makeStream { index, packet in
+            if packet.pid == 0 && 0 < index {
+                packet.pid = TSAnalyzer.nullPID
+            }
+        }.reduce(Data(), +))
+        XCTAssertEqual(Set(alarms.map { $0.kind }), [.patError])
+    }
+
+    func testPIDError() {
+        let analyzer = makeAnalyzer()
+        analyzer.pidTimeout = 0.2
+        analyzer.analyze(makeStream { index, packet in
+            if packet.pid == Self.videoPID && 300 <= index && index < 600 {
+                packet.pid = TSAnalyzer.nullPID
+            }
+        }.reduce(Data(), +))
+        XCTAssertEqual(analyzer.alarmCounts[.pidError], 1)
+        XCTAssertEqual(alarms.first { $0.kind == .pidError }?.pid, Self.videoPID)
+    }
+
+    func testPCRDiscontinuity() {
+        var analyzer = makeAnalyzer()
+        analyzer.analyze(makeStream { index, packet in
+            if 500 <= index, let pcr = packet.pcr {
+                packet.pcr = pcr + 27_000_000
+            }
+        }.reduce(Data(), +))
+        XCTAssertEqual(analyzer.alarmCounts[.pcrDiscontinuityIndicatorError], 1)
+
+        alarms.removeAll()
+        analyzer = makeAnalyzer()
+        analyzer.analyze(makeStream { index, packet in
+            if 500 <= index, let pcr = packet.pcr {
+                packet.pcr = pcr + 27_000_000
+                packet.discontinuityIndicator = index < 510
+            }
+        }.reduce(Data(), +))
+        XCTAssertEqual(alarms, [])
+    }
+
+    func testPCRAccuracyError() {
+        let analyzer = makeAnalyzer()
+        analyzer.analyze(makeStream { index, packet in
+            if index == 702, let pcr = packet.pcr {
+                packet.pcr = pcr + 27_000
+            }
+        }.reduce(Data(), +))
+        XCTAssertEqual(analyzer.alarmCounts[.pcrAccuracyError], 2)
+    }
+
+    func testPTSError() {
+        let analyzer = makeAnalyzer()
+        analyzer.analyze(makeStream { index, packet in
+            if 600 <= index, packet.presentationTimeStamp != nil {
+                packet.presentationTimeStamp! += 90_000
+            }
+        }.reduce(Data(), +))
+        XCTAssertEqual(alarms.map { $0.kind }, [.ptsError])
+    }
+
+    func testVariableBitRateStreamIsTimedByPCR() {
+        let analyzer = makeAnalyzer(isConstantBitRate: false)
+        // The PCRs advance twice as fast as the bytes, as if the bit rate dropped by half.
+        analyzer.analyze(makeStream { index, packet in
+            if 500 <= index, let pcr = packet.pcr {
+                packet.pcr = pcr * 2 - 500 * 27_000
+            }
+        }.reduce(Data(), +))
+        XCTAssertNil(analyzer.alarmCounts[.pcrAccuracyError])
+        XCTAssertNil(analyzer.alarmCounts[.pcrRepetitionError])
+        XCTAssertNil(analyzer.alarmCounts[.pcrDiscontinuityIndicatorError])
+    }
+
+    func testPCRRepetitionErrorByArrivalTime() {
+        let analyzer = makeAnalyzer(isConstantBitRate: false)
+        for (index, data) in makeStream().enumerated() {
+            // The input stalls for 200 milliseconds after the 500th packet.
+            analyzer.analyze(data, arrivalTime: 100 + Double(index) / 1000 + (500 <= index ? 0.2 : 0))
+        }
+        XCTAssertEqual(analyzer.alarmCounts[.pcrRepetitionError], 1)
+        XCTAssertNil(analyzer.alarmCounts[.pcrAccuracyError])
+    }
+
+    func testSampleAsset() throws {
+        let bundle = Bundle(for: type(of: self))
+        let url = URL(fileURLWithPath: bundle.path(forResource: "SampleVideo_360x240_5mb_2ch", ofType: "ts")!)
+        let data = try Data(contentsOf: url)
+        let analyzer = TSAnalyzer()
+        analyzer.analyze(data)
+        XCTAssertEqual(analyzer.packetCount, data.count / TSPacket.size)
+        XCTAssertNil(analyzer.alarmCounts[.syncByteError])
+        XCTAssertNil(analyzer.alarmCounts[.continuityCountError])
+        XCTAssertNil(analyzer.alarmCounts[.crcError])
+        // The sample asset has a variable bit rate, which must not raise PCR alarms.
+        XCTAssertEqual(analyzer.alarmCounts.filter { $0.key.priority == 2 }, [:])
+        XCTAssertLessThan(0, analyzer.bitRate)
+    }
+
+    private func makeAnalyzer(isConstantBitRate: Bool = true) -> TSAnalyzer {
+        let analyzer = TSAnalyzer()
+        analyzer.isConstantBitRate = isConstantBitRate
+        analyzer.delegate = self
+        return analyzer
+    }
+
+    /// Makes a stream of 1000 packets per second with the PAT and the PMT every 20 packets, a PCR every 10 packets and a PES header every 30 packets.
+    private func makeStream(count: Int = 1000, transform: (Int, inout Packet) -> Void = { _, _ in }) -> [Data] {
+        let pat = TSProgramAssociation()
+        pat.programs = [1: Self.pmtPID]
+        let pmt = TSProgramMap()
+        pmt.PCRPID = Self.videoPID
+        var data = ESSpecificData()
+        data.streamType = .h264
+        data.elementaryPID = Self.videoPID
+        pmt.elementaryStreamSpecificData = [data]
+
+        var continuityCounters: [UInt16: UInt8] = [:]
+        return (0..<count).map { index in
+            var packet: Packet
+            switch index % 20 {
+            case 0:
+                packet = Packet(pid: TSWriter.defaultPATPID, payloadUnitStartIndicator: true, payload: pat.data)
+            case 1:
+                packet = Packet(pid: Self.pmtPID, payloadUnitStartIndicator: true, payload: pmt.data)
+            default:
+                packet = Packet(pid: Self.videoPID)
+                if index % 10 == 2 {
+                    packet.pcr = UInt64(index) * 27_000
+                }
+                if index % 30 == 3 {
+                    packet.payloadUnitStartIndicator = true
+                    packet.presentationTimeStamp = UInt64(index) * 90
+                }
+            }
+            packet.continuityCounter = continuityCounters[packet.pid, default: 0]
+            continuityCounters[packet.pid] = (packet.continuityCounter + 1) & 0x0f
+            transform(index, &packet)
+            return packet.data
+        }
+    }
+}
+
+extension TSAnalyzerTests: TSAnalyzerDelegate {
+    func analyzer(_ analyzer: TSAnalyzer, didRaise alarm: TSAnalyzer.Alarm) {
+        alarms.append(alarm)
+    }
+}
+
+private struct Packet {
+    var pid: UInt16
+    var continuityCounter: UInt8 = 0
+    var payloadUnitStartIndicator = false
+    var transportErrorIndicator = false
+    var discontinuityIndicator = false
+    var pcr: UInt64?
+    var presentationTimeStamp: UInt64?
+    var payload = Data()
+
+    var data: Data {
+        var data = Data([
+            TSPacket.defaultSyncByte,
+            (transportErrorIndicator ? 0x80 : 0) | (payloadUnitStartIndicator ? 0x40 : 0) | UInt8(pid >> 8),
+            UInt8(pid & 0xff),
+            (pcr == nil ? 0x10 : 0x30) | continuityCounter
+        ])
+        if let pcr {
+            let base = pcr / 300
+            let ext = pcr % 300
+            data.append(contentsOf: [
+                7,
+                (discontinuityIndicator ? 0x80 : 0) | 0x10,
+                UInt8(truncatingIfNeeded: base >> 25),
+                UInt8(truncatingIfNeeded: base >> 17),
+                UInt8(truncatingIfNeeded: base >> 9),
+                UInt8(truncatingIfNeeded: base >> 1),
+                UInt8(truncatingIfNeeded: base << 7) | 0x7e | UInt8(ext >> 8),
+                UInt8(ext & 0xff)
+            ])
+        }
+        if let pts = presentationTimeStamp {
+            data.append(contentsOf: [0x00, 0x00, 0x01, 0xe0, 0x00, 0x00, 0x80, 0x80, 0x05])
+            data.append(contentsOf: [
+                0x21 | UInt8(truncatingIfNeeded: pts >> 29) & 0x0e,
+                UInt8(truncatingIfNeeded: pts >> 22),
+                UInt8(truncatingIfNeeded: pts >> 14) & 0xfe | 0x01,
+                UInt8(truncatingIfNeeded: pts >> 7),
+                UInt8(truncatingIfNeeded: pts << 1) | 0x01
+            ])
+        }
+        data.append(payload)
+        data.append(Data(repeating: 0xff, count: TSPacket.size - data.count))
+        return data
+    }
+}
@@ -24,5 +24,8 @@ final class TSPacketTests: XCTestCase {
         XCTAssertEqual(0, TSTimestamp.decode(Data([17, 0, 1, 0, 1])))
         XCTAssertEqual(Data([49, 0, 1, 0, 1]), TSTimestamp.encode(0, TSTimestamp.ptsDtsMask))
         XCTAssertEqual(Data([17, 0, 1, 0, 1]), TSTimestamp.encode(0, TSTimestamp.ptsMask))
+        for value: Int64 in [1, 127, 126000, 0x1_FFFF_FFFF] {
+            XCTAssertEqual(value, TSTimestamp.decode(TSTimestamp.encode(value, TSTimestamp.ptsMask)))
+        }
     }
 }
@@ -19,6 +19,39 @@ final class TSReaderTests: XCTestCase {
         } catch {
         }
     }
+
+    func testDuplicatePacketsDiscarded() throws {
+        let bundle = Bundle(for: type(of: self))
+        let url = URL(fileURLWithPath: bundle.path(forResource: "SampleVideo_360x240_5mb_2ch", ofType: "ts")!)
+        let data = try FileHandle(forReadingFrom: url).readDataToEndOfFile().prefix(TSPacket.size * 1000)
+        var duplicated = Data()
+        for i in 0..<data.count / TSPacket.size {
+            let packet = data.subdata(in: i * TSPacket.size..<(i + 1) * TSPacket.size)
+            duplicated.append(packet)
+            duplicated.append(packet)
+        }
+        let reader = TSReader()
+        let readerDelegate = TSReaderCounter()
+        reader.delegate = readerDelegate
+        _ = reader.read(data)
+        let sampleCount = readerDelegate.sampleCount
+        XCTAssertEqual(reader.duplicatePacketCount, 0)
+        reader.clear()
+        readerDelegate.sampleCount = 0
+        _ = reader.read(duplicated)
+        XCTAssertEqual(reader.packetCount, 2000)
+        XCTAssertEqual(reader.duplicatePacketCount, 1000)
+        XCTAssertEqual(readerDelegate.sampleCount, sampleCount)
+    }
+
+    func testNullPacketsAreNotDuplicates() {
+        var packet = Data([TSPacket.defaultSyncByte, 0x1f, 0xff, 0x10])
+        packet.append(Data(repeating: 0xff, count: TSPacket.size - packet.count))
+        let reader = TSReader()
+        _ = reader.read(packet + packet + packet)
+        XCTAssertEqual(reader.packetCount, 3)
+        XCTAssertEqual(reader.duplicatePacketCount, 0)
+    }
 }
 
 private final class TSReaderAudioCodec: TSReaderDelegate, AudioCodecDelegate {
@@ -40,6 +73,9 @@ private final class TSReaderAudioCodec: TSReaderDelegate, AudioCodecDelegate {
         }
     }
 
+    func reader(_ reader: HaishinKit.TSReader, id: UInt16, didRead metadata: HaishinKit.TimedMetadata) {
+    }
+
     func audioCodec(_ codec: HaishinKit.AudioCodec<TSReaderAudioCodec>, didOutput outputFormat: AVAudioFormat?) {
     }
 
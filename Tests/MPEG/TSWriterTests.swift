@@ -0,0 +1,72 @@
+import AVFoundation
+import CoreMedia
+import Foundation
+import XCTest
+
+@testable import HaishinKit
+
+final class TSWriterTests: XCTestCase {
+    func testTimedMetadata() {
+        let when = AVAudioTime(hostTime: AVAudioTime.hostTime(forSeconds: 2))
+        let timestamp = when.makeTime()
+        var asbd = AudioStreamBasicDescription(
+            mSampleRate: 44100,
+            mFormatID: kAudioFormatMPEG4AAC,
+            mFormatFlags: UInt32(MPEG4ObjectID.AAC_LC.rawValue),
+            mBytesPerPacket: 0,
+            mFramesPerPacket: 1024,
+            mBytesPerFrame: 0,
+            mChannelsPerFrame: 2,
+            mBitsPerChannel: 0,
+            mReserved: 0
+        )
+        guard let audioFormat = AVAudioFormat(streamDescription: &asbd) else {
+            XCTFail()
+            return
+        }
+        let delegate = TSWriterReaderDelegate()
+        let writer = TSWriter()
+        writer.delegate = delegate
+        writer.expectedMedias = [.audio]
+        writer.audioFormat = audioFormat
+        writer.append(TimedMetadata(timestamp: timestamp, payload: Data([0x01, 0x02, 0x03])))
+        let audioBuffer = AVAudioCompressedBuffer(format: audioFormat, packetCapacity: 1, maximumPacketSize: 64)
+        audioBuffer.byteLength = 64
+        audioBuffer.packetCount = 1
+        writer.append(audioBuffer, when: when)
+        XCTAssertEqual(delegate.metadatas.first?.payload, Data([0x01, 0x02, 0x03]))
+        XCTAssertEqual(delegate.metadatas.first?.timestamp.seconds, 0)
+
+        let PMT = TSProgramMap(writer.PMT.data)
+        XCTAssertEqual(PMT?.programDescriptors, TSWriter.metadataPointerDescriptor)
+        let metadata = PMT?.elementaryStreamSpecificData.first { $0.elementaryPID == TSWriter.defaultMetadataPID }
+        XCTAssertEqual(metadata?.streamType, .metadata)
+        XCTAssertEqual(metadata?.esDescriptors, TSWriter.metadataDescriptor)
+    }
+}
+
+private final class TSWriterReaderDelegate: TSWriterDelegate, TSReaderDelegate {
+    private(set) var metadatas: [TimedMetadata] = []
+    private lazy var reader: TSReader = {
+        let reader = TSReader()
+        reader.delegate = self
+        return reader
+    }()
+
+    func writer(_ writer: TSWriter, didRotateFileHandle timestamp: CMTime) {
+    }
+
+    func writer(_ writer: TSWriter, didOutput data: Data) {
+        _ = reader.read(data)
+    }
+
+    func reader(_ reader: TSReader, id: UInt16, didRead formatDescription: CMFormatDescription) {
+    }
+
+    func reader(_ reader: TSReader, id: UInt16, didRead sampleBuffer: CMSampleBuffer) {
+    }
+
+    func reader(_ reader: TSReader, id: UInt16, didRead metadata: TimedMetadata) {
+        metadatas.append(metadata)
+    }
+}
@@ -0,0 +1,85 @@
+import Foundation
+import XCTest
+
+@testable import HaishinKit
+
+final class ChoreographerTests: XCTestCase {
+    func testTimerChoreographerPacing() {
+        let recorder = ChoreographerRecorder(frameCount: 120)
+        let choreographer = TimerChoreographer(preferredFramesPerSecond: 60)
+        choreographer.delegate = recorder
+        choreographer.startRunning()
+        choreographer.isPaused = false
+        wait(for: [recorder.expectation], timeout: 5)
+        choreographer.stopRunning()
+
+        let timestamps = recorder.timestamps
+        let interval = 1.0 / 60.0
+        let intervals = zip(timestamps.dropFirst(), timestamps).map { $0 - $1 }
+        let mean = intervals.reduce(0, +) / Double(intervals.count)
+        let jitter = sqrt(intervals.map { ($0 - mean) * ($0 - mean) }.reduce(0, +) / Double(intervals.count))
+        // The bounds are loose, as the wall clock of a shared CI machine stalls now and then.
+        XCTAssertEqual(mean, interval, accuracy: interval * 0.25)
+        XCTAssertLessThan(jitter, interval)
+        // Deadlines are absolute, so the error does not grow with the number of frames.
+        let drift = (timestamps.last ?? 0) - (timestamps.first ?? 0) - Double(timestamps.count - 1) * interval
+        XCTAssertLessThan(abs(drift), interval * 3)
+        // The reported duration follows the monotonic clock.
+        XCTAssertEqual(recorder.durations.last ?? 0, (timestamps.last ?? 0) - (timestamps.first ?? 0) + (recorder.durations.first ?? 0), accuracy: 0.02)
+    }
+
+    func testTimerChoreographerBatching() {
+        let recorders = (0..<8).map { _ in ChoreographerRecorder(frameCount: 10) }
+        let choreographers = recorders.map { recorder -> TimerChoreographer in
+            let choreographer = TimerChoreographer(preferredFramesPerSecond: 30)
+            choreographer.delegate = recorder
+            choreographer.startRunning()
+            choreographer.isPaused = false
+            return choreographer
+        }
+        XCTAssertEqual(ChoreographerTimer.shared(30).count, 8)
+        wait(for: recorders.map { $0.expectation }, timeout: 5)
+        for choreographer in choreographers {
+            choreographer.stopRunning()
+        }
+        XCTAssertEqual(ChoreographerTimer.shared(30).count, 0)
+    }
+
+    func testChoreographerMode() {
+        XCTAssertTrue(ChoreographerMode.displayLink.makeChoreographer() is DisplayLinkChoreographer)
+        XCTAssertEqual((ChoreographerMode.timer(preferredFramesPerSecond: 30).makeChoreographer() as? TimerChoreographer)?.preferredFramesPerSecond, 30)
+        XCTAssertEqual(ChoreographerMode.automatic.makeChoreographer() is DisplayLinkChoreographer, DisplayLinkChoreographer.isAvailable)
+    }
+
+    func testTimerChoreographerPaused() {
+        let recorder = ChoreographerRecorder(frameCount: 1)
+        recorder.expectation.isInverted = true
+        let choreographer = TimerChoreographer(preferredFramesPerSecond: 60)
+        choreographer.delegate = recorder
+        choreographer.startRunning()
+        wait(for: [recorder.expectation], timeout: 0.2)
+        choreographer.stopRunning()
+    }
+}
+
+private final class ChoreographerRecorder: ChoreographerDelegate {
+    let expectation = XCTestExpectation()
+    private(set) var timestamps: [Double] = []
+    private(set) var durations: [Double] = []
+    private let frameCount: Int
+
+    init(frameCount: Int) {
+        self.frameCount = frameCount
+    }
+
+    func choreographer(_ choreographer: any Choreographer, didFrame duration: Double) {
+        guard timestamps.count < frameCount else {
+            return
+        }
+        timestamps.append(Double(DispatchTime.now().uptimeNanoseconds) / 1_000_000_000)
+        durations.append(duration)
+        if timestamps.count == frameCount {
+            expectation.fulfill()
+        }
+    }
+}
@@ -0,0 +1,141 @@
+import Foundation
+import XCTest
+import CoreMedia
+import AVFoundation
+
+@testable import HaishinKit
+
+final class IOFragmentedRecorderTests: XCTestCase {
+    private var directory: URL!
+    private var finishedFiles: [URL] = []
+    private var errors: [IOFragmentedRecorder.Error] = []
+
+    override func setUpWithError() throws {
+        directory = FileManager.default.temporaryDirectory.appendingPathComponent(UUID().uuidString)
+        try FileManager.default.createDirectory(at: directory, withIntermediateDirectories: true)
+        finishedFiles.removeAll()
+        errors.removeAll()
+    }
+
+    override func tearDownWithError() throws {
+        try FileManager.default.removeItem(at: directory)
+    }
+
+    func testRollsFilesBySizeAtKeyFrames() throws {
+        let recorder = makeRecorder(.init(fragmentDuration: 1, maximumFileSize: 64 * 1024, expectedMedias: [.video]))
+        recorder.startRunning()
+        appendFrames(recorder, count: 120)
+        recorder.stopRunning()
+        XCTAssertEqual(finishedFiles.count, 4)
+        XCTAssertTrue(errors.isEmpty)
+        for url in finishedFiles {
+            let data = try Data(contentsOf: url)
+            XCTAssertEqual(data.count % TSPacket.size, 0)
+            // A file starts with the program association table.
+            XCTAssertEqual(data[0], 0x47)
+            XCTAssertEqual(UInt16(data[1] & 0x1f) << 8 | UInt16(data[2]), 0)
+        }
+    }
+
+    func testSynchronizesEachFragment() {
+        let recorder = makeRecorder(.init(fragmentDuration: 1, expectedMedias: [.video]))
+        recorder.startRunning()
+        appendFrames(recorder, count: 120)
+        recorder.stopRunning()
+        // Three fragments and the close are synchronized before stopRunning returns.
+        XCTAssertGreaterThanOrEqual(recorder.synchronizationCount, 4)
+        XCTAssertEqual(finishedFiles.count, 1)
+    }
+
+    func testIgnoresUnchangedFormats() throws {
+        let recorder = makeRecorder(.init(fragmentDuration: 1, expectedMedias: [.video]))
+        recorder.startRunning()
+        let formatDescription = recorder.videoFormat
+        for _ in 0..<3 {
+            recorder.videoFormat = formatDescription
+        }
+        appendFrames(recorder, count: 30)
+        recorder.stopRunning()
+        XCTAssertEqual(finishedFiles.count, 1)
+        let data = try Data(contentsOf: finishedFiles[0])
+        let packets = stride(from: 0, to: data.count, by: TSPacket.size).compactMap {
+            TSPacket(data: data.subdata(in: $0..<$0 + TSPacket.size))
+        }
+        guard let packet = packets.first(where: { $0.pid == TSWriter.defaultPMTPID }), let pmt = TSProgramMap(packet.payload) else {
+            XCTFail()
+            return
+        }
+        XCTAssertEqual(pmt.elementaryStreamSpecificData.count, 1)
+    }
+
+    func testRecoversFileOfKilledRecording() throws {
+        let recorder = makeRecorder(.init(fragmentDuration: 1, expectedMedias: [.video]))
+        recorder.startRunning()
+        appendFrames(recorder, count: 90)
+        guard let url = recorder.url else {
+            XCTFail()
+            return
+        }
+        // Waits for the queued writes. Closing only synchronizes, so the file is what a kill would leave.
+        recorder.stopRunning()
+        // The recording is killed without finishing, and the last write is torn.
+        let killed = directory.appendingPathComponent("killed.ts")
+        var data = try Data(contentsOf: url)
+        data.removeLast(TSPacket.size / 2)
+        try data.write(to: killed)
+        XCTAssertNotEqual(data.count % TSPacket.size, 0)
+
+        let recovered = try IOFragmentedRecorder.recover(killed)
+        XCTAssertEqual(recovered % TSPacket.size, 0)
+        XCTAssertEqual(recovered, data.count - data.count % TSPacket.size)
+
+        let reader = TSReader()
+        let delegate = TSReaderCounter()
+        reader.delegate = delegate
+        XCTAssertEqual(reader.read(try Data(contentsOf: killed)), recovered)
+        XCTAssertEqual(reader.packetCount, recovered / TSPacket.size)
+        XCTAssertGreaterThan(delegate.sampleCount, 0)
+    }
+
+    func testRecoversFileEndingInGarbage() throws {
+        let url = directory.appendingPathComponent("garbage.ts")
+        var data = Data(count: TSPacket.size * 3)
+        for i in 0..<3 {
+            data[i * TSPacket.size] = 0x47
+        }
+        data.append(Data(repeating: 0xff, count: TSPacket.size))
+        try data.write(to: url)
+        XCTAssertEqual(try IOFragmentedRecorder.recover(url), TSPacket.size * 3)
+    }
+
+    private func makeRecorder(_ settings: IOFragmentedRecorder.Settings) -> IOFragmentedRecorder {
+        let recorder = IOFragmentedRecorder(directory: directory)
+        recorder.delegate = self
+        recorder.settings = settings
+        recorder.videoFormat = CMVideoSampleBufferFactory.makeFormatDescription()
+        return recorder
+    }
+
+    private func appendFrames(_ recorder: IOFragmentedRecorder, count: Int) {
+        let formatDescription = recorder.videoFormat
+        for frameNumber in 0..<count {
+            if let sampleBuffer = CMVideoSampleBufferFactory.makeEncodedFrame(formatDescription, frameNumber: frameNumber) {
+                recorder.append(sampleBuffer)
+            }
+        }
+    }
+}
+
+extension IOFragmentedRecorderTests: IOFragmentedRecorderDelegate {
+    func recorder(_ recorder: IOFragmentedRecorder, errorOccured error: IOFragmentedRecorder.Error) {
+        errors.append(error)
+    }
+
+    func recorder(_ recorder: IOFragmentedRecorder, didFinishFile url: URL) {
+        finishedFiles.append(url)
+        // The delegate is told on the file queue outside the lock, so that it may read the properties.
+        XCTAssertFalse(Thread.isMainThread)
+        XCTAssertNotEqual(recorder.url, url)
+        XCTAssertLessThan(0, recorder.synchronizationCount)
+    }
+}
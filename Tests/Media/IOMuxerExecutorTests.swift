@@ -0,0 +1,75 @@
+import AVFoundation
+import Foundation
+import XCTest
+
+@testable import HaishinKit
+
+final class IOMuxerExecutorTests: XCTestCase {
+    func testPostEncodePath() {
+        let mixer = IOMixer()
+        let muxer = CountingMuxer(executor: mixer.executor)
+        mixer.muxer = muxer
+        let codec = VideoCodec<IOMixer>(lockQueue: DispatchQueue(label: "IOMuxerExecutorTests.codec"))
+        let formatDescription = CMVideoSampleBufferFactory.makeFormatDescription()
+        XCTAssertNotNil(formatDescription)
+        for frameNumber in 0..<100 {
+            guard let sampleBuffer = CMVideoSampleBufferFactory.makeEncodedFrame(formatDescription, frameNumber: frameNumber) else {
+                XCTFail()
+                return
+            }
+            mixer.videoCodec(codec, didOutput: sampleBuffer)
+        }
+        mixer.executor.queue.sync {}
+        XCTAssertEqual(muxer.frameCount, 100)
+        XCTAssertFalse(muxer.isCalledOffExecutor)
+        let metrics = mixer.executor.metrics
+        XCTAssertEqual(metrics.frameCount, 100)
+        XCTAssertEqual(metrics.hopsPerFrame, 1)
+        XCTAssertEqual(metrics.latency.count, 100)
+        XCTAssertLessThan(0, metrics.latency.percentile(0.5))
+    }
+
+    func testSocketHandoffIsCoalesced() {
+        let executor = IOMuxerExecutor()
+        let socket = NetSocket()
+        executor.execute {
+            // The chunks of a frame.
+            for _ in 0..<10 {
+                socket.doOutput(data: Data(count: 128))
+            }
+        }
+        executor.queue.sync {}
+        XCTAssertEqual(executor.metrics.frameCount, 1)
+        XCTAssertEqual(executor.metrics.hopsPerFrame, 2)
+        XCTAssertEqual(socket.queueBytesOut.value, 1280)
+    }
+}
+
+private final class CountingMuxer: IOMuxer {
+    var audioFormat: AVAudioFormat?
+    var videoFormat: CMFormatDescription?
+    var isRunning: Atomic<Bool> = .init(false)
+    private(set) var frameCount = 0
+    private(set) var isCalledOffExecutor = false
+    private weak var executor: IOMuxerExecutor?
+
+    init(executor: IOMuxerExecutor) {
+        self.executor = executor
+    }
+
+    func append(_ audioBuffer: AVAudioBuffer, when: AVAudioTime) {
+    }
+
+    func append(_ sampleBuffer: CMSampleBuffer) {
+        if IOMuxerExecutor.current !== executor {
+            isCalledOffExecutor = true
+        }
+        frameCount += 1
+    }
+
+    func startRunning() {
+    }
+
+    func stopRunning() {
+    }
+}
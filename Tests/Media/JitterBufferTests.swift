@@ -0,0 +1,86 @@
+import Foundation
+import XCTest
+
+@testable import HaishinKit
+
+final class JitterBufferTests: XCTestCase {
+    private static let frameInterval = 1.0 / 30.0
+    private static let tick = 1.0 / 60.0
+
+    func testSteadyNetwork() {
+        let arrivals = (0..<300).map { (timestamp: Double($0) * Self.frameInterval, time: 0.5 + Double($0) * Self.frameInterval) }
+        let result = simulate(arrivals, duration: 10)
+        XCTAssertEqual(result.buffer.jitter, 0, accuracy: 0.001)
+        XCTAssertEqual(result.buffer.targetDelay, result.buffer.settings.minimumDelay, accuracy: 0.001)
+        XCTAssertEqual(result.buffer.underrunCount, 0)
+        XCTAssertEqual(result.maximumPlaybackRate, 1.0)
+    }
+
+    func testJitteryNetwork() {
+        var seed: UInt32 = 1
+        var arrivals = (0..<900).map { i -> (timestamp: Double, time: Double) in
+            seed = seed &* 1103515245 &+ 12345
+            let jitter = Double(seed >> 16 & 0x7FFF) / Double(0x8000) * 0.08
+            return (Double(i) * Self.frameInterval, 0.5 + Double(i) * Self.frameInterval + jitter)
+        }
+        arrivals.sort { $0.time < $1.time }
+        let result = simulate(arrivals, duration: 30)
+        XCTAssertGreaterThan(result.buffer.jitter, 0.01)
+        XCTAssertGreaterThan(result.buffer.targetDelay, result.buffer.settings.minimumDelay)
+        XCTAssertEqual(result.buffer.underrunCount, 0)
+    }
+
+    func testCatchUpAfterStall() {
+        // A two-second stall followed by a burst leaves the playback two seconds behind.
+        let arrivals = (0..<1800).map { i -> (timestamp: Double, time: Double) in
+            let timestamp = Double(i) * Self.frameInterval
+            return (timestamp, (90..<150).contains(i) ? 0.5 + 150 * Self.frameInterval : 0.5 + timestamp)
+        }
+        let result = simulate(arrivals, duration: 60)
+        XCTAssertEqual(result.buffer.underrunCount, 1)
+        XCTAssertEqual(result.maximumPlaybackRate, result.buffer.settings.catchUpRate)
+        XCTAssertGreaterThan(result.maximumDelay, 1.5)
+        XCTAssertLessThanOrEqual(result.delay, result.buffer.targetDelay + result.buffer.settings.catchUpThreshold)
+        XCTAssertEqual(result.buffer.playbackRate, 1.0)
+    }
+
+    func testLateFrame() {
+        let buffer = JitterBuffer()
+        XCTAssertFalse(buffer.isLate(1.0, playhead: 1.05))
+        XCTAssertTrue(buffer.isLate(1.0, playhead: 1.2))
+    }
+
+    /// Plays the arrivals back on a 60Hz clock in the same way as MediaLink does.
+    private func simulate(_ arrivals: [(timestamp: Double, time: Double)], duration: Double) -> (buffer: JitterBuffer, delay: Double, maximumDelay: Double, maximumPlaybackRate: Double) {
+        var buffer = JitterBuffer()
+        var playhead = 0.0
+        var latest = 0.0
+        var index = 0
+        var time = 0.0
+        var maximumDelay = 0.0
+        var maximumPlaybackRate = 1.0
+        while time < duration {
+            time += Self.tick
+            while index < arrivals.count && arrivals[index].time <= time {
+                latest = max(latest, arrivals[index].timestamp)
+                buffer.arrive(arrivals[index].timestamp, at: arrivals[index].time)
+                if buffer.isBuffering {
+                    buffer.update(latest - playhead, elapsed: 0)
+                }
+                index += 1
+            }
+            guard !buffer.isBuffering else {
+                continue
+            }
+            playhead += Self.tick * buffer.playbackRate
+            if latest - playhead <= 0 {
+                buffer.underrun()
+            } else {
+                buffer.update(latest - playhead, elapsed: Self.tick)
+            }
+            maximumDelay = max(maximumDelay, latest - playhead)
+            maximumPlaybackRate = max(maximumPlaybackRate, buffer.playbackRate)
+        }
+        return (buffer, latest - playhead, maximumDelay, maximumPlaybackRate)
+    }
+}
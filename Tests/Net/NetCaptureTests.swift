@@ -0,0 +1,140 @@
+import Foundation
+import XCTest
+
+@testable import HaishinKit
+
+final class NetCaptureTests: XCTestCase {
+    private var directory: URL!
+
+    override func setUpWithError() throws {
+        directory = FileManager.default.temporaryDirectory.appendingPathComponent(UUID().uuidString)
+        try FileManager.default.createDirectory(at: directory, withIntermediateDirectories: true)
+    }
+
+    override func tearDownWithError() throws {
+        try FileManager.default.removeItem(at: directory)
+    }
+
+    func testReadsWrittenRecords() throws {
+        let url = directory.appendingPathComponent("session.hkcap")
+        let capture = try NetCapture(url: url, content: .rtmp)
+        capture.append(Data([0x03]), direction: .output)
+        capture.append(Data(repeating: 0xaa, count: 300), direction: .input)
+        capture.append(Data(repeating: 0xbb, count: 70000), direction: .output)
+        capture.close()
+        XCTAssertEqual(capture.byteCount, 70301)
+
+        let (content, _, records) = try NetCapture.read(url)
+        XCTAssertEqual(content, .rtmp)
+        XCTAssertEqual(records.map { $0.direction }, [.output, .input, .output])
+        XCTAssertEqual(records.map { $0.data.count }, [1, 300, 70000])
+        XCTAssertEqual(records[1].data, Data(repeating: 0xaa, count: 300))
+        XCTAssertEqual(records.map { $0.timestamp }, records.map { $0.timestamp }.sorted())
+    }
+
+    func testReadsRecordsBeforeTruncation() throws {
+        let url = directory.appendingPathComponent("truncated.hkcap")
+        let capture = try NetCapture(url: url, content: .srt)
+        capture.append(Data(repeating: 0x47, count: 1316), direction: .input)
+        capture.append(Data(repeating: 0x47, count: 1316), direction: .input)
+        capture.close()
+        let data = try Data(contentsOf: url)
+        try data.dropLast(100).write(to: url)
+        XCTAssertThrowsError(try NetCapture.read(url)) { error in
+            guard case NetCapture.Error.truncated(let records) = error else {
+                XCTFail()
+                return
+            }
+            XCTAssertEqual(records.count, 1)
+        }
+    }
+
+    func testReplaysToTSReader() throws {
+        let bundle = Bundle(for: type(of: self))
+        let asset = URL(fileURLWithPath: bundle.path(forResource: "SampleVideo_360x240_5mb_2ch", ofType: "ts")!)
+        let data = try Data(contentsOf: asset).prefix(TSPacket.size * 2000)
+        // Records that end in the middle of packets, as a TCP stream does.
+        var records: [NetCapture.Record] = []
+        var offset = 0
+        while offset < data.count {
+            let count = min(1000, data.count - offset)
+            records.append(.init(direction: .input, timestamp: 0, data: data.subdata(in: offset..<offset + count)))
+            offset += count
+        }
+
+        let expected = TSReaderCounter()
+        let reader = TSReader()
+        reader.delegate = expected
+        _ = reader.read(data)
+
+        let actual = TSReaderCounter()
+        let replayReader = TSReader()
+        replayReader.delegate = actual
+        let result = NetCaptureReplayer(content: .ts, records: records).replay(to: replayReader)
+        XCTAssertEqual(result.byteCount, data.count)
+        XCTAssertEqual(result.recordCount, records.count)
+        XCTAssertEqual(replayReader.packetCount, reader.packetCount)
+        XCTAssertEqual(actual.sampleCount, expected.sampleCount)
+        XCTAssertLessThan(0, expected.sampleCount)
+    }
+
+    func testReplaysToRTMPConnection() {
+        let handshake = Data(repeating: 0x00, count: 1 + RTMPHandshake.sigSize * 2)
+        let chunk = RTMPChunk(
+            type: .zero,
+            streamId: RTMPChunk.StreamID.control.rawValue,
+            message: RTMPSetChunkSizeMessage(8192)
+        ).split(RTMPChunk.defaultSize).reduce(Data(), +)
+        let records: [NetCapture.Record] = [
+            .init(direction: .output, timestamp: 0, data: Data(repeating: 0x03, count: 1537)),
+            .init(direction: .input, timestamp: 0, data: handshake.prefix(1000)),
+            .init(direction: .input, timestamp: 0, data: Data(handshake.dropFirst(1000)) + chunk)
+        ]
+        let connection = RTMPConnection()
+        let result = NetCaptureReplayer(content: .rtmp, records: records).replay(to: connection)
+        XCTAssertEqual(result.recordCount, 2)
+        XCTAssertEqual(connection.socket.chunkSizeC, 8192)
+    }
+
+    func testReplaysAtOriginalPacing() {
+        let records: [NetCapture.Record] = [0, 0.05, 0.1].map {
+            .init(direction: .input, timestamp: $0, data: Data([0x00]))
+        }
+        let replayer = NetCaptureReplayer(content: .srt, records: records)
+        XCTAssertGreaterThanOrEqual(replayer.replay(pacing: .original) { _ in }.duration, 0.1)
+        XCTAssertLessThan(replayer.replay(pacing: .asFastAsPossible) { _ in }.duration, 0.1)
+    }
+
+    func testExportsPcapng() throws {
+        let url = directory.appendingPathComponent("session.hkcap")
+        let capture = try NetCapture(url: url, content: .rtmp)
+        capture.append(Data([0x03, 0x00, 0x00]), direction: .output)
+        capture.append(Data(repeating: 0x01, count: 70000), direction: .input)
+        capture.close()
+        let destination = directory.appendingPathComponent("session.pcapng")
+        try NetCapture.exportPcapng(url, to: destination)
+
+        let pcapng = try Data(contentsOf: destination)
+        var packets: [Data] = []
+        var offset = 0
+        while offset + 12 <= pcapng.count {
+            let type = UInt32(data: pcapng.subdata(in: offset..<offset + 4))
+            let length = Int(UInt32(data: pcapng.subdata(in: offset + 4..<offset + 8)))
+            XCTAssertEqual(length % 4, 0)
+            if type == 6 {
+                let count = Int(UInt32(data: pcapng.subdata(in: offset + 20..<offset + 24)))
+                packets.append(pcapng.subdata(in: offset + 28..<offset + 28 + count))
+            }
+            offset += length
+        }
+        XCTAssertEqual(offset, pcapng.count)
+        XCTAssertEqual(UInt32(data: pcapng.subdata(in: 0..<4)), 0x0A0D0D0A)
+        // The input is split to fit in IPv4 packets.
+        XCTAssertEqual(packets.count, 3)
+        XCTAssertEqual(packets[0][0], 0x45)
+        XCTAssertEqual(packets[0][9], 6)
+        XCTAssertEqual(packets[0].suffix(3), Data([0x03, 0x00, 0x00]))
+        XCTAssertEqual(NetCapture.Packetizer.checksum(packets[0].prefix(20).bytes), 0)
+        XCTAssertEqual(packets[1].count + packets[2].count - 80, 70000)
+    }
+}
@@ -10,4 +10,37 @@ final class RTMPMessageTests: XCTestCase {
         message.length = bytes.count
         message.payload = Data(bytes)
     }
+
+    func testTimedMetadataMessage() {
+        let metadata = Data(repeating: 0x0a, count: 300)
+        let message = RTMPTimedMetadataMessage(streamId: 1, timestamp: 33, metadata: metadata)
+        let data = RTMPDataMessage(objectEncoding: .amf0)
+        data.length = message.payload.count
+        data.payload = message.payload
+        XCTAssertEqual(data.handlerName, RTMPTimedMetadataMessage.handlerName)
+        XCTAssertEqual(RTMPTimedMetadataMessage.decode(data.payload), metadata)
+    }
+
+    func testAggregateMessage() {
+        var payload = Data()
+        for (type, timestamp, body) in [(UInt8(8), UInt32(1000), Data([0xAF, 0x01, 0x21])), (UInt8(9), UInt32(1010), Data([0x27, 0x01, 0, 0, 0, 0x41])), (UInt8(8), UInt32(1021), Data([0xAF, 0x01, 0x21, 0x22]))] {
+            var tag = Data([type])
+            tag.append(UInt32(body.count).bigEndian.data[1..<4])
+            tag.append(timestamp.bigEndian.data[1..<4])
+            tag.append(UInt8(timestamp >> 24))
+            tag.append(contentsOf: [0, 0, 0])
+            tag.append(body)
+            payload.append(tag)
+            payload.append(UInt32(tag.count).bigEndian.data)
+        }
+        let message = RTMPAggregateMessage(streamId: 1, timestamp: 5000, payload: payload)
+        let messages = message.makeMessages()
+        XCTAssertEqual(messages.count, 3)
+        XCTAssertTrue(messages[0] is RTMPAudioMessage)
+        XCTAssertTrue(messages[1] is RTMPVideoMessage)
+        XCTAssertEqual(messages.map { $0.timestamp }, [5000, 5010, 5021])
+        XCTAssertEqual(messages[2].payload, Data([0xAF, 0x01, 0x21, 0x22]))
+        // The timestamp of a type 1, 2 or 3 chunk is a delta, which the muxer accumulates.
+        XCTAssertEqual(message.makeMessages(7000).map { $0.timestamp }, [7000, 7010, 7021])
+    }
 }
@@ -1,3 +1,4 @@
+import AVFoundation
 import Foundation
 import XCTest
 
@@ -29,4 +30,59 @@ final class RTMPStreamTests: XCTestCase {
         XCTAssertNil(weakConnection)
         XCTAssertNil(weakStream)
     }
+
+    func testTimedMetadataTimestampsPerChunkStream() {
+        let stream = RTMPStream(connection: RTMPConnection())
+        let delegate = TimedMetadataDelegate()
+        stream.delegate = delegate
+        func append(_ message: RTMPDataMessage, chunkStreamId: RTMPChunk.StreamID, type: RTMPChunkType) {
+            message.chunkStreamId = chunkStreamId.rawValue
+            stream.muxer.append(message, type: type)
+        }
+        func makeTimedMetadata(_ timestamp: UInt32) -> RTMPDataMessage {
+            let message = RTMPDataMessage(objectEncoding: .amf0)
+            message.timestamp = timestamp
+            message.payload = RTMPTimedMetadataMessage(streamId: 0, timestamp: timestamp, metadata: Data([0x01])).payload
+            return message
+        }
+        append(makeTimedMetadata(2000), chunkStreamId: .timedMetadata, type: .zero)
+        append(RTMPDataMessage(streamId: 0, objectEncoding: .amf0, timestamp: 1000, handlerName: "onCuePoint"), chunkStreamId: .data, type: .zero)
+        // The deltas of the other chunk stream don't move the timed metadata.
+        append(RTMPDataMessage(streamId: 0, objectEncoding: .amf0, timestamp: 500, handlerName: "onCuePoint"), chunkStreamId: .data, type: .one)
+        append(makeTimedMetadata(40), chunkStreamId: .timedMetadata, type: .one)
+        XCTAssertEqual(delegate.metadatas.map { $0.timestamp.seconds }, [2.0, 2.04])
+    }
+}
+
+private final class TimedMetadataDelegate: NetStreamDelegate {
+    private(set) var metadatas: [TimedMetadata] = []
+
+    func stream(_ stream: NetStream, didOutput audio: AVAudioBuffer, when: AVAudioTime) {
+    }
+
+    func stream(_ stream: NetStream, didOutput video: CMSampleBuffer) {
+    }
+
+    func stream(_ stream: NetStream, didOutput metadata: TimedMetadata) {
+        metadatas.append(metadata)
+    }
+
+    #if os(iOS) || os(tvOS)
+    @available(tvOS 17.0, *)
+    func stream(_ stream: NetStream, sessionWasInterrupted session: AVCaptureSession, reason: AVCaptureSession.InterruptionReason?) {
+    }
+
+    @available(tvOS 17.0, *)
+    func stream(_ stream: NetStream, sessionInterruptionEnded session: AVCaptureSession) {
+    }
+    #endif
+
+    func stream(_ stream: NetStream, videoErrorOccurred error: IOVideoUnitError) {
+    }
+
+    func stream(_ stream: NetStream, audioErrorOccurred error: IOAudioUnitError) {
+    }
+
+    func streamDidOpen(_ stream: NetStream) {
+    }
 }
@@ -0,0 +1,79 @@
+import Foundation
+import XCTest
+
+@testable import HaishinKit
+
+final class RTMPTSGatewayTests: XCTestCase {
+    private static let sps: [UInt8] = [0x67, 0x42, 0x00, 0x1e, 0x95, 0xa8, 0x28, 0x0f, 0x64]
+    private static let pps: [UInt8] = [0x68, 0xce, 0x3c, 0x80]
+
+    func testVideoTimestamps() {
+        let output = RTMPTSGatewayOutput()
+        let gateway = RTMPTSGateway(hasAudio: false, hasVideo: true)
+        gateway.delegate = output
+        var seq: [UInt8] = [0x17, 0x00, 0x00, 0x00, 0x00, 0x01, 0x42, 0x00, 0x1e, 0xff, 0xe1, 0x00, UInt8(Self.sps.count)]
+        seq += Self.sps + [0x01, 0x00, UInt8(Self.pps.count)] + Self.pps
+        gateway.append(video: Data(seq), timestamp: 0)
+        // A keyframe at 1000 ms with a composition time offset of 40 ms.
+        gateway.append(video: Data([0x17, 0x01, 0x00, 0x00, 0x28, 0x00, 0x00, 0x00, 0x04, 0x65, 0x88, 0x84, 0x00]), timestamp: 1000)
+        // An inter frame at 1033 ms with a negative composition time offset of -33 ms.
+        gateway.append(video: Data([0x27, 0x01, 0xff, 0xff, 0xdf, 0x00, 0x00, 0x00, 0x03, 0x41, 0x9a, 0x02]), timestamp: 1033)
+        XCTAssertEqual(gateway.frameCount, 2)
+
+        let PESs = output.makePESs(TSWriter.defaultVideoPID)
+        XCTAssertEqual(PESs.count, 2)
+        let fields = PESs.map { $0.optionalPESHeader?.optionalFields ?? Data() }
+        XCTAssertEqual(TSTimestamp.decode(fields[0], offset: 0), Int64(1040 * 90 + RTMPTSGateway.delay))
+        XCTAssertEqual(TSTimestamp.decode(fields[0], offset: TSTimestamp.dataSize), Int64(1000 * 90 + RTMPTSGateway.delay))
+        XCTAssertEqual(TSTimestamp.decode(fields[1], offset: 0), Int64(1000 * 90 + RTMPTSGateway.delay))
+        XCTAssertEqual(TSTimestamp.decode(fields[1], offset: TSTimestamp.dataSize), Int64(1033 * 90 + RTMPTSGateway.delay))
+
+        var keyframe = Data([0x00, 0x00, 0x00, 0x01, 0x09, 0x10, 0x00, 0x00, 0x00, 0x01])
+        keyframe.append(contentsOf: Self.sps)
+        keyframe.append(contentsOf: [0x00, 0x00, 0x00, 0x01])
+        keyframe.append(contentsOf: Self.pps)
+        keyframe.append(contentsOf: [0x00, 0x00, 0x00, 0x01, 0x65, 0x88, 0x84, 0x00])
+        XCTAssertEqual(PESs[0].data, keyframe)
+        XCTAssertEqual(PESs[1].data, Data([0x00, 0x00, 0x00, 0x01, 0x09, 0x30, 0x00, 0x00, 0x00, 0x01, 0x41, 0x9a, 0x02]))
+    }
+
+    func testAudio() {
+        let output = RTMPTSGatewayOutput()
+        let gateway = RTMPTSGateway(hasAudio: true, hasVideo: false)
+        gateway.delegate = output
+        gateway.append(audio: Data([0xaf, 0x01, 0x21, 0x10]), timestamp: 0)
+        XCTAssertEqual(gateway.frameCount, 0)
+        // AAC-LC, 44.1kHz, 2ch.
+        gateway.append(audio: Data([0xaf, 0x00, 0x12, 0x10]), timestamp: 0)
+        gateway.append(audio: Data([0xaf, 0x01, 0x21, 0x10, 0x04]), timestamp: 23)
+        XCTAssertEqual(gateway.frameCount, 1)
+        let PESs = output.makePESs(TSWriter.defaultAudioPID)
+        XCTAssertEqual(PESs.count, 1)
+        XCTAssertEqual(TSTimestamp.decode(PESs[0].optionalPESHeader?.optionalFields ?? Data()), Int64(23 * 90 + RTMPTSGateway.delay))
+        XCTAssertEqual(PESs[0].data.count, ADTSHeader.size + 3)
+        XCTAssertEqual(PESs[0].data.prefix(2), Data([0xff, 0xf9]))
+    }
+}
+
+private final class RTMPTSGatewayOutput: RTMPTSGatewayDelegate {
+    var data = Data()
+
+    func gateway(_ gateway: RTMPTSGateway, didOutput data: Data) {
+        self.data.append(data)
+    }
+
+    func makePESs(_ PID: UInt16) -> [PacketizedElementaryStream] {
+        var PESs: [PacketizedElementaryStream] = []
+        for i in 0..<data.count / TSPacket.size {
+            guard let packet = TSPacket(data: data.subdata(in: i * TSPacket.size..<(i + 1) * TSPacket.size)), packet.pid == PID else {
+                continue
+            }
+            if packet.payloadUnitStartIndicator, let PES = PacketizedElementaryStream(packet.payload) {
+                PESs.append(PES)
+            } else if !PESs.isEmpty {
+                _ = PESs[PESs.count - 1].append(packet.payload)
+            }
+        }
+        return PESs
+    }
+}
@@ -0,0 +1,112 @@
+import Foundation
+import XCTest
+
+@testable import HaishinKit
+
+final class TSRTMPGatewayTests: XCTestCase {
+    func testRead() throws {
+        let data = try makeData()
+        let connection = RTMPConnection()
+        let stream = RTMPStream(connection: connection)
+        let gateway = TSRTMPGateway(stream: stream)
+        gateway.read(data.prefix(TSPacket.size * 1000))
+        gateway.read(data.suffix(from: data.startIndex + TSPacket.size * 1000))
+        stream.executor.queue.sync {}
+        XCTAssertLessThan(0, gateway.frameCount)
+        let processingTime = gateway.processingTime
+        XCTAssertEqual(processingTime.count, 2)
+        XCTAssertEqual(processingTime.counts.reduce(0, +), 2)
+        XCTAssertEqual(processingTime.bounds, TSRTMPGateway.processingTimeBounds)
+        XCTAssertLessThan(0, processingTime.sum)
+        XCTAssertLessThanOrEqual(processingTime.min, processingTime.max)
+        XCTAssertEqual(processingTime.mean, processingTime.sum / 2, accuracy: 0.001)
+        XCTAssertLessThanOrEqual(0, gateway.cpuTime)
+        XCTAssertNotNil(stream.muxer.videoFormat)
+        XCTAssertNotNil(stream.muxer.audioFormat)
+        gateway.clear()
+        XCTAssertEqual(gateway.frameCount, 0)
+        XCTAssertEqual(gateway.processingTime.count, 0)
+        XCTAssertEqual(gateway.processingTime.sum, 0)
+        XCTAssertEqual(gateway.cpuTime, 0)
+    }
+
+    func testReadWhilePublishing() throws {
+        let data = try makeData()
+        let connection = RTMPConnection()
+        let socket = GatewaySocket()
+        connection.socket = socket
+        let stream = RTMPStream(connection: connection)
+        let gateway = TSRTMPGateway(stream: stream)
+        stream.lockQueue.sync {
+            stream.readyState = .publishing(muxer: stream.muxer)
+        }
+        let expectation = XCTestExpectation()
+        DispatchQueue.global().async {
+            var offset = data.startIndex
+            while offset < data.endIndex {
+                let end = min(offset + TSPacket.size * 100, data.endIndex)
+                gateway.read(data[offset..<end])
+                offset = end
+            }
+            expectation.fulfill()
+        }
+        wait(for: [expectation], timeout: 10)
+        stream.executor.queue.sync {}
+        let chunks = socket.chunks
+        let audio = chunks.filter { $0.streamId == RTMPChunk.StreamID.audio.rawValue }
+        let video = chunks.filter { $0.streamId == RTMPChunk.StreamID.video.rawValue }
+        XCTAssertLessThan(1, audio.count)
+        XCTAssertLessThan(1, video.count)
+        XCTAssertLessThanOrEqual(audio.count + video.count, gateway.frameCount + 2)
+        // Sequence headers and frames reach the socket on the executor of the stream only.
+        XCTAssertTrue((audio + video).allSatisfy { $0.isOnExecutor })
+        XCTAssertEqual(stream.executor.metrics.frameCount, gateway.frameCount)
+    }
+
+    private func makeData() throws -> Data {
+        let bundle = Bundle(for: type(of: self))
+        let url = URL(fileURLWithPath: bundle.path(forResource: "SampleVideo_360x240_5mb_2ch", ofType: "ts")!)
+        return try FileHandle(forReadingFrom: url).readDataToEndOfFile().prefix(TSPacket.size * 2000)
+    }
+}
+
+private final class GatewaySocket: RTMPSocketCompatible {
+    struct Chunk {
+        let streamId: UInt16
+        let isOnExecutor: Bool
+    }
+
+    var timeout: Int = NetSocket.defaultTimeout
+    weak var delegate: (any RTMPSocketDelegate)?
+    var connected = true
+    var timestamp: TimeInterval = 0
+    var readyState: RTMPSocketReadyState = .handshakeDone
+    var chunkSizeC: Int = RTMPChunk.defaultSize
+    var chunkSizeS: Int = RTMPChunk.defaultSize
+    var inputBuffer = Data()
+    var outputBufferSize: Int = 0
+    var totalBytesIn: Atomic<Int64> = .init(0)
+    var totalBytesOut: Atomic<Int64> = .init(0)
+    var queueBytesOut: Atomic<Int64> = .init(0)
+    var securityLevel: StreamSocketSecurityLevel = .none
+    var qualityOfService: DispatchQoS = .userInitiated
+    var capture: NetCapture?
+
+    var chunks: [Chunk] {
+        _chunks.value
+    }
+
+    private var _chunks: Atomic<[Chunk]> = .init([])
+
+    func doOutput(chunk: RTMPChunk) -> Int {
+        let chunk = Chunk(streamId: chunk.streamId, isOnExecutor: IOMuxerExecutor.current != nil)
+        _chunks.mutate { $0.append(chunk) }
+        return 0
+    }
+
+    func close(isDisconnected: Bool) {
+    }
+
+    func connect(withName: String, port: Int) {
+    }
+}
@@ -0,0 +1,95 @@
+import Foundation
+import XCTest
+
+@testable import SRTHaishinKit
+
+final class SRTSocketTableTests: XCTestCase {
+    func testRandomOperationsMatchDictionary() {
+        var generator = SeededGenerator(seed: 0x5254_5348)
+        var table = SRTSocketTable<Int>()
+        var dictionary: [Int32: Int] = [:]
+        for step in 0..<100_000 {
+            // A narrow key range makes inserts hit existing keys and long probe sequences.
+            let key = Int32.random(in: 0..<4096, using: &generator)
+            switch Int.random(in: 0..<10, using: &generator) {
+            case 0..<5:
+                table[key] = step
+                dictionary[key] = step
+            case 5..<9:
+                table[key] = nil
+                dictionary[key] = nil
+            default:
+                XCTAssertEqual(table[key], dictionary[key])
+            }
+            XCTAssertEqual(table.count, dictionary.count)
+            XCTAssertLessThan(table.count * 4, table.capacity * 3)
+            if step % 10_000 == 0 {
+                assertEqual(table, dictionary)
+            }
+            if step % 25_000 == 24_999 {
+                table.removeAll()
+                dictionary.removeAll()
+                XCTAssertEqual(table.capacity, SRTSocketTable<Int>.minimumCapacity)
+            }
+        }
+        assertEqual(table, dictionary)
+    }
+
+    func testSparseSocketIds() {
+        var generator = SeededGenerator(seed: 42)
+        var table = SRTSocketTable<Int>()
+        var dictionary: [Int32: Int] = [:]
+        // libsrt counts socket ids down from a random number.
+        let base = Int32.random(in: 0x1000_0000..<0x3fff_ffff, using: &generator)
+        for i in 0..<5000 {
+            table[base - Int32(i)] = i
+            dictionary[base - Int32(i)] = i
+        }
+        for i in stride(from: 0, to: 5000, by: 3) {
+            table[base - Int32(i)] = nil
+            dictionary[base - Int32(i)] = nil
+        }
+        assertEqual(table, dictionary)
+        XCTAssertNil(table[base + 1])
+        XCTAssertNil(table[-1])
+    }
+
+    func testRemoveAllWhere() {
+        var table = SRTSocketTable<Int>()
+        var dictionary: [Int32: Int] = [:]
+        for i in 0..<1000 {
+            table[Int32(i)] = i
+            dictionary[Int32(i)] = i
+        }
+        table.removeAll { _, value in value % 3 == 0 }
+        dictionary = dictionary.filter { $0.value % 3 != 0 }
+        assertEqual(table, dictionary)
+    }
+
+    private func assertEqual(_ table: SRTSocketTable<Int>, _ dictionary: [Int32: Int], file: StaticString = #filePath, line: UInt = #line) {
+        XCTAssertEqual(table.count, dictionary.count, file: file, line: line)
+        for (key, value) in dictionary {
+            XCTAssertEqual(table[key], value, file: file, line: line)
+        }
+        for key in Int32(4096)..<Int32(4196) where dictionary[key] == nil {
+            XCTAssertNil(table[key], file: file, line: line)
+        }
+    }
+}
+
+/// SplitMix64, so that a failure reproduces with the same operations.
+private struct SeededGenerator: RandomNumberGenerator {
+    private var state: UInt64
+
+    init(seed: UInt64) {
+        state = seed
+    }
+
+    mutating func next() -> UInt64 {
+        state &+= 0x9E37_79B9_7F4A_7C15
+        var z = state
+        z = (z ^ (z >> 30)) &* 0xBF58_476D_1CE4_E5B9
+        z = (z ^ (z >> 27)) &* 0x94D0_49BB_1331_11EB
+        return z ^ (z >> 31)
+    }
+}
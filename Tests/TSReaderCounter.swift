@@ -0,0 +1,15 @@
+import CoreMedia
+
+@testable import HaishinKit
+
+/// Counts the sample buffers that a TSReader reads.
+final class TSReaderCounter: TSReaderDelegate {
+    var sampleCount = 0
+
+    func reader(_ reader: TSReader, id: UInt16, didRead formatDescription: CMFormatDescription) {
+    }
+
+    func reader(_ reader: TSReader, id: UInt16, didRead sampleBuffer: CMSampleBuffer) {
+        sampleCount += 1
+    }
+}
@@ -0,0 +1,55 @@
+import Foundation
+import XCTest
+
+@testable import HaishinKit
+
+final class BufferPoolTests: XCTestCase {
+    func testReuse() {
+        let pool = BufferPool()
+        var data: Data? = pool.makeData(count: 300) { pointer in
+            pointer.initializeMemory(as: UInt8.self, repeating: 0xAB)
+        }
+        XCTAssertEqual(data?.count, 300)
+        XCTAssertEqual(data?.allSatisfy { $0 == 0xAB }, true)
+        XCTAssertEqual(pool.metrics.outstandingBytes, 512)
+        data = nil
+        XCTAssertEqual(pool.metrics.outstandingBytes, 0)
+        XCTAssertEqual(pool.metrics.pooledBytes, 512)
+        let other = pool.makeData(count: 400) { pointer in
+            pointer.initializeMemory(as: UInt8.self, repeating: 0xCD)
+        }
+        XCTAssertEqual(other.count, 400)
+        XCTAssertEqual(other.allSatisfy { $0 == 0xCD }, true)
+        XCTAssertEqual(pool.metrics.hitCount, 1)
+        XCTAssertEqual(pool.metrics.missCount, 1)
+        XCTAssertEqual(pool.metrics.hitRate, 0.5)
+        XCTAssertEqual(pool.metrics.pooledBytes, 0)
+    }
+
+    func testMaximumBuffersPerClass() {
+        let pool = BufferPool(maximumBuffersPerClass: 1)
+        var buffers: [Data] = (0..<3).map { _ in pool.makeData(count: 256) { _ in } }
+        XCTAssertEqual(pool.metrics.outstandingBytes, 768)
+        buffers.removeAll()
+        XCTAssertEqual(pool.metrics.outstandingBytes, 0)
+        XCTAssertEqual(pool.metrics.pooledBytes, 256)
+        pool.removeAll()
+        XCTAssertEqual(pool.metrics.pooledBytes, 0)
+    }
+
+    func testMaximumPooledBytes() {
+        let pool = BufferPool(maximumPooledBytes: 1024)
+        var buffers: [Data] = (0..<3).map { _ in pool.makeData(count: 512) { _ in } }
+        buffers.append(pool.makeData(count: BufferPool.maximumSize) { _ in })
+        buffers.removeAll()
+        XCTAssertEqual(pool.metrics.outstandingBytes, 0)
+        XCTAssertEqual(pool.metrics.pooledBytes, 1024)
+    }
+
+    func testSizeClass() {
+        XCTAssertEqual(BufferPool.sizeClass(1), 0)
+        XCTAssertEqual(BufferPool.sizeClass(256), 0)
+        XCTAssertEqual(BufferPool.sizeClass(257), 1)
+        XCTAssertEqual(BufferPool.sizeClass(BufferPool.maximumSize), 14)
+    }
+}
@@ -0,0 +1,46 @@
+import Foundation
+import XCTest
+
+@testable import HaishinKit
+
+final class HistogramTests: XCTestCase {
+    func testRecord() {
+        var histogram = Histogram(bounds: [10, 20, 50])
+        for value in [5.0, 10.0, 15.0, 30.0, 100.0] {
+            histogram.record(value)
+        }
+        XCTAssertEqual(histogram.counts, [2, 1, 1, 1])
+        XCTAssertEqual(histogram.count, 5)
+        XCTAssertEqual(histogram.min, 5)
+        XCTAssertEqual(histogram.max, 100)
+        XCTAssertEqual(histogram.mean, 32)
+    }
+
+    func testPercentile() {
+        var histogram = Histogram(bounds: [10, 20, 50])
+        XCTAssertEqual(histogram.percentile(0.5), 0)
+        for value in 1...100 {
+            histogram.record(Double(value))
+        }
+        XCTAssertEqual(histogram.percentile(0.05), 10)
+        XCTAssertEqual(histogram.percentile(0.5), 50)
+        XCTAssertEqual(histogram.percentile(0.99), 100)
+        histogram.reset()
+        XCTAssertEqual(histogram.count, 0)
+    }
+
+    func testMerge() {
+        var histogram = Histogram(bounds: [10, 20, 50])
+        histogram.record(5)
+        var other = Histogram(bounds: [10, 20, 50])
+        other.record(15)
+        other.record(100)
+        histogram.merge(other)
+        XCTAssertEqual(histogram.counts, [1, 1, 0, 1])
+        XCTAssertEqual(histogram.count, 3)
+        XCTAssertEqual(histogram.min, 5)
+        XCTAssertEqual(histogram.max, 100)
+        histogram.merge(Histogram(bounds: [1]))
+        XCTAssertEqual(histogram.count, 3)
+    }
+}
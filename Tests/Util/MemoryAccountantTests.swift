@@ -0,0 +1,104 @@
+import Foundation
+import XCTest
+
+@testable import HaishinKit
+
+final class MemoryAccountantTests: XCTestCase {
+    func testGauges() {
+        let accountant = MemoryAccountant()
+        let owner = NSObject()
+        let audio = BufferingComponent(1000)
+        let video = BufferingComponent(5000)
+        accountant.register(audio, owner: owner)
+        accountant.register(video, owner: owner)
+        XCTAssertEqual(accountant.bufferedBytes(of: owner), 6000)
+        XCTAssertEqual(accountant.totalBytes, 6000)
+        accountant.unregister(video)
+        XCTAssertEqual(accountant.bufferedBytes(of: owner), 1000)
+    }
+
+    func testReleasedOwnersArePruned() {
+        let accountant = MemoryAccountant()
+        let component = BufferingComponent(1000)
+        for _ in 0..<10 {
+            accountant.register(component, owner: NSObject())
+        }
+        XCTAssertEqual(accountant.count, 1)
+        XCTAssertEqual(accountant.totalBytes, 1000)
+    }
+
+    func testShedding() {
+        let accountant = MemoryAccountant()
+        accountant.policy = .init(sheddingThreshold: 1000, disconnectionThreshold: 10000)
+        let worst = BufferingComponent(800)
+        let middle = BufferingComponent(500)
+        let best = BufferingComponent(100)
+        for component in [worst, middle, best] {
+            accountant.register(component, owner: component)
+        }
+        // The excess of 400 bytes is covered by the worst owner alone.
+        XCTAssertEqual(accountant.evaluate(), [.dropNonReferenceFrames(owner: ObjectIdentifier(worst))])
+        XCTAssertTrue(worst.dropsNonReferenceFrames)
+        XCTAssertFalse(middle.dropsNonReferenceFrames)
+        XCTAssertFalse(best.dropsNonReferenceFrames)
+        worst.bufferedBytes = 100
+        XCTAssertEqual(accountant.evaluate(), [])
+        XCTAssertFalse(worst.dropsNonReferenceFrames)
+    }
+
+    func testDisconnection() {
+        let accountant = MemoryAccountant()
+        accountant.policy = .init(sheddingThreshold: 1000, disconnectionThreshold: 2000)
+        let worst = BufferingComponent(1500)
+        let middle = BufferingComponent(1000)
+        let best = BufferingComponent(100)
+        for component in [worst, middle, best] {
+            accountant.register(component, owner: component)
+        }
+        let actions = accountant.evaluate()
+        XCTAssertTrue(actions.contains(.disconnect(owner: ObjectIdentifier(worst))))
+        XCTAssertFalse(actions.contains(.disconnect(owner: ObjectIdentifier(middle))))
+        XCTAssertTrue(worst.isDisconnected)
+        XCTAssertFalse(middle.isDisconnected)
+        XCTAssertTrue(middle.dropsNonReferenceFrames)
+        XCTAssertEqual(accountant.disconnectionCount, 1)
+    }
+
+    func testDisconnectionSkipsOwnersThatCannotDisconnect() {
+        let accountant = MemoryAccountant()
+        accountant.policy = .init(sheddingThreshold: 1000, disconnectionThreshold: 2000)
+        let worst = BufferingComponent(1500, isDisconnectable: false)
+        let middle = BufferingComponent(1000)
+        let best = BufferingComponent(100)
+        for component in [worst, middle, best] {
+            accountant.register(component, owner: component)
+        }
+        let actions = accountant.evaluate()
+        XCTAssertFalse(actions.contains(.disconnect(owner: ObjectIdentifier(worst))))
+        XCTAssertTrue(actions.contains(.disconnect(owner: ObjectIdentifier(middle))))
+        XCTAssertFalse(actions.contains(.disconnect(owner: ObjectIdentifier(best))))
+        XCTAssertTrue(middle.isDisconnected)
+        XCTAssertEqual(accountant.disconnectionCount, 1)
+    }
+
+    func testBaseStreamIsNotDisconnectable() {
+        XCTAssertFalse(NetStream().disconnect())
+    }
+}
+
+private final class BufferingComponent: MemoryAccountable {
+    var bufferedBytes: Int
+    var dropsNonReferenceFrames = false
+    private(set) var isDisconnected = false
+    private let isDisconnectable: Bool
+
+    init(_ bufferedBytes: Int, isDisconnectable: Bool = true) {
+        self.bufferedBytes = bufferedBytes
+        self.isDisconnectable = isDisconnectable
+    }
+
+    func disconnect() -> Bool {
+        isDisconnected = isDisconnectable
+        return isDisconnectable
+    }
+}
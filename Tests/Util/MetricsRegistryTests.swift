@@ -0,0 +1,129 @@
+import Foundation
+import XCTest
+
+@testable import HaishinKit
+
+final class MetricsRegistryTests: XCTestCase {
+    func testExposition() {
+        let registry = MetricsRegistry()
+        var latency = Histogram(bounds: [1, 10])
+        latency.record(0.5)
+        latency.record(5)
+        latency.record(50)
+        let component = ReportingComponent(["stream": "camera\"1\""], bytes: 1024, latency: latency)
+        registry.register(component)
+        XCTAssertEqual(registry.exposition(), """
+        # HELP test_bytes_total The bytes.
+        # TYPE test_bytes_total counter
+        test_bytes_total{stream="camera\\"1\\""} 1024
+        # HELP test_rtt_seconds The round trip time.
+        # TYPE test_rtt_seconds gauge
+        test_rtt_seconds{stream="camera\\"1\\""} 0.025
+        # HELP test_latency_seconds The latency.
+        # TYPE test_latency_seconds histogram
+        test_latency_seconds_bucket{stream="camera\\"1\\"",le="0.001"} 1
+        test_latency_seconds_bucket{stream="camera\\"1\\"",le="0.01"} 2
+        test_latency_seconds_bucket{stream="camera\\"1\\"",le="+Inf"} 3
+        test_latency_seconds_sum{stream="camera\\"1\\""} 0.0555
+        test_latency_seconds_count{stream="camera\\"1\\""} 3
+        # HELP haishinkit_metrics_dropped_series The number of series dropped by the cardinality limit in the last collection.
+        # TYPE haishinkit_metrics_dropped_series gauge
+        haishinkit_metrics_dropped_series 0
+
+        """)
+    }
+
+    func testReleasedComponentsAreUnregistered() {
+        let registry = MetricsRegistry()
+        var component: ReportingComponent? = ReportingComponent(["stream": "a"], bytes: 1)
+        registry.register(component!)
+        registry.register(component!)
+        XCTAssertEqual(registry.count, 1)
+        component = nil
+        XCTAssertEqual(registry.count, 0)
+        XCTAssertNil(registry.collect().value("test_bytes_total", labels: ["stream": "a"]))
+    }
+
+    func testCardinalityLimit() {
+        let registry = MetricsRegistry()
+        registry.policy = .init(maximumSeriesCount: 100)
+        let components = (0..<300).map { ReportingComponent(["stream": "\($0)"], bytes: 1) }
+        for component in components {
+            registry.register(component)
+        }
+        let collector = registry.collect()
+        XCTAssertEqual(collector.value("test_bytes_total", labels: ["stream": "99"]), 1)
+        XCTAssertNil(collector.value("test_bytes_total", labels: ["stream": "100"]))
+        // The counter, the gauge and the histogram drop 200 series each.
+        XCTAssertEqual(collector.droppedSeriesCount, 600)
+        XCTAssertEqual(collector.value("haishinkit_metrics_dropped_series"), 600)
+    }
+
+    func testDroppedLabelsAddUpSeries() {
+        let registry = MetricsRegistry()
+        registry.policy = .init(droppedLabels: ["stream"])
+        var latency = Histogram(bounds: [1, 10])
+        latency.record(5)
+        let components = (0..<300).map { ReportingComponent(["stream": "\($0)", "region": "tokyo"], bytes: 2, latency: latency) }
+        for component in components {
+            registry.register(component)
+        }
+        let collector = registry.collect()
+        XCTAssertEqual(collector.value("test_bytes_total", labels: ["region": "tokyo"]), 600)
+        XCTAssertEqual(collector.droppedSeriesCount, 0)
+        XCTAssertTrue(collector.exposition.contains("test_latency_seconds_count{region=\"tokyo\"} 300\n"))
+    }
+
+    func testHTTPService() {
+        let registry = MetricsRegistry()
+        let component = ReportingComponent([:], bytes: 7)
+        registry.register(component)
+        let service = MetricsHTTPService(registry: registry)
+        XCTAssertEqual(service.address, "127.0.0.1")
+
+        let response = String(decoding: service.makeResponse("GET /metrics?name=test HTTP/1.1\r\nHost: localhost"), as: UTF8.self)
+        XCTAssertTrue(response.hasPrefix("HTTP/1.1 200 OK\r\nContent-Type: \(MetricsCollector.contentType)\r\n"))
+        XCTAssertTrue(response.hasSuffix("\r\n\r\n" + registry.exposition()))
+        XCTAssertTrue(response.contains("test_bytes_total 7\n"))
+
+        let head = String(decoding: service.makeResponse("HEAD /metrics HTTP/1.1"), as: UTF8.self)
+        XCTAssertTrue(head.hasPrefix("HTTP/1.1 200 OK\r\n"))
+        XCTAssertTrue(head.hasSuffix("\r\n\r\n"))
+        XCTAssertFalse(head.contains("Content-Length: 0\r\n"))
+
+        XCTAssertTrue(String(decoding: service.makeResponse("GET / HTTP/1.1"), as: UTF8.self).hasPrefix("HTTP/1.1 404 Not Found\r\n"))
+        XCTAssertTrue(String(decoding: service.makeResponse("POST /metrics HTTP/1.1"), as: UTF8.self).hasPrefix("HTTP/1.1 405 Method Not Allowed\r\n"))
+        XCTAssertTrue(String(decoding: service.makeResponse("garbage"), as: UTF8.self).hasPrefix("HTTP/1.1 400 Bad Request\r\n"))
+    }
+
+    func testStreamsAndConnectionsReport() {
+        let connection = RTMPConnection()
+        connection.metricsLabels = ["connection": "test"]
+        let stream = RTMPStream(connection: connection)
+        stream.metricsLabels = ["stream": "test"]
+        let collector = MetricsRegistry.shared.collect()
+        XCTAssertEqual(collector.value("haishinkit_rtmp_connection_connected", labels: ["connection": "test"]), 0)
+        XCTAssertEqual(collector.value("haishinkit_rtmp_connection_streams", labels: ["connection": "test"]), 1)
+        XCTAssertEqual(collector.value("haishinkit_stream_dropped_frames_total", labels: ["stream": "test"]), 0)
+        XCTAssertEqual(collector.value("haishinkit_rtmp_stream_bytes_total", labels: ["stream": "test"]), 0)
+        XCTAssertTrue(collector.names.contains("haishinkit_stream_encode_latency_seconds"))
+    }
+}
+
+private final class ReportingComponent: MetricsCollectable {
+    let labels: [String: String]
+    let bytes: Double
+    let latency: Histogram
+
+    init(_ labels: [String: String], bytes: Double, latency: Histogram = .init(bounds: [1, 10])) {
+        self.labels = labels
+        self.bytes = bytes
+        self.latency = latency
+    }
+
+    func collect(_ collector: MetricsCollector) {
+        collector.counter("test_bytes_total", help: "The bytes.", value: bytes, labels: labels)
+        collector.gauge("test_rtt_seconds", help: "The round trip time.", value: 0.025, labels: labels)
+        collector.histogram("test_latency_seconds", help: "The latency.", histogram: latency, scale: 0.001, labels: labels)
+    }
+}